@@ -0,0 +1,262 @@
+#include "include/Benchmark.h"
+
+
+//The benchmark driver is a C++ only tool.
+#ifdef STANDALONE
+
+
+#include <random>
+#include <chrono>
+#include <fstream>
+
+
+#ifdef _OPENMP
+//#ifndef __APPLE__
+#include <omp.h>
+#endif
+
+
+
+
+//----------------------------------------------//
+//---------- Synthetic Genome Functions ---------//
+//----------------------------------------------//
+
+
+/* simulateBenchmarkGenome (NOT EXPOSED)
+ * Arguments: genome to fill, number of genes, number of codons per gene, if RFP counts should be generated, if the
+ * counts should be stored positionally (PANSE) instead of PA style, seed for the random number generator
+ * Fills the genome with genes made of uniformly drawn sense codons. Every gene gets an expression level drawn from a
+ * log normal distribution which scales its RFP counts, so the counts vary between genes like in real data.
+ * The generator is independent of Parameter::generator, the same seed always gives the same genome.
+*/
+void simulateBenchmarkGenome(Genome& genome, unsigned numGenes, unsigned codonsPerGene, bool withRFPCounts,
+	bool positional, unsigned seed)
+{
+	std::mt19937 generator(seed);
+	std::uniform_int_distribution<unsigned> codonDistribution(0u, 60u); //sense codons only
+	std::lognormal_distribution<double> phiDistribution(-0.5, 1.0);
+
+	genome.clear();
+	if (withRFPCounts)
+		genome.addRFPCountColumnName("benchmark");
+
+	for (unsigned i = 0u; i < numGenes; i++)
+	{
+		Gene gene;
+		std::ostringstream oss;
+		oss << "benchmark_gene_" << i;
+		gene.setId(oss.str());
+		gene.setDescription("Synthetic benchmark gene");
+
+		if (withRFPCounts)
+		{
+			std::poisson_distribution<int> rfpDistribution(phiDistribution(generator));
+			std::vector <std::vector <int>> table(codonsPerGene, std::vector <int>(3, 0));
+			for (unsigned j = 0u; j < codonsPerGene; j++)
+			{
+				table[j][0] = (int)j;
+				table[j][1] = (int)codonDistribution(generator);
+				table[j][2] = rfpDistribution(generator);
+			}
+			if (positional)
+				gene.setPANSESequence(table);
+			else
+				gene.setPASequence(table);
+		}
+		else
+		{
+			std::string seq = "ATG";
+			for (unsigned j = 1u; j < codonsPerGene; j++)
+				seq += SequenceSummary::codonArray[codonDistribution(generator)];
+			gene.setSequence(seq);
+		}
+		genome.addGene(gene, false);
+	}
+}
+
+
+
+
+
+//------------------------------------------//
+//---------- Benchmark Functions -----------//
+//------------------------------------------//
+
+
+/* runBenchmarkChain (NOT EXPOSED)
+ * Arguments: MCMC object, genome and model to run on, number of threads
+ * Runs the chain and returns the wall time in seconds.
+*/
+static double runBenchmarkChain(MCMCAlgorithm& mcmc, Genome& genome, Model& model, unsigned numThreads)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	mcmc.run(genome, model, numThreads, 0u);
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count();
+}
+
+
+/* benchmarkModel (NOT EXPOSED)
+ * Arguments: model name (ROC, FONSE, PA or PANSE), genome matching the model (see simulateBenchmarkGenome), number of
+ * threads, number of iterations, seed for Parameter::generator
+ * Sets up a single mixture model with default initial values, runs the given number of iterations estimating all
+ * parameters and returns the time per iteration and the time spent in each phase of an iteration.
+ * The adaptive width is set beyond the last iteration, so no adaptation (and no Geweke test) takes place and the
+ * chains for different thread counts do the same work. ROC, FONSE and PA run with the log likelihood cache (see
+ * Model::setLogLikelihoodCacheMode).
+*/
+BenchmarkResult benchmarkModel(std::string modelName, Genome& genome, unsigned numThreads, unsigned iterations,
+	unsigned seed)
+{
+	BenchmarkResult result;
+	result.modelName = modelName;
+	result.numGenes = genome.getGenomeSize();
+	result.codonsPerGene = 0u;
+	result.numThreads = numThreads;
+	result.iterations = iterations;
+	result.secondsPerIteration = 0.0;
+	result.genesPerSecond = 0.0;
+
+	unsigned numMixtures = 1u;
+	std::vector<double> stdDevSynthesisRate(numMixtures, 1.0);
+	std::vector<unsigned> geneAssignment(genome.getGenomeSize(), 0u);
+	std::vector<std::vector<unsigned>> mixtureDefinitionMatrix;
+
+	MCMCAlgorithm mcmc(iterations, 1u, iterations + 1u, true, true, true);
+	mcmc.setProfiling(true);
+	Parameter::generator.seed(seed);
+
+	double seconds;
+	if (modelName == "ROC")
+	{
+		ROCParameter parameter(stdDevSynthesisRate, numMixtures, geneAssignment, mixtureDefinitionMatrix, true, "allUnique");
+		parameter.InitializeSynthesisRate(genome, stdDevSynthesisRate[0]);
+		ROCModel model(false);
+		model.setParameter(parameter);
+		model.setLogLikelihoodCacheMode(true);
+		seconds = runBenchmarkChain(mcmc, genome, model, numThreads);
+	}
+	else if (modelName == "FONSE")
+	{
+		FONSEParameter parameter(stdDevSynthesisRate, numMixtures, geneAssignment, mixtureDefinitionMatrix, true, "allUnique");
+		parameter.InitializeSynthesisRate(genome, stdDevSynthesisRate[0]);
+		FONSEModel model;
+		model.setParameter(parameter);
+		model.setLogLikelihoodCacheMode(true);
+		seconds = runBenchmarkChain(mcmc, genome, model, numThreads);
+	}
+	else if (modelName == "PA")
+	{
+		PAParameter parameter(stdDevSynthesisRate, numMixtures, geneAssignment, mixtureDefinitionMatrix, true, "allUnique");
+		parameter.InitializeSynthesisRate(genome, stdDevSynthesisRate[0]);
+		PAModel model(1u);
+		model.setParameter(parameter);
+		model.setLogLikelihoodCacheMode(true);
+		seconds = runBenchmarkChain(mcmc, genome, model, numThreads);
+	}
+	else if (modelName == "PANSE")
+	{
+		PANSEParameter parameter(stdDevSynthesisRate, numMixtures, geneAssignment, mixtureDefinitionMatrix, true, "allUnique");
+		parameter.InitializeSynthesisRate(genome, stdDevSynthesisRate[0]);
+		PANSEModel model(1u);
+		model.setParameter(parameter);
+		seconds = runBenchmarkChain(mcmc, genome, model, numThreads);
+	}
+	else
+	{
+		my_printError("ERROR: Unknown benchmark model %. Use ROC, FONSE, PA or PANSE.\n", modelName);
+		return result;
+	}
+
+	result.secondsPerIteration = seconds / iterations;
+	result.genesPerSecond = (double)result.numGenes / result.secondsPerIteration;
+	result.phaseSecondsPerIteration = mcmc.getProfileTimes();
+	for (unsigned i = 0u; i < result.phaseSecondsPerIteration.size(); i++)
+		result.phaseSecondsPerIteration[i] /= iterations;
+	return result;
+}
+
+
+/* runBenchmarks (NOT EXPOSED)
+ * Arguments: model names, genome sizes (number of genes), gene lengths (number of codons per gene), maximum number of
+ * threads, number of iterations per run, file to write the results to as CSV (empty string to skip)
+ * Benchmarks every model on a synthetic genome of every size and gene length with 1, 2, 4, ... up to maxThreads
+ * threads (maxThreads itself is always included). The same genome and seed are used for all thread counts of a
+ * model, size and gene length. Long genes mainly stress the positional likelihoods of FONSE and PANSE.
+ * Returns 1 if a model name was not recognized, 0 otherwise.
+*/
+int runBenchmarks(std::vector<std::string> modelNames, std::vector<unsigned> genomeSizes,
+	std::vector<unsigned> geneLengths, unsigned maxThreads, unsigned iterations, std::string outputFile)
+{
+	const unsigned seed = 446141u;
+	int error = 0;
+
+	std::vector<unsigned> threadCounts;
+	for (unsigned numThreads = 1u; numThreads < maxThreads; numThreads *= 2u)
+		threadCounts.push_back(numThreads);
+	threadCounts.push_back(maxThreads < 1u ? 1u : maxThreads);
+
+	std::vector<BenchmarkResult> results;
+	for (unsigned m = 0u; m < modelNames.size(); m++)
+	{
+		bool withRFPCounts = (modelNames[m] == "PA" || modelNames[m] == "PANSE");
+		bool positional = (modelNames[m] == "PANSE");
+		for (unsigned g = 0u; g < genomeSizes.size(); g++)
+		{
+			for (unsigned l = 0u; l < geneLengths.size(); l++)
+			{
+				Genome genome;
+				simulateBenchmarkGenome(genome, genomeSizes[g], geneLengths[l], withRFPCounts, positional, seed + g);
+				for (unsigned t = 0u; t < threadCounts.size(); t++)
+				{
+					BenchmarkResult result = benchmarkModel(modelNames[m], genome, threadCounts[t], iterations, seed);
+					if (result.phaseSecondsPerIteration.empty())
+					{
+						error = 1;
+						break;
+					}
+					result.codonsPerGene = geneLengths[l];
+					results.push_back(result);
+				}
+			}
+		}
+	}
+
+	MCMCAlgorithm names;
+	std::vector<std::string> phaseNames = names.getProfilePhaseNames();
+
+	my_print("\nmodel genes codons/gene threads sec/iteration genes/sec\n");
+	for (unsigned i = 0u; i < results.size(); i++)
+	{
+		my_print("% % % % % %\n", results[i].modelName, results[i].numGenes, results[i].codonsPerGene,
+			results[i].numThreads, results[i].secondsPerIteration, results[i].genesPerSecond);
+	}
+
+	if (!outputFile.empty())
+	{
+		std::ofstream out(outputFile.c_str());
+		if (!out)
+		{
+			my_printError("ERROR: Could not open file % to write the benchmark results\n", outputFile);
+			return 1;
+		}
+		out << "model,genes,codons_per_gene,threads,iterations,seconds_per_iteration,genes_per_second";
+		for (unsigned i = 0u; i < phaseNames.size(); i++)
+			out << "," << phaseNames[i];
+		out << "\n";
+		for (unsigned i = 0u; i < results.size(); i++)
+		{
+			out << results[i].modelName << "," << results[i].numGenes << "," << results[i].codonsPerGene << ","
+				<< results[i].numThreads << "," << results[i].iterations << "," << results[i].secondsPerIteration << ","
+				<< results[i].genesPerSecond;
+			for (unsigned j = 0u; j < results[i].phaseSecondsPerIteration.size(); j++)
+				out << "," << results[i].phaseSecondsPerIteration[j];
+			out << "\n";
+		}
+		out.close();
+	}
+	return error;
+}
+
+#endif // STANDALONE
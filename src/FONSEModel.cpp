@@ -9,6 +9,7 @@
 FONSEModel::FONSEModel() : Model()
 {
 	parameter = 0;
+	positionBucketWidth = 0u;
 }
 
 
@@ -19,38 +20,190 @@ FONSEModel::~FONSEModel()
 }
 
 
-double FONSEModel::calculateLogLikelihoodRatioPerAA(Gene& gene, std::string grouping, double *mutation, double *selection, double phiValue)
+/* calculateLogCodonProbabilityCoefficients (NOT EXPOSED)
+ * Arguments: number of codons of the AA, mutation and selection parameters, arrays receiving offset, slope and
+ * whether the codon enters the denominator, reference to the initial value of the denominator.
+ * Splits calculateLogCodonProbabilityVector into its position and phi independent parts: before normalisation,
+ * log(codonProb[i]) = offset[i] - slope[i] * phi * (4 + 4 * position), and the denominator is
+ * initialDenominator + sum of exp(log(codonProb[i])) over the codons with inDenominator[i].
+ * The reference codon choice only depends on the selection parameters and is resolved here.
+*/
+void FONSEModel::calculateLogCodonProbabilityCoefficients(unsigned numCodons, double *mutation, double *selection,
+	double offset[], double slope[], bool inDenominator[], double &initialDenominator)
 {
-	unsigned numCodons = SequenceSummary::GetNumCodonsForAA(grouping);
-	double logLikelihood = 0.0;
-
-	std::vector <unsigned> *positions;
-	std::vector <double> codonProb(6, 0);
-
-	//Find the maximum index
 	unsigned minIndexVal = 0u;
-	for (unsigned i = 1; i < (numCodons - 1); i++)
+	for (unsigned i = 1u; i < (numCodons - 1); i++)
 	{
 		if (selection[minIndexVal] > selection[i])
-		{
 			minIndexVal = i;
+	}
+	if (selection[minIndexVal] < 0.0)
+	{
+		initialDenominator = 0.0;
+		for (unsigned i = 0u; i < (numCodons - 1); i++)
+		{
+			offset[i] = -(mutation[i] - mutation[minIndexVal]);
+			slope[i] = selection[i] - selection[minIndexVal];
+			inDenominator[i] = true;
+		}
+		offset[numCodons - 1] = mutation[minIndexVal];
+		slope[numCodons - 1] = -selection[minIndexVal];
+		inDenominator[numCodons - 1] = true;
+	}
+	else
+	{
+		initialDenominator = 1.0;
+		for (unsigned i = 0u; i < (numCodons - 1); i++)
+		{
+			offset[i] = -mutation[i];
+			slope[i] = selection[i];
+			inDenominator[i] = true;
 		}
+		// reference codon, exp(0) is already in the initial denominator
+		offset[numCodons - 1] = 0.0;
+		slope[numCodons - 1] = 0.0;
+		inDenominator[numCodons - 1] = false;
 	}
+}
 
-	unsigned aaStart, aaEnd;
-	SequenceSummary::AAToCodonRange(grouping, aaStart, aaEnd, false);
-	for (unsigned i = aaStart, k = 0; i < aaEnd; i++, k++)
+
+/* calculateLogLikelihoodPerAAPerGene (NOT EXPOSED)
+ * Arguments: gene, index of the first codon of the AA, number of codons of the AA, coefficients of the AA (see
+ * calculateLogCodonProbabilityCoefficients), phi value of the gene
+ * Calculates the log likelihood of the codons of one AA in a gene. The positions of a codon are evaluated in batches
+ * of up to positionBatchSize, codon by codon, so the loops over the positions run without branches and can be
+ * vectorised. The arithmetic is done in the same order as in calculateLogCodonProbabilityVector, so results are
+ * identical to evaluating one position at a time.
+*/
+double FONSEModel::calculateLogLikelihoodPerAAPerGene(Gene& gene, unsigned aaStart, unsigned numCodons,
+	const double offset[], const double slope[], const bool inDenominator[], double initialDenominator, double phiValue)
+{
+	double logLikelihood = 0.0;
+	double positionPhi[positionBatchSize];
+	double denominator[positionBatchSize];
+
+	for (unsigned k = 0u; k < numCodons; k++)
+	{
+		std::vector <unsigned> *positions = gene.geneData.getCodonPositions(aaStart + k);
+		unsigned numPositions = (unsigned)positions->size();
+		for (unsigned batchStart = 0u; batchStart < numPositions; batchStart += positionBatchSize)
+		{
+			unsigned batchSize = numPositions - batchStart;
+			if (batchSize > positionBatchSize) batchSize = positionBatchSize;
+			const unsigned *batchPositions = positions->data() + batchStart;
+#if defined(_OPENMP) && _OPENMP >= 201307
+#pragma omp simd
+#endif
+			for (unsigned j = 0u; j < batchSize; j++)
+			{
+				positionPhi[j] = phiValue * (4.0 + (4.0 * batchPositions[j]));
+				denominator[j] = initialDenominator;
+			}
+			for (unsigned i = 0u; i < numCodons; i++)
+			{
+				if (!inDenominator[i]) continue;
+				double codonOffset = offset[i];
+				double codonSlope = slope[i];
+#if defined(_OPENMP) && _OPENMP >= 201307
+#pragma omp simd
+#endif
+				for (unsigned j = 0u; j < batchSize; j++)
+					denominator[j] += std::exp(codonOffset - (positionPhi[j] * codonSlope));
+			}
+			for (unsigned j = 0u; j < batchSize; j++)
+				logLikelihood += (offset[k] - (positionPhi[j] * slope[k])) - std::log(denominator[j]);
+		}
+	}
+	return logLikelihood;
+}
+
+
+/* calculateLogLikelihoodPerAAPerGeneFromBuckets (NOT EXPOSED)
+ * Arguments: index of the gene, index of the first codon of the AA, number of codons of the AA, coefficients of the AA
+ * (see calculateLogCodonProbabilityCoefficients), phi value of the gene
+ * Same as calculateLogLikelihoodPerAAPerGene, but evaluates the codon probabilities once per position bucket (see
+ * setPositionBucketMode), at the mean position of the bucket, and weights them with the number of positions in it.
+ * The numerator of the codon probability is linear in the position and therefore exact, only the log denominator is
+ * approximated. The gene must have position buckets, see hasPositionBuckets.
+*/
+double FONSEModel::calculateLogLikelihoodPerAAPerGeneFromBuckets(unsigned geneIndex, unsigned aaStart,
+	unsigned numCodons, const double offset[], const double slope[], const bool inDenominator[],
+	double initialDenominator, double phiValue)
+{
+	double logLikelihood = 0.0;
+	double positionPhi[positionBatchSize];
+	double denominator[positionBatchSize];
+
+	for (unsigned k = 0u; k < numCodons; k++)
 	{
-		positions = gene.geneData.getCodonPositions(i);
-		for (unsigned j = 0; j < positions->size(); j++)
+		unsigned pair = geneIndex * numCodonsTotal + aaStart + k;
+		unsigned firstBucket = positionBucketStart[pair];
+		unsigned numBuckets = positionBucketStart[pair + 1] - firstBucket;
+		for (unsigned batchStart = 0u; batchStart < numBuckets; batchStart += positionBatchSize)
 		{
-			calculateLogCodonProbabilityVector(numCodons, positions->at(j), minIndexVal, mutation, selection, phiValue, codonProb);
-			if (codonProb[k] == 0) continue;
-			logLikelihood += codonProb[k];
+			unsigned batchSize = numBuckets - batchStart;
+			if (batchSize > positionBatchSize) batchSize = positionBatchSize;
+			const double *batchCount = positionBucketCount.data() + firstBucket + batchStart;
+			const double *batchMeanPosition = positionBucketMeanPosition.data() + firstBucket + batchStart;
+#if defined(_OPENMP) && _OPENMP >= 201307
+#pragma omp simd
+#endif
+			for (unsigned j = 0u; j < batchSize; j++)
+			{
+				positionPhi[j] = phiValue * (4.0 + (4.0 * batchMeanPosition[j]));
+				denominator[j] = initialDenominator;
+			}
+			for (unsigned i = 0u; i < numCodons; i++)
+			{
+				if (!inDenominator[i]) continue;
+				double codonOffset = offset[i];
+				double codonSlope = slope[i];
+#if defined(_OPENMP) && _OPENMP >= 201307
+#pragma omp simd
+#endif
+				for (unsigned j = 0u; j < batchSize; j++)
+					denominator[j] += std::exp(codonOffset - (positionPhi[j] * codonSlope));
+			}
+			for (unsigned j = 0u; j < batchSize; j++)
+				logLikelihood += batchCount[j] * ((offset[k] - (positionPhi[j] * slope[k])) - std::log(denominator[j]));
 		}
-		//positions->clear();
 	}
- 	return logLikelihood;
+	return logLikelihood;
+}
+
+
+/* calculatePositionBucketErrorBoundPerAAPerGene (NOT EXPOSED)
+ * Arguments: index of the gene, index of the first codon of the AA, number of codons of the AA, slopes of the AA (see
+ * calculateLogCodonProbabilityCoefficients), phi value of the gene
+ * Returns an upper bound for calculateLogLikelihoodPerAAPerGeneFromBuckets - calculateLogLikelihoodPerAAPerGene.
+ * The log denominator is convex in x = phi * (4 + 4 * position) with a second derivative of at most
+ * (max slope - min slope)^2 / 4, so pooling the positions of a bucket at their mean overestimates the log likelihood
+ * by at most 2 * phi^2 * (max slope - min slope)^2 * (sum of squared distances of the positions to their bucket mean).
+*/
+double FONSEModel::calculatePositionBucketErrorBoundPerAAPerGene(unsigned geneIndex, unsigned aaStart,
+	unsigned numCodons, const double slope[], double phiValue)
+{
+	double minSlope = slope[0];
+	double maxSlope = slope[0];
+	double squaredDeviation = 0.0;
+	for (unsigned k = 0u; k < numCodons; k++)
+	{
+		if (slope[k] < minSlope) minSlope = slope[k];
+		if (slope[k] > maxSlope) maxSlope = slope[k];
+		squaredDeviation += positionBucketSquaredDeviation[geneIndex * numCodonsTotal + aaStart + k];
+	}
+	double slopeRange = maxSlope - minSlope;
+	return 2.0 * phiValue * phiValue * slopeRange * slopeRange * squaredDeviation;
+}
+
+
+/* hasPositionBuckets (NOT EXPOSED)
+ * Arguments: index of the gene
+ * Returns true if the position bucket mode is on and the buckets of the gene were built by setPositionBucketMode.
+*/
+bool FONSEModel::hasPositionBuckets(unsigned geneIndex)
+{
+	return positionBucketWidth > 0u && (geneIndex + 1u) * numCodonsTotal < positionBucketStart.size();
 }
 
 
@@ -88,7 +241,6 @@ void FONSEModel::calculateLogLikelihoodRatioPerGene(Gene& gene, unsigned geneInd
 	double likelihood = 0.0;
 	double likelihood_proposed = 0.0;
 	std::string curAA;
-	std::vector <unsigned> positions;
 	double mutation[5];
 	double selection[5];
 
@@ -103,21 +255,62 @@ void FONSEModel::calculateLogLikelihoodRatioPerGene(Gene& gene, unsigned geneInd
 	double phiValue_proposed = parameter->getSynthesisRate(geneIndex, expressionCategory, true);
 
 
+	bool useCache = useLogLikelihoodCache && logLikelihoodCache.hasEntry(geneIndex, k);
+	bool useBuckets = hasPositionBuckets(geneIndex);
+	if (useCache)
+	{
+		logLikelihoodCache.setCurrentPhi(geneIndex, k, phiValue);
+		logLikelihoodCache.setProposedPhi(geneIndex, k, phiValue_proposed);
+	}
+
 	/* TODO: This loop causes a compiler warning because i is an int, but openMP won't compile if I change i to unsigned.
 		Maybe worth looking into? */
 #ifdef _OPENMP
 //#ifndef __APPLE__
-#pragma omp parallel for private(mutation, selection, positions, curAA) reduction(+:likelihood,likelihood_proposed)
+#pragma omp parallel for private(mutation, selection, curAA) reduction(+:likelihood,likelihood_proposed)
 #endif
 	for (unsigned i = 0u; i < getGroupListSize(); i++)
 	{
 		curAA = getGrouping(i);
+		unsigned numCodons = SequenceSummary::GetNumCodonsForAA(curAA);
+		unsigned aaStart, aaEnd;
+		SequenceSummary::AAToCodonRange(curAA, aaStart, aaEnd, false);
 
 		parameter->getParameterForCategory(mutationCategory, FONSEParameter::dM, curAA, false, mutation);
 		parameter->getParameterForCategory(selectionCategory, FONSEParameter::dOmega, curAA, false, selection);
 
-		likelihood += calculateLogLikelihoodRatioPerAA(gene, curAA, mutation, selection, phiValue);
-		likelihood_proposed += calculateLogLikelihoodRatioPerAA(gene, curAA, mutation, selection, phiValue_proposed);
+		// the coefficients do not depend on phi, they are shared by the current and the proposed value
+		double offset[6];
+		double slope[6];
+		bool inDenominator[6];
+		double initialDenominator;
+		calculateLogCodonProbabilityCoefficients(numCodons, mutation, selection, offset, slope, inDenominator,
+			initialDenominator);
+
+		double currentLikelihood;
+		if (!useCache || !logLikelihoodCache.getCurrent(geneIndex, k, i, currentLikelihood))
+		{
+			if (useBuckets)
+				currentLikelihood = calculateLogLikelihoodPerAAPerGeneFromBuckets(geneIndex, aaStart, numCodons, offset,
+					slope, inDenominator, initialDenominator, phiValue);
+			else
+				currentLikelihood = calculateLogLikelihoodPerAAPerGene(gene, aaStart, numCodons, offset, slope,
+					inDenominator, initialDenominator, phiValue);
+			if (useCache)
+				logLikelihoodCache.setCurrent(geneIndex, k, i, currentLikelihood);
+		}
+		double proposedLikelihood;
+		if (useBuckets)
+			proposedLikelihood = calculateLogLikelihoodPerAAPerGeneFromBuckets(geneIndex, aaStart, numCodons, offset,
+				slope, inDenominator, initialDenominator, phiValue_proposed);
+		else
+			proposedLikelihood = calculateLogLikelihoodPerAAPerGene(gene, aaStart, numCodons, offset, slope,
+				inDenominator, initialDenominator, phiValue_proposed);
+		if (useCache)
+			logLikelihoodCache.setProposed(geneIndex, k, i, proposedLikelihood);
+
+		likelihood += currentLikelihood;
+		likelihood_proposed += proposedLikelihood;
 	}
 
 	//my_print("% %\n", logLikelihood, logLikelihood_proposed);
@@ -154,24 +347,43 @@ void FONSEModel::calculateLogLikelihoodRatioPerGene(Gene& gene, unsigned geneInd
 void FONSEModel::calculateLogLikelihoodRatioPerGroupingPerCategory(std::string grouping, Genome& genome, std::vector<double> &logAcceptanceRatioForAllMixtures)
 {
 	unsigned numGenes = genome.getGenomeSize();
-	//int numCodons = SequenceSummary::GetNumCodonsForAA(grouping);
+	unsigned numCodons = SequenceSummary::GetNumCodonsForAA(grouping);
+	unsigned numMixtures = getNumMixtureElements();
 	double likelihood = 0.0;
 	double likelihood_proposed = 0.0;
 
 	double mutation[5];
 	double selection[5];
-	double mutation_proposed[5];
-	double selection_proposed[5];
-
-	std::string curAA;
 
 	Gene *gene;
 	SequenceSummary *sequenceSummary;
 	unsigned aaIndex = SequenceSummary::AAToAAIndex(grouping);
+	unsigned aaStart, aaEnd;
+	SequenceSummary::AAToCodonRange(grouping, aaStart, aaEnd, false);
+
+	// The coefficients only depend on the mixture element, not on the gene.
+	// order: mixture element, current (0) or proposed (1)
+	std::vector <std::array <double, 6>> offset(numMixtures * 2);
+	std::vector <std::array <double, 6>> slope(numMixtures * 2);
+	std::vector <std::array <bool, 6>> inDenominator(numMixtures * 2);
+	std::vector <double> initialDenominator(numMixtures * 2, 0.0);
+	for (unsigned mixtureElement = 0u; mixtureElement < numMixtures; mixtureElement++)
+	{
+		unsigned mutationCategory = parameter->getMutationCategory(mixtureElement);
+		unsigned selectionCategory = parameter->getSelectionCategory(mixtureElement);
+		for (unsigned proposed = 0u; proposed < 2u; proposed++)
+		{
+			unsigned entry = mixtureElement * 2 + proposed;
+			parameter->getParameterForCategory(mutationCategory, FONSEParameter::dM, grouping, proposed == 1u, mutation);
+			parameter->getParameterForCategory(selectionCategory, FONSEParameter::dOmega, grouping, proposed == 1u, selection);
+			calculateLogCodonProbabilityCoefficients(numCodons, mutation, selection, offset[entry].data(),
+				slope[entry].data(), inDenominator[entry].data(), initialDenominator[entry]);
+		}
+	}
 
 #ifdef _OPENMP
 //#ifndef __APPLE__
-	#pragma omp parallel for private(mutation, selection, mutation_proposed, selection_proposed, curAA, gene, sequenceSummary) reduction(+:likelihood,likelihood_proposed)
+	#pragma omp parallel for private(gene, sequenceSummary) reduction(+:likelihood,likelihood_proposed)
 #endif
 	for (unsigned i = 0u; i < numGenes; i++)
 	{
@@ -181,25 +393,29 @@ void FONSEModel::calculateLogLikelihoodRatioPerGroupingPerCategory(std::string g
 
 		// which mixture element does this gene belong to
 		unsigned mixtureElement = parameter->getMixtureAssignment(i);
-		// how is the mixture element defined. Which categories make it up
-		unsigned mutationCategory = parameter->getMutationCategory(mixtureElement);
-		unsigned selectionCategory = parameter->getSelectionCategory(mixtureElement);
 		unsigned expressionCategory = parameter->getSynthesisRateCategory(mixtureElement);
 		// get phi value, calculate likelihood conditional on phi
 		double phiValue = parameter->getSynthesisRate(i, expressionCategory, false);
 
-
-		// get current mutation and selection parameter
-		parameter->getParameterForCategory(mutationCategory, FONSEParameter::dM, grouping, false, mutation);
-		parameter->getParameterForCategory(selectionCategory, FONSEParameter::dOmega, grouping, false, selection);
-
-		// get proposed mutation and selection parameter
-		parameter->getParameterForCategory(mutationCategory, FONSEParameter::dM, grouping, true, mutation_proposed);
-		parameter->getParameterForCategory(selectionCategory, FONSEParameter::dOmega, grouping, true, selection_proposed);
-
-		likelihood += calculateLogLikelihoodRatioPerAA(*gene, grouping, mutation, selection, phiValue);
-		likelihood_proposed += calculateLogLikelihoodRatioPerAA(*gene, grouping, mutation_proposed, selection_proposed, phiValue);
+		unsigned current = mixtureElement * 2;
+		unsigned proposed = mixtureElement * 2 + 1;
+		if (hasPositionBuckets(i))
+		{
+			likelihood += calculateLogLikelihoodPerAAPerGeneFromBuckets(i, aaStart, numCodons, offset[current].data(),
+				slope[current].data(), inDenominator[current].data(), initialDenominator[current], phiValue);
+			likelihood_proposed += calculateLogLikelihoodPerAAPerGeneFromBuckets(i, aaStart, numCodons,
+				offset[proposed].data(), slope[proposed].data(), inDenominator[proposed].data(),
+				initialDenominator[proposed], phiValue);
+		}
+		else
+		{
+			likelihood += calculateLogLikelihoodPerAAPerGene(*gene, aaStart, numCodons, offset[current].data(),
+				slope[current].data(), inDenominator[current].data(), initialDenominator[current], phiValue);
+			likelihood_proposed += calculateLogLikelihoodPerAAPerGene(*gene, aaStart, numCodons, offset[proposed].data(),
+				slope[proposed].data(), inDenominator[proposed].data(), initialDenominator[proposed], phiValue);
+		}
 	}
+	countGenomeTraversal(numGenes, sizeof(double) + 2 * sizeof(unsigned));
 	//likelihood_proposed = likelihood_proposed + calculateMutationPrior(grouping, true);
 	//likelihood = likelihood + calculateMutationPrior(grouping, false);
 
@@ -207,6 +423,17 @@ void FONSEModel::calculateLogLikelihoodRatioPerGroupingPerCategory(std::string g
 }
 
 
+/* supportsSinglePassCodonSpecificUpdate (NOT EXPOSED)
+ * Arguments: None
+ * The log acceptance ratio of an amino acid only depends on its own codon specific parameters and phi, see
+ * Model::supportsSinglePassCodonSpecificUpdate.
+*/
+bool FONSEModel::supportsSinglePassCodonSpecificUpdate()
+{
+	return true;
+}
+
+
 void FONSEModel::calculateLogLikelihoodRatioForHyperParameters(Genome &genome, unsigned iteration, std::vector <double> & logProbabilityRatio)
 {
 	double lpr = 0.0;
@@ -239,6 +466,7 @@ void FONSEModel::calculateLogLikelihoodRatioForHyperParameters(Genome &genome, u
 		lpr += Parameter::densityLogNorm(phi, proposedMphi[mixture], proposedStdDevSynthesisRate[mixture], true)
 			   - Parameter::densityLogNorm(phi, currentMphi[mixture], currentStdDevSynthesisRate[mixture], true);
 	}
+	countGenomeTraversal(genome.getGenomeSize(), sizeof(double) + sizeof(unsigned));
 	logProbabilityRatio[0] = lpr;
 }
 
@@ -254,6 +482,7 @@ void FONSEModel::calculateLogLikelihoodRatioForHyperParameters(Genome &genome, u
 void FONSEModel::initTraces(unsigned samples, unsigned num_genes, bool estimateSynthesisRate)
 {
 	parameter->initAllTraces(samples, num_genes, estimateSynthesisRate);
+	initLogLikelihoodCache(num_genes);
 }
 
 
@@ -413,6 +642,12 @@ void FONSEModel::updateMixtureAssignmentTrace(unsigned sample, unsigned i)
 }
 
 
+void FONSEModel::updateSynthesisRateTraces(unsigned sample)
+{
+	parameter->updateSynthesisRateTraces(sample);
+}
+
+
 void FONSEModel::updateMixtureProbabilitiesTrace(unsigned sample)
 {
 	parameter->updateMixtureProbabilitiesTrace(sample);
@@ -431,15 +666,11 @@ void FONSEModel::updateHyperParameterTraces(unsigned sample)
 }
 
 
-void FONSEModel::updateTracesWithInitialValues(Genome & genome)
+void FONSEModel::updateTracesWithInitialValues(Genome & /*genome*/)
 {
 	std::vector <std::string> groupList = parameter->getGroupList();
 
-	for (unsigned i = 0; i < genome.getGenomeSize(); i++)
-	{
-		parameter->updateSynthesisRateTrace(0, i);
-		parameter->updateMixtureAssignmentTrace(0, i);
-	}
+	updateSynthesisRateTraces(0);
 
 	for (unsigned i = 0; i < groupList.size(); i++)
 	{
@@ -448,6 +679,18 @@ void FONSEModel::updateTracesWithInitialValues(Genome & genome)
 }
 
 
+bool FONSEModel::flushTraces()
+{
+	return parameter->flushTraces();
+}
+
+
+bool FONSEModel::hasTraceFileWriteFailed()
+{
+	return parameter->hasTraceFileWriteFailed();
+}
+
+
 
 
 
@@ -551,6 +794,7 @@ void FONSEModel::setCategoryProbability(unsigned mixture, double value)
 void FONSEModel::updateCodonSpecificParameter(std::string grouping)
 {
 	parameter->updateCodonSpecificParameter(grouping);
+	invalidateLogLikelihoodCache(grouping);
 }
 
 
@@ -804,6 +1048,116 @@ void FONSEModel::getParameterForCategory(unsigned category, unsigned param, std:
 }
 
 
+/* setPositionBucketMode (RCPP EXPOSED)
+ * Arguments: genome the model is run on, bucket width in codons (0 = exact likelihood)
+ * The codon probabilities of FONSE depend on the position only through phi * (4 + 4 * position). With a bucket width
+ * larger than 0, the positions of every codon in every gene are pooled into buckets of bucketWidth consecutive
+ * positions, and the likelihood is evaluated once per bucket at the mean position of the bucket instead of once per
+ * occurrence of the codon. This is an approximation: the log likelihood is overestimated by at most the bound
+ * returned by calculatePositionBucketErrorBound, and a bucket width of 1 gives the exact likelihood up to floating
+ * point rounding. The buckets are built from the genome here, so the mode has to be set again if the genome changes.
+ * Takes effect with the next run of the MCMC.
+*/
+void FONSEModel::setPositionBucketMode(Genome &genome, unsigned _positionBucketWidth)
+{
+	positionBucketWidth = _positionBucketWidth;
+	positionBucketStart.clear();
+	positionBucketCount.clear();
+	positionBucketMeanPosition.clear();
+	positionBucketSquaredDeviation.clear();
+	logLikelihoodCache.clear();
+	if (positionBucketWidth == 0u)
+		return;
+
+	unsigned numGenes = genome.getGenomeSize();
+	positionBucketStart.resize(numGenes * numCodonsTotal + 1, 0u);
+	positionBucketSquaredDeviation.assign(numGenes * numCodonsTotal, 0.0);
+	for (unsigned i = 0u; i < numGenes; i++)
+	{
+		SequenceSummary *sequenceSummary = genome.getGene(i).getSequenceSummary();
+		for (unsigned codonIndex = 0u; codonIndex < numCodonsTotal; codonIndex++)
+		{
+			unsigned pair = i * numCodonsTotal + codonIndex;
+			positionBucketStart[pair] = (unsigned)positionBucketCount.size();
+			std::vector <unsigned> &positions = *sequenceSummary->getCodonPositions(codonIndex);
+			unsigned numPositions = (unsigned)positions.size();
+			unsigned first = 0u;
+			while (first < numPositions)
+			{
+				// a bucket is a run of positions in the same window, positions are stored in increasing order
+				unsigned bucket = positions[first] / positionBucketWidth;
+				unsigned last = first + 1u;
+				while (last < numPositions && positions[last] / positionBucketWidth == bucket)
+					last++;
+
+				double sum = 0.0;
+				for (unsigned j = first; j < last; j++)
+					sum += positions[j];
+				double meanPosition = sum / (last - first);
+				for (unsigned j = first; j < last; j++)
+					positionBucketSquaredDeviation[pair] += (positions[j] - meanPosition) * (positions[j] - meanPosition);
+
+				positionBucketCount.push_back(last - first);
+				positionBucketMeanPosition.push_back(meanPosition);
+				first = last;
+			}
+		}
+	}
+	positionBucketStart[numGenes * numCodonsTotal] = (unsigned)positionBucketCount.size();
+}
+
+
+/* calculatePositionBucketErrorBound (RCPP EXPOSED)
+ * Arguments: genome the position buckets were built from, whether to use the proposed codon specific parameters
+ * Returns an upper bound for the difference between the log likelihood of the genome with position buckets and the
+ * exact one, for the current synthesis rates and mixture assignments. The difference is never negative. The log
+ * likelihood ratio of a proposal is off by at most the larger of the bounds for the current and the proposed values.
+ * Returns 0 if the position bucket mode is off.
+*/
+double FONSEModel::calculatePositionBucketErrorBound(Genome &genome, bool proposed)
+{
+	unsigned numGenes = genome.getGenomeSize();
+	unsigned numMixtures = getNumMixtureElements();
+	double mutation[5];
+	double selection[5];
+	double offset[6];
+	double slope[6];
+	bool inDenominator[6];
+	double initialDenominator;
+	std::vector <std::array <double, 6>> mixtureSlope(numMixtures);
+
+	double errorBound = 0.0;
+	for (unsigned a = 0u; a < getGroupListSize(); a++)
+	{
+		std::string grouping = getGrouping(a);
+		unsigned numCodons = SequenceSummary::GetNumCodonsForAA(grouping);
+		unsigned aaStart, aaEnd;
+		SequenceSummary::AAToCodonRange(grouping, aaStart, aaEnd, false);
+		for (unsigned mixtureElement = 0u; mixtureElement < numMixtures; mixtureElement++)
+		{
+			parameter->getParameterForCategory(parameter->getMutationCategory(mixtureElement), FONSEParameter::dM,
+				grouping, proposed, mutation);
+			parameter->getParameterForCategory(parameter->getSelectionCategory(mixtureElement), FONSEParameter::dOmega,
+				grouping, proposed, selection);
+			calculateLogCodonProbabilityCoefficients(numCodons, mutation, selection, offset, slope, inDenominator,
+				initialDenominator);
+			for (unsigned k = 0u; k < numCodons; k++)
+				mixtureSlope[mixtureElement][k] = slope[k];
+		}
+		for (unsigned i = 0u; i < numGenes; i++)
+		{
+			if (!hasPositionBuckets(i)) continue;
+			unsigned mixtureElement = parameter->getMixtureAssignment(i);
+			unsigned expressionCategory = parameter->getSynthesisRateCategory(mixtureElement);
+			double phiValue = parameter->getSynthesisRate(i, expressionCategory, false);
+			errorBound += calculatePositionBucketErrorBoundPerAAPerGene(i, aaStart, numCodons,
+				mixtureSlope[mixtureElement].data(), phiValue);
+		}
+	}
+	return errorBound;
+}
+
+
 
 
 
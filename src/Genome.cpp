@@ -21,6 +21,8 @@ using namespace Rcpp;
 Genome::Genome()
 {
 	//ctor
+	codonCountMatrixIsCurrent = false;
+	totalRFPCount.clear();
 }
 
 
@@ -32,6 +34,9 @@ Genome& Genome::operator=(const Genome& rhs)
 	numGenesWithPhi = rhs.numGenesWithPhi;
 	RFPCountColumnNames = rhs.RFPCountColumnNames;
 	prev_genome_size = rhs.prev_genome_size;
+	codonCountMatrix = rhs.codonCountMatrix;
+	codonCountMatrixIsCurrent = rhs.codonCountMatrixIsCurrent;
+	totalRFPCount = rhs.totalRFPCount;
 	//assignment operator
 	return *this;
 }
@@ -156,6 +161,7 @@ void Genome::readFasta(std::string filename, bool append)
 	{
 		my_printError("\nException: %\n", pMsg);
 	}
+	initCodonCountMatrix();
 }
 
 
@@ -216,7 +222,7 @@ void Genome::readSimulatedGenomeFromPAModel(std::string filename)
 	Gene tmpGene;
 	bool first = true;
 	std::string seq = "";
-	totalRFPCount = 0;
+	totalRFPCount.clear();
 
 	while (std::getline(Fin, tmp))
 	{
@@ -276,7 +282,8 @@ void Genome::readSimulatedGenomeFromPAModel(std::string filename)
 	tmpGene.setDescription("No description for PA(NSE) Model");
 	tmpGene.setSequence(seq);
 	addGene(tmpGene, true); //add to genome
-	totalRFPCount += tmpGene.geneData.getSumTotalRFPCount(0);
+	if (totalRFPCount.empty()) totalRFPCount.resize(1, 0u);
+	totalRFPCount[0] += tmpGene.geneData.getSumTotalRFPCount(0);
 
 	Fin.close();
 }
@@ -295,7 +302,7 @@ void Genome::readRFPData(std::string filename, bool append, bool positional)
 {
 	try {
 		if (!append) clear();
-		totalRFPCount = 0;
+		totalRFPCount.clear();
 		std::ifstream Fin;
 		Fin.open(filename.c_str());
 
@@ -381,7 +388,6 @@ void Genome::readRFPData(std::string filename, bool append, bool positional)
 						if(positional) tmpGene.setPANSESequence(table);
 						else tmpGene.setPASequence(table);
 						addGene(tmpGene, false); //add to genome
-						totalRFPCount += tmpGene.geneData.getSumTotalRFPCount(0);
 						tmpGene.clear();
 						table.clear();
 					}
@@ -431,7 +437,6 @@ void Genome::readRFPData(std::string filename, bool append, bool positional)
                 tmpGene.setId(prevID);
                 tmpGene.setDescription("No description for PA(NSE) Model");
                 tmpGene.setPASequence(table);
-                totalRFPCount += tmpGene.geneData.getSumTotalRFPCount(0);
                 addGene(tmpGene, false); //add to genome
             }
 		} // end else
@@ -441,6 +446,7 @@ void Genome::readRFPData(std::string filename, bool append, bool positional)
 	{
 		my_printError("\nException: %\n", pMsg);
 	}
+	initCodonCountMatrix();
 }
 
 
@@ -769,11 +775,17 @@ void Genome::removeUnobservedGenes()
 		}
 	}
 	genes = tmp;
+	codonCountMatrixIsCurrent = false;
 }
 
-unsigned Genome::getSumRFP()
+/* getSumRFP (NOT EXPOSED)
+ * Arguments: RFP count column (default 0)
+ * Returns the sum of the positive RFP counts of the column over all genes that were not simulated, 0 if no gene has
+ * the column.
+*/
+unsigned Genome::getSumRFP(unsigned RFPCountColumn)
 {
-    return totalRFPCount;
+    return RFPCountColumn < totalRFPCount.size() ? totalRFPCount[RFPCountColumn] : 0u;
 }
 //------------------------------------//
 //---------- Gene Functions ----------//
@@ -783,11 +795,25 @@ unsigned Genome::getSumRFP()
 /* Gene constructor (RCPP EXPOSED)
  * Arguments: gene to add, boolean if it was simulated.
  * Depending on whether a gene was simulated, appends to
- * genes or simulated genes.
+ * genes or simulated genes. The RFP counts of genes that
+ * were not simulated are added to the total (see getSumRFP).
 */
 void Genome::addGene(Gene& gene, bool simulated)
 {
 	simulated ? simulatedGenes.push_back(gene) : genes.push_back(gene);
+	if (!simulated)
+	{
+		codonCountMatrixIsCurrent = false;
+		unsigned numColumns = gene.geneData.getNumRFPCountColumns();
+		if (totalRFPCount.size() < numColumns) totalRFPCount.resize(numColumns, 0u);
+		for (unsigned column = 0u; column < numColumns; column++)
+		{
+			const int *rfpCounts = gene.geneData.getRFPCountData(column);
+			unsigned numPositions = gene.geneData.getRFPCountSize(column);
+			for (unsigned i = 0u; i < numPositions; i++)
+				if (rfpCounts[i] > 0) totalRFPCount[column] += rfpCounts[i];
+		}
+	}
 }
 
 /* getGenes (RCPP EXPOSED)
@@ -815,6 +841,8 @@ unsigned Genome::getNumGenesWithPhiForIndex(unsigned index)
 /* getGene (unsigned index) (RCPP EXPOSED)
  * Arguments: index number, simulated
  * Returns the gene from the requested set at index
+ * Note: The codon count matrix (see getCodonCountsForCodonIndex) is not updated if the sequence of the returned gene is
+ * changed, call invalidateCodonCountMatrix afterwards.
 */
 Gene& Genome::getGene(unsigned index, bool simulated)
 {
@@ -825,6 +853,7 @@ Gene& Genome::getGene(unsigned index, bool simulated)
 /* getGene (string id) (RCPP EXPOSED)
  * Arguments: id, simulated
  * Returns the gene from the requested set with the id given
+ * Note: As for getGene(index), call invalidateCodonCountMatrix after changing the sequence of the returned gene.
 */
 Gene& Genome::getGene(std::string id, bool simulated)
 {
@@ -871,6 +900,9 @@ void Genome::clear()
 	simulatedGenes.clear();
 	numGenesWithPhi.clear();
 	RFPCountColumnNames.clear();
+	codonCountMatrix.clear();
+	codonCountMatrixIsCurrent = false;
+	totalRFPCount.clear();
 }
 
 
@@ -909,15 +941,55 @@ Genome Genome::getGenomeForGeneIndices(std::vector <unsigned> indices, bool simu
 */
 std::vector<unsigned> Genome::getCodonCountsPerGene(std::string codon)
 {
-	std::vector<unsigned> codonCounts(genes.size());
 	unsigned codonIndex = SequenceSummary::codonToIndex(codon);
-	for (unsigned i = 0u; i < genes.size(); i++)
+	const unsigned *counts = getCodonCountsForCodonIndex(codonIndex);
+	return std::vector<unsigned>(counts, counts + genes.size());
+}
+
+
+/* initCodonCountMatrix (NOT EXPOSED)
+ * Arguments: None
+ * Collects the codon counts of all genes into one contiguous matrix, stored codon by codon so that
+ * the counts of one codon over all genes are adjacent in memory. Called after reading a genome and,
+ * lazily, by getCodonCountsForCodonIndex if genes were added or removed since.
+*/
+void Genome::initCodonCountMatrix()
+{
+	unsigned numGenes = (unsigned)genes.size();
+	codonCountMatrix.assign(64 * numGenes, 0u);
+	for (unsigned i = 0u; i < numGenes; i++)
 	{
-		Gene gene = genes[i];
-		SequenceSummary *sequenceSummary = gene.getSequenceSummary();
-		codonCounts[i] = sequenceSummary->getCodonCountForCodon(codonIndex);
+		SequenceSummary *sequenceSummary = genes[i].getSequenceSummary();
+		for (unsigned codonIndex = 0u; codonIndex < 64; codonIndex++)
+			codonCountMatrix[codonIndex * numGenes + i] = sequenceSummary->getCodonCountForCodon(codonIndex);
 	}
-	return codonCounts;
+	codonCountMatrixIsCurrent = true;
+}
+
+
+/* getCodonCountsForCodonIndex (NOT EXPOSED)
+ * Arguments: codon index (as in SequenceSummary::codonArray)
+ * Returns a pointer to the counts of the codon for all genes, indexed by gene.
+ * Note: Rebuilds the matrix if it is out of date, do not call the first time from within a parallel region.
+*/
+const unsigned* Genome::getCodonCountsForCodonIndex(unsigned codonIndex)
+{
+	if (!codonCountMatrixIsCurrent || codonCountMatrix.size() != 64 * genes.size())
+		initCodonCountMatrix();
+	return codonCountMatrix.data() + codonIndex * genes.size();
+}
+
+
+/* invalidateCodonCountMatrix (NOT EXPOSED)
+ * Arguments: None
+ * Marks the codon count matrix as out of date, so the next call of getCodonCountsForCodonIndex rebuilds it. The
+ * matrix is a copy of the codon counts of the genes. Genome keeps it current when genes are added or removed, but
+ * getGene hands out the genes themselves, so a caller changing a sequence through it has to call this function.
+ * Not called by getGene, since the samplers call getGene for every gene in every iteration.
+*/
+void Genome::invalidateCodonCountMatrix()
+{
+	codonCountMatrixIsCurrent = false;
 }
 
 
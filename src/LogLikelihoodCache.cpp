@@ -0,0 +1,182 @@
+#include "include/base/LogLikelihoodCache.h"
+
+
+
+//--------------------------------------------------//
+//----------- Constructors & Destructors -----------//
+//--------------------------------------------------//
+
+
+LogLikelihoodCache::LogLikelihoodCache()
+{
+	numMixtures = 0u;
+	numGroupings = 0u;
+}
+
+
+LogLikelihoodCache::~LogLikelihoodCache()
+{
+	//dtor
+}
+
+
+
+
+
+//------------------------------------------------//
+//---------- Initialization Functions ------------//
+//------------------------------------------------//
+
+
+/* init (NOT EXPOSED)
+ * Arguments: number of genes, number of mixtures, number of groupings
+ * Allocates an empty cache. Has to be called outside of parallel regions.
+*/
+void LogLikelihoodCache::init(unsigned numGenes, unsigned _numMixtures, unsigned _numGroupings)
+{
+	numMixtures = _numMixtures;
+	numGroupings = _numGroupings;
+	unsigned numEntries = numGenes * numMixtures;
+
+	groupingVersion.assign(numGroupings, 1u);
+	currentSlot.assign(numEntries, 0u);
+	slotPhi.assign(numEntries * 2u, -1.0);
+	logLikelihood.assign(numEntries * 2u * numGroupings, 0.0);
+	version.assign(numEntries * 2u * numGroupings, 0u);
+}
+
+
+/* clear (NOT EXPOSED)
+ * Arguments: None
+ * Releases all memory held by the cache. hasEntry will return false afterwards.
+*/
+void LogLikelihoodCache::clear()
+{
+	numMixtures = 0u;
+	numGroupings = 0u;
+	groupingVersion.clear();
+	currentSlot.clear();
+	slotPhi.clear();
+	logLikelihood.clear();
+	version.clear();
+}
+
+
+/* hasEntry (NOT EXPOSED)
+ * Arguments: gene index, mixture index
+ * Returns true if the cache was initialized for a genome containing the given gene and mixture.
+*/
+bool LogLikelihoodCache::hasEntry(unsigned gene, unsigned mixture)
+{
+	return mixture < numMixtures && (gene * numMixtures + mixture) < currentSlot.size();
+}
+
+
+
+
+
+//------------------------------------------------//
+//--------------- Update Functions ---------------//
+//------------------------------------------------//
+
+
+/* invalidateGrouping (NOT EXPOSED)
+ * Arguments: grouping index
+ * Marks all cached terms of the grouping as outdated. Call whenever the codon specific parameters of the grouping change.
+*/
+void LogLikelihoodCache::invalidateGrouping(unsigned grouping)
+{
+	if (grouping < numGroupings)
+		groupingVersion[grouping]++;
+}
+
+
+/* setCurrentPhi (NOT EXPOSED)
+ * Arguments: gene index, mixture index, current synthesis rate
+ * Makes the slot holding phi the current slot. If neither slot was calculated with phi,
+ * the current slot is emptied and its terms will be recalculated on the next request.
+*/
+void LogLikelihoodCache::setCurrentPhi(unsigned gene, unsigned mixture, double phi)
+{
+	unsigned entry = gene * numMixtures + mixture;
+	unsigned slot = currentSlot[entry];
+
+	if (slotPhi[entry * 2u + slot] == phi)
+		return;
+
+	slot = 1u - slot;
+	if (slotPhi[entry * 2u + slot] != phi)
+	{
+		slotPhi[entry * 2u + slot] = phi;
+		unsigned start = (entry * 2u + slot) * numGroupings;
+		for (unsigned i = 0u; i < numGroupings; i++)
+			version[start + i] = 0u;
+	}
+	currentSlot[entry] = (unsigned char)slot;
+}
+
+
+/* getCurrent (NOT EXPOSED)
+ * Arguments: gene index, mixture index, grouping index, reference to write the cached term into
+ * Returns true and sets value if the current slot holds a valid term for the grouping.
+*/
+bool LogLikelihoodCache::getCurrent(unsigned gene, unsigned mixture, unsigned grouping, double &value)
+{
+	unsigned entry = gene * numMixtures + mixture;
+	unsigned index = (entry * 2u + currentSlot[entry]) * numGroupings + grouping;
+
+	if (version[index] != groupingVersion[grouping])
+		return false;
+
+	value = logLikelihood[index];
+	return true;
+}
+
+
+/* setCurrent (NOT EXPOSED)
+ * Arguments: gene index, mixture index, grouping index, log likelihood term
+ * Stores the term calculated with the current synthesis rate of the gene.
+*/
+void LogLikelihoodCache::setCurrent(unsigned gene, unsigned mixture, unsigned grouping, double value)
+{
+	unsigned entry = gene * numMixtures + mixture;
+	unsigned index = (entry * 2u + currentSlot[entry]) * numGroupings + grouping;
+
+	logLikelihood[index] = value;
+	version[index] = groupingVersion[grouping];
+}
+
+
+/* setProposedPhi (NOT EXPOSED)
+ * Arguments: gene index, mixture index, proposed synthesis rate
+ * Prepares the non current slot for the terms of the proposed synthesis rate. Call once per gene before setProposed,
+ * the terms of the slot are kept if it was already calculated with the same phi.
+*/
+void LogLikelihoodCache::setProposedPhi(unsigned gene, unsigned mixture, double phi)
+{
+	unsigned entry = gene * numMixtures + mixture;
+	unsigned slot = (entry * 2u) + (1u - currentSlot[entry]);
+
+	if (slotPhi[slot] != phi)
+	{
+		slotPhi[slot] = phi;
+		unsigned start = slot * numGroupings;
+		for (unsigned i = 0u; i < numGroupings; i++)
+			version[start + i] = 0u;
+	}
+}
+
+
+/* setProposed (NOT EXPOSED)
+ * Arguments: gene index, mixture index, grouping index, log likelihood term
+ * Stores the term calculated with the proposed synthesis rate (see setProposedPhi) in the non current slot, so it
+ * can be reused if the proposal is accepted.
+*/
+void LogLikelihoodCache::setProposed(unsigned gene, unsigned mixture, unsigned grouping, double value)
+{
+	unsigned entry = gene * numMixtures + mixture;
+	unsigned index = ((entry * 2u) + (1u - currentSlot[entry])) * numGroupings + grouping;
+
+	logLikelihood[index] = value;
+	version[index] = groupingVersion[grouping];
+}
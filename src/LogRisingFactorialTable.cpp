@@ -0,0 +1,134 @@
+#include "include/base/LogRisingFactorialTable.h"
+
+
+
+//--------------------------------------------------//
+//----------- Constructors & Destructors -----------//
+//--------------------------------------------------//
+
+
+LogRisingFactorialTable::LogRisingFactorialTable()
+{
+	numCategories = 0u;
+	numCodons = 0u;
+	rowLength = 0u;
+}
+
+
+LogRisingFactorialTable::~LogRisingFactorialTable()
+{
+	//dtor
+}
+
+
+
+
+
+//------------------------------------------------//
+//---------- Initialization Functions ------------//
+//------------------------------------------------//
+
+
+/* init (NOT EXPOSED)
+ * Arguments: number of categories, number of codons, largest count to tabulate
+ * Allocates an empty table. Has to be called outside of parallel regions.
+*/
+void LogRisingFactorialTable::init(unsigned _numCategories, unsigned _numCodons, unsigned maxCount)
+{
+	numCategories = _numCategories;
+	numCodons = _numCodons;
+	rowLength = maxCount + 1u;
+	unsigned numEntries = numCategories * numCodons;
+
+	rowAlpha.assign(numEntries * 2u, -1.0);
+	lastUsedRow.assign(numEntries, 0u);
+	logRisingFactorial.assign(numEntries * 2u * rowLength, 0.0);
+}
+
+
+/* clear (NOT EXPOSED)
+ * Arguments: None
+ * Releases all memory held by the table. get calculates every value directly afterwards.
+*/
+void LogRisingFactorialTable::clear()
+{
+	numCategories = 0u;
+	numCodons = 0u;
+	rowLength = 0u;
+	rowAlpha.clear();
+	lastUsedRow.clear();
+	logRisingFactorial.clear();
+}
+
+
+/* getMaxCount (NOT EXPOSED)
+ * Arguments: None
+ * Returns the largest count that is tabulated, 0 if the table is not initialized.
+*/
+unsigned LogRisingFactorialTable::getMaxCount()
+{
+	return rowLength > 0u ? rowLength - 1u : 0u;
+}
+
+
+
+
+
+//------------------------------------------------//
+//---------------- Table Functions ---------------//
+//------------------------------------------------//
+
+
+/* update (NOT EXPOSED)
+ * Arguments: category, codon index, alpha
+ * Makes sure one of the two rows of the pair holds the values for alpha. If neither does, the row that was not used
+ * last is overwritten, so calling update with the current and then with the proposed alpha keeps both.
+*/
+void LogRisingFactorialTable::update(unsigned category, unsigned codon, double alpha)
+{
+	if (category >= numCategories || codon >= numCodons)
+		return;
+
+	unsigned entry = category * numCodons + codon;
+	unsigned row = lastUsedRow[entry];
+	if (rowAlpha[entry * 2u + row] != alpha)
+	{
+		row = 1u - row;
+		if (rowAlpha[entry * 2u + row] != alpha)
+		{
+			double *values = &logRisingFactorial[(entry * 2u + row) * rowLength];
+			for (unsigned count = 0u; count < rowLength; count++)
+				values[count] = calculate(alpha, count);
+			rowAlpha[entry * 2u + row] = alpha;
+		}
+	}
+	lastUsedRow[entry] = (unsigned char)row;
+}
+
+
+/* get (NOT EXPOSED)
+ * Arguments: category, codon index, alpha, count
+ * Returns lgamma(alpha + count) - lgamma(alpha), from the table if a row holds alpha and count is tabulated.
+*/
+double LogRisingFactorialTable::get(unsigned category, unsigned codon, double alpha, unsigned count) const
+{
+	if (count < rowLength && category < numCategories && codon < numCodons)
+	{
+		unsigned entry = category * numCodons + codon;
+		if (rowAlpha[entry * 2u] == alpha)
+			return logRisingFactorial[entry * 2u * rowLength + count];
+		if (rowAlpha[entry * 2u + 1u] == alpha)
+			return logRisingFactorial[(entry * 2u + 1u) * rowLength + count];
+	}
+	return calculate(alpha, count);
+}
+
+
+/* calculate (NOT EXPOSED)
+ * Arguments: alpha, count
+ * Returns lgamma(alpha + count) - lgamma(alpha) without using a table.
+*/
+double LogRisingFactorialTable::calculate(double alpha, unsigned count)
+{
+	return std::lgamma(alpha + count) - std::lgamma(alpha);
+}
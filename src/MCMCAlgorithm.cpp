@@ -30,6 +30,15 @@ using namespace Rcpp;
 //--------------------------------------------------//
 
 
+const unsigned MCMCAlgorithm::codonSpecificProposalPhase = 0u;
+const unsigned MCMCAlgorithm::codonSpecificAcceptRejectPhase = 1u;
+const unsigned MCMCAlgorithm::hyperParameterUpdatePhase = 2u;
+const unsigned MCMCAlgorithm::synthesisRateUpdatePhase = 3u;
+const unsigned MCMCAlgorithm::traceWritePhase = 4u;
+const unsigned MCMCAlgorithm::restartFileWritePhase = 5u;
+const unsigned MCMCAlgorithm::numProfilePhases = 6u;
+
+
 /*MCMCAlgorithm constructor (RCPP EXPOSED)
 * Arguments: None
 * Sets up the object with the specified default values. Every step is a sample in
@@ -48,6 +57,10 @@ MCMCAlgorithm::MCMCAlgorithm() : samples(1000), thinning(1), adaptiveWidth(100 *
 
 	estimateMixtureAssignment = true;
 	stepsToAdapt = -1;
+	singlePassCodonSpecificParameterUpdate = false;
+	fusedGenomeTraversal = false;
+	profiling = false;
+	resetProfile();
 }
 
 
@@ -72,6 +85,10 @@ MCMCAlgorithm::MCMCAlgorithm(unsigned _samples, unsigned _thinning, unsigned _ad
 	lastConvergenceTest = 0u;
 	estimateMixtureAssignment = true;
 	stepsToAdapt = -1;
+	singlePassCodonSpecificParameterUpdate = false;
+	fusedGenomeTraversal = false;
+	profiling = false;
+	resetProfile();
 }
 
 
@@ -97,6 +114,9 @@ MCMCAlgorithm::~MCMCAlgorithm()
 * Based on the loglikelihood probabilities proposed for a gene (with and without reverse jump), it is decided
 * whether or not a synthesis rate is accepted for that gene or not. Mixture assignment is also updated when
 * applicable.
+* Genes are processed in parallel. The random numbers used for the acceptance and mixture assignment of each gene
+* are drawn up front in gene order, and the per gene log posteriors and mixture assignments are summed up in gene
+* order afterwards, so the result does not depend on the number of threads used.
 */
 double MCMCAlgorithm::acceptRejectSynthesisRateLevelForAllGenes(Genome& genome, Model& model, int iteration)
 {
@@ -107,13 +127,32 @@ double MCMCAlgorithm::acceptRejectSynthesisRateLevelForAllGenes(Genome& genome,
 	double loglikelihood;
 	double logPosterior = 0.0;
     //double logPosterior2 = 0.0; //currently unused
-	int numGenes = genome.getGenomeSize();
+	unsigned numGenes = genome.getGenomeSize();
 
 	unsigned numSynthesisRateCategories = model.getNumSynthesisRateCategories();
 	unsigned numMixtures = model.getNumMixtureElements();
 	std::vector <double> dirichletParameters(numMixtures, 0);
 
-	//initialize parameter's size
+	// The RNG (R's or the static generator in STANDALONE) is not thread safe. Draw all random numbers
+	// needed for the sweep here, in the same order as a serial sweep would: for each gene one exponential
+	// per synthesis rate category followed by one U(0,1) for the mixture assignment.
+	unsigned numDrawsPerGene = numSynthesisRateCategories + 1u;
+	std::vector <double> randomDraws(numGenes * numDrawsPerGene, 0.0);
+	for (unsigned i = 0u; i < numGenes; i++)
+	{
+		for (unsigned k = 0u; k < numSynthesisRateCategories; k++)
+			randomDraws[i * numDrawsPerGene + k] = -Parameter::randExp(1);
+		randomDraws[i * numDrawsPerGene + numSynthesisRateCategories] = Parameter::randUnif(0.0, 1.0);
+	}
+
+	std::vector <double> geneLogPosterior(numGenes, 0.0);
+	std::vector <unsigned> geneCategory(numGenes, 0u);
+	unsigned numAccepted = 0u;
+
+#ifdef _OPENMP
+//#ifndef __APPLE__
+#pragma omp parallel for schedule(dynamic, 16) reduction(+:numAccepted)
+#endif
 	for (unsigned i = 0u; i < numGenes; i++)
 	{
 		Gene *gene = &genome.getGene(i);
@@ -197,6 +236,10 @@ double MCMCAlgorithm::acceptRejectSynthesisRateLevelForAllGenes(Genome& genome,
 			normalizingProbabilityConstant += probabilities[k];
             if (std::isnan(probabilities[k]))
             {
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+                {
                 my_print("\n\n\n");
                 my_print("Gene: %, %\n", i, gene->getId());
                 my_print("Mixture: %\n", k);
@@ -206,6 +249,7 @@ double MCMCAlgorithm::acceptRejectSynthesisRateLevelForAllGenes(Genome& genome,
                 my_print("exp(curr logLik - maxVal): %\n", std::exp(unscaledLogProb_curr_singleMixture[k]));
                 my_print("Max Val. %\n", maxValue);
                 my_print("\n\n\n");
+                }
 		break;
             }
             unscaledLogProb_curr_singleMixture[k] += maxValue;
@@ -226,10 +270,11 @@ double MCMCAlgorithm::acceptRejectSynthesisRateLevelForAllGenes(Genome& genome,
 			double currLogPost = unscaledLogProb_curr[k];
 			double propLogPost = unscaledLogProb_prop[k];
 			std::vector<unsigned> mixtureElements = model.getMixtureElementsOfSelectionCategory(k);
-            double alpha = -Parameter::randExp(1);
+            double alpha = randomDraws[i * numDrawsPerGene + k];
 			if ( (alpha < (propLogPost - currLogPost)) && estimateSynthesisRate )
 			{
 				model.updateSynthesisRate(i,k);
+				numAccepted++;
 
 				for (unsigned n = 0u; n < mixtureElements.size(); n++)
 				{
@@ -257,10 +302,13 @@ double MCMCAlgorithm::acceptRejectSynthesisRateLevelForAllGenes(Genome& genome,
 				currGeneLogPost += probabilities[k] * std::exp(unscaledLogPost_curr[k] - maxValue2);
 			}*/
 
-            if (std::isnan(logPosterior))
+            if (std::isnan(currGeneLogPost))
             {
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+                {
                 my_print("\n\n\n");
-                my_print("logPosterior: %\n", logPosterior);
                 my_print("currGeneLogPost: %\n", currGeneLogPost);
                 my_print("Gene: %, %\n", i, gene->getId());
                 my_print("Mixture: %\n", k);
@@ -269,24 +317,39 @@ double MCMCAlgorithm::acceptRejectSynthesisRateLevelForAllGenes(Genome& genome,
                 my_print("prop logLik: %\n", unscaledLogPost_prop[k]);
                 my_print("Accepted?: % < % , %\n", alpha, (propLogPost - currLogPost), alpha < (propLogPost - currLogPost));
                 my_print("\n\n\n");
+                }
             }
 		}
-		logPosterior += std::log(currGeneLogPost) + maxValue2;
+		geneLogPosterior[i] = std::log(currGeneLogPost) + maxValue2;
 
 		// Get category in which the gene is placed in.
 		// If we use multiple sequence observation (like different mutants),
 		// randMultinom needs a parameter N to place N observations in numMixture buckets
-		unsigned categoryOfGene = Parameter::randMultinom(probabilities, numMixtures);
-		if (estimateMixtureAssignment)
-			model.setMixtureAssignment(i, categoryOfGene);
-
-		dirichletParameters[categoryOfGene] += 1;
-		if ((iteration % thinning) == 0)
+		// Same as Parameter::randMultinom, but with the pre-drawn U(0,1) value.
+		double referenceValue = randomDraws[i * numDrawsPerGene + numSynthesisRateCategories];
+		double cumulativeSum = 0.0;
+		unsigned categoryOfGene = 0u;
+		for (unsigned k = 0u; k < numMixtures; k++)
 		{
-			model.updateSynthesisRateTrace(iteration/thinning, i);
-			model.updateMixtureAssignmentTrace(iteration/thinning, i);
+			cumulativeSum += probabilities[k];
+			if (referenceValue <= cumulativeSum)
+			{
+				categoryOfGene = k;
+				break;
+			}
 		}
+		geneCategory[i] = categoryOfGene;
+		if (estimateMixtureAssignment)
+			model.setMixtureAssignment(i, categoryOfGene);
+	}
+	recordProfileAcceptances(synthesisRateUpdatePhase, estimateSynthesisRate ? numGenes * numSynthesisRateCategories : 0u,
+		numAccepted);
 
+	// Reduce in gene order to keep the sum independent of the thread schedule.
+	for (unsigned i = 0u; i < numGenes; i++)
+	{
+		logPosterior += geneLogPosterior[i];
+		dirichletParameters[geneCategory[i]] += 1;
 	}
 
 	// take all priors into account
@@ -305,10 +368,7 @@ double MCMCAlgorithm::acceptRejectSynthesisRateLevelForAllGenes(Genome& genome,
 		model.setCategoryProbability(k, newMixtureProbabilities[k]);
 	}
 	if ((iteration % thinning) == 0)
-	{
-		model.updateMixtureProbabilitiesTrace(iteration/thinning);
 		likelihoodTrace[iteration/thinning] = loglikelihood;
-	}
 	return logPosterior;
 }
 
@@ -317,71 +377,148 @@ double MCMCAlgorithm::acceptRejectSynthesisRateLevelForAllGenes(Genome& genome,
  * Arguments: reference to a genome and a model. which iteration (step) is currently being estimated
  * Calculates the logLikelihood for each grouping based on codon specific parameters. If this is greater
  * than a random number from the exponential distribution we update the parameters from proposed to
- * current. Update the trace when applicable.
+ * current. The traces are written by run (see updateCodonSpecificParameterTraces).
 */
 void MCMCAlgorithm::acceptRejectCodonSpecificParameter(Genome& genome, Model& model, int iteration)
 {
 	std::vector<double> acceptanceRatioForAllMixtures(5,0.0);
+	std::vector<std::vector<double>> acceptanceRatioForAllGroupings;
 	unsigned size = model.getGroupListSize();
+	unsigned numAccepted = 0u;
+
+	model.prepareForCodonSpecificParameterUpdate(genome);
+
+	// Only models whose groupings do not depend on each other can evaluate all of them up front.
+	// Thresholds are still drawn one grouping after the other, in the same order as below.
+	bool singlePass = singlePassCodonSpecificParameterUpdate && model.supportsSinglePassCodonSpecificUpdate();
+	if (singlePass)
+		model.calculateLogLikelihoodRatioForAllGroupings(genome, acceptanceRatioForAllGroupings);
 
 	for (unsigned i = 0; i < size; i++)
 	{
 		std::string grouping = model.getGrouping(i);
 
 		// calculate likelihood ratio for every Category for current AA
-		model.calculateLogLikelihoodRatioPerGroupingPerCategory(grouping, genome, acceptanceRatioForAllMixtures);
+		if (singlePass)
+			acceptanceRatioForAllMixtures = acceptanceRatioForAllGroupings[i];
+		else
+			model.calculateLogLikelihoodRatioPerGroupingPerCategory(grouping, genome, acceptanceRatioForAllMixtures);
 		//logPosterior += model.calculateAllPriors();
-    double threshold = -Parameter::randExp(1);
+		double threshold = -Parameter::randExp(1);
 
-		if (threshold < acceptanceRatioForAllMixtures[0] && std::isfinite(acceptanceRatioForAllMixtures[0]))
-		{
-			// moves proposed codon specific parameters to current codon specific parameters
-			model.updateCodonSpecificParameter(grouping);
-			if ((iteration % thinning) == 0)
-			{
-				likelihoodTrace[(iteration / thinning)] += acceptanceRatioForAllMixtures[2];//will be 0
-				posteriorTrace[(iteration / thinning)] += acceptanceRatioForAllMixtures[4];//will be 0
-			}
-		}
-		else
-		{
-			if ((iteration % thinning) == 0)
-			{
-				likelihoodTrace[(iteration / thinning)] += acceptanceRatioForAllMixtures[1];
-				posteriorTrace[(iteration / thinning)] += acceptanceRatioForAllMixtures[3];
+		if (acceptRejectGrouping(model, grouping, threshold, acceptanceRatioForAllMixtures, iteration))
+			numAccepted++;
+	}
+	recordProfileAcceptances(codonSpecificAcceptRejectPhase, size, numAccepted);
+}
 
-			}
+
+/* acceptRejectGrouping (NOT EXPOSED)
+ * Arguments: reference to a model, grouping, threshold drawn from the exponential distribution, log acceptance ratio
+ * of the grouping (see calculateLogLikelihoodRatioPerGroupingPerCategory), which iteration is currently being estimated
+ * Updates the codon specific parameters of the grouping from proposed to current if the log acceptance ratio exceeds
+ * the threshold. Returns true if the proposal was accepted.
+*/
+bool MCMCAlgorithm::acceptRejectGrouping(Model& model, std::string grouping, double threshold,
+	std::vector<double> &acceptanceRatioForAllMixtures, int iteration)
+{
+	bool accepted = threshold < acceptanceRatioForAllMixtures[0] && std::isfinite(acceptanceRatioForAllMixtures[0]);
+	if (accepted)
+	{
+		// moves proposed codon specific parameters to current codon specific parameters
+		model.updateCodonSpecificParameter(grouping);
+		if ((iteration % thinning) == 0)
+		{
+			likelihoodTrace[(iteration / thinning)] += acceptanceRatioForAllMixtures[2];//will be 0
+			posteriorTrace[(iteration / thinning)] += acceptanceRatioForAllMixtures[4];//will be 0
 		}
+	}
+	else
+	{
 		if ((iteration % thinning) == 0)
 		{
-			model.updateCodonSpecificParameterTrace(iteration/thinning, grouping);
+			likelihoodTrace[(iteration / thinning)] += acceptanceRatioForAllMixtures[1];
+			posteriorTrace[(iteration / thinning)] += acceptanceRatioForAllMixtures[3];
+
 		}
 	}
+	return accepted;
 }
 
 
 /* acceptRejectHyperParameter (NOT EXPOSED)
  * Arguments: reference to a genome and a model. which iteration (step) is currently being estimated
  * Calculates the logLikelihood for hyper parameters. If the calculated value is greater than a random number
- * from the exponential distribution we update the parameters from proposed to current. Update the trace when applicable.
+ * from the exponential distribution we update the parameters from proposed to current.
 */
 void MCMCAlgorithm::acceptRejectHyperParameter(Genome &genome, Model& model, unsigned iteration)
 {
 	std::vector <double> logProbabilityRatios;
 
 	model.calculateLogLikelihoodRatioForHyperParameters(genome, iteration, logProbabilityRatios);
+	acceptRejectHyperParameterRatios(model, logProbabilityRatios, iteration);
+}
 
+
+/* acceptRejectHyperParameterRatios (NOT EXPOSED)
+ * Arguments: reference to a model, log acceptance ratios of the hyper parameters, which iteration is currently being
+ * estimated
+ * Updates each hyper parameter from proposed to current if its log acceptance ratio is greater than a random number
+ * from the exponential distribution.
+*/
+void MCMCAlgorithm::acceptRejectHyperParameterRatios(Model& model, std::vector <double> &logProbabilityRatios, unsigned /*iteration*/)
+{
+	unsigned numAccepted = 0u;
 	for (unsigned i = 0; i < logProbabilityRatios.size(); i++)
 	{
 		if (!std::isfinite(logProbabilityRatios[i]))
             my_print("logProbabilityRatio % not finite!\n", i);
 
 		if (-Parameter::randExp(1) < logProbabilityRatios[i])
+		{
 			model.updateHyperParameter(i);
+			numAccepted++;
+		}
 	}
+	recordProfileAcceptances(hyperParameterUpdatePhase, logProbabilityRatios.size(), numAccepted);
+}
 
-	if ((iteration % thinning) == 0)
-		model.updateHyperParameterTraces(iteration/thinning);
+
+/* acceptRejectCodonSpecificAndHyperParameter (NOT EXPOSED)
+ * Arguments: reference to a genome and a model. which iteration (step) is currently being estimated
+ * Fused version of acceptRejectCodonSpecificParameter followed by the hyper parameter update, used if the model
+ * supports it (see Model::supportsFusedGenomeTraversal). The log acceptance ratios of all groupings and all hyper
+ * parameters are calculated together, in as few passes over the genome as the model can manage, before any of them
+ * is accepted. Random numbers are drawn in the same order as in the unfused update, so the chain is unchanged.
+*/
+void MCMCAlgorithm::acceptRejectCodonSpecificAndHyperParameter(Genome& genome, Model& model, int iteration)
+{
+	unsigned size = model.getGroupListSize();
+
+	model.prepareForCodonSpecificParameterUpdate(genome);
+
+	// the thresholds of the groupings come first in the unfused update
+	std::vector<double> thresholds(size, 0.0);
+	for (unsigned i = 0; i < size; i++)
+		thresholds[i] = -Parameter::randExp(1);
+
+	// neither depends on the codon specific parameters
+	model.updateGibbsSampledHyperParameters(genome);
+	model.proposeHyperParameters();
+
+	std::vector<std::vector<double>> acceptanceRatioForAllGroupings;
+	std::vector <double> logProbabilityRatios;
+	model.calculateLogLikelihoodRatioForAllGroupingsAndHyperParameters(genome, iteration, acceptanceRatioForAllGroupings,
+		logProbabilityRatios);
+
+	unsigned numAccepted = 0u;
+	for (unsigned i = 0; i < size; i++)
+	{
+		if (acceptRejectGrouping(model, model.getGrouping(i), thresholds[i], acceptanceRatioForAllGroupings[i], iteration))
+			numAccepted++;
+	}
+	recordProfileAcceptances(codonSpecificAcceptRejectPhase, size, numAccepted);
+	acceptRejectHyperParameterRatios(model, logProbabilityRatios, iteration);
 }
 
 
@@ -392,11 +529,34 @@ void MCMCAlgorithm::acceptRejectHyperParameter(Genome &genome, Model& model, uns
 //---------- MCMC Functions ----------//
 //------------------------------------//
 
+/* updateCodonSpecificParameterTraces (NOT EXPOSED)
+ * Arguments: reference to a model, index of the sample to store
+ * Stores the current codon specific parameters of all groupings in the trace.
+*/
+void MCMCAlgorithm::updateCodonSpecificParameterTraces(Model& model, unsigned sample)
+{
+	unsigned size = model.getGroupListSize();
+	for (unsigned i = 0u; i < size; i++)
+		model.updateCodonSpecificParameterTrace(sample, model.getGrouping(i));
+}
+
+
+/* updateSynthesisRateTraces (NOT EXPOSED)
+ * Arguments: reference to a genome and a model, index of the sample to store
+ * Stores the current synthesis rates and mixture assignments of all genes and the mixture probabilities in the trace.
+*/
+void MCMCAlgorithm::updateSynthesisRateTraces(Genome& /*genome*/, Model& model, unsigned sample)
+{
+	model.updateSynthesisRateTraces(sample);
+	model.updateMixtureProbabilitiesTrace(sample);
+}
+
+
 /* run (RCPP EXPOSED)
  * Arguments: reference to a genome and a model. number of cores to run on (unless running on a MAC). Number of
  * iterations to allow initial conditions to vary.
  * Runs the MCMC algorithm for the set number of iterations. Run can terminate early if Geweke score meets
- * the set criteria.
+ * the set criteria. Run stops if the log likelihood is NaN or a sample can not be written to the trace file.
 */
 void MCMCAlgorithm::run(Genome& genome, Model& model, unsigned numCores, unsigned divergenceIterations)
 {
@@ -429,15 +589,29 @@ void MCMCAlgorithm::run(Genome& genome, Model& model, unsigned numCores, unsigne
 	my_print("\tStarting MCMC with % iterations\n", maximumIterations);
 	my_print("\tAdapting will stop after % steps\n", stepsToAdapt);
 
+	bool fused = fusedGenomeTraversal && estimateCodonSpecificParameter && estimateHyperParameter
+		&& model.supportsFusedGenomeTraversal();
+	if (fusedGenomeTraversal && !fused)
+		my_print("\tFused genome traversal is not available for this model or set of estimated parameters\n");
+	if (singlePassCodonSpecificParameterUpdate && !model.supportsSinglePassCodonSpecificUpdate())
+		my_print("\tSingle pass codon specific parameter update is not available for this model\n");
+	genomeTraversalTrace.assign(samples + 1, 0u);
+	genomeTraversalBytesTrace.assign(samples + 1, 0.0);
+	resetProfile();
+
 	// set the last iteration to the max iterations,
 	// this way if the MCMC doesn't exit based on Geweke score, it will use the max iteration for posterior means
 	model.setLastIteration(samples);
 	for (int iteration = 1u; iteration <= maximumIterations; iteration++)
 	{
+		bool storeSample = (iteration % thinning) == 0u;
+		std::chrono::steady_clock::time_point phaseStart;
+
 		if (writeRestartFile)
 		{
 			if ((iteration) % fileWriteInterval == 0u)
 			{
+				phaseStart = startProfilePhase();
 				my_print("Begin saving restart file(s) at sample (iteration): % (%)\n",  (iteration / thinning), iteration);
 
 				if (multipleFiles)
@@ -451,6 +625,7 @@ void MCMCAlgorithm::run(Genome& genome, Model& model, unsigned numCores, unsigne
 				{
 					model.writeRestartFile(file);
 				}
+				recordProfilePhase(restartFileWritePhase, phaseStart);
 			}
 		}
 		if ((iteration) % reportStep == 0u)
@@ -470,38 +645,98 @@ void MCMCAlgorithm::run(Genome& genome, Model& model, unsigned numCores, unsigne
 				my_print("\t current Mixture element probability for element %: %\n", i, model.getCategoryProbability(i));
 			}
 		}
-		if (estimateCodonSpecificParameter)
+		model.resetGenomeTraversalCounters();
+		if (fused)
 		{
+			// codon specific and hyper parameters are conditionally independent given phi, update them together
+			phaseStart = startProfilePhase();
 			model.proposeCodonSpecificParameter();
+			recordProfilePhase(codonSpecificProposalPhase, phaseStart);
+
+			// the hyper parameter part of the fused update can not be timed separately and is included here
+			phaseStart = startProfilePhase();
+			acceptRejectCodonSpecificAndHyperParameter(genome, model, iteration);
+			if ((iteration % adaptiveWidth) == 0u)
+			{
+				model.adaptCodonSpecificParameterProposalWidth(adaptiveWidth, iteration / thinning, iteration <= stepsToAdapt);
+				model.adaptHyperParameterProposalWidths(adaptiveWidth, iteration <= stepsToAdapt);
+			}
+			recordProfilePhase(codonSpecificAcceptRejectPhase, phaseStart);
+
+			if (storeSample)
+			{
+				phaseStart = startProfilePhase();
+				updateCodonSpecificParameterTraces(model, iteration / thinning);
+				model.updateHyperParameterTraces(iteration / thinning);
+				recordProfilePhase(traceWritePhase, phaseStart);
+			}
+		}
+		if (estimateCodonSpecificParameter && !fused)
+		{
+			phaseStart = startProfilePhase();
+			model.proposeCodonSpecificParameter();
+			recordProfilePhase(codonSpecificProposalPhase, phaseStart);
+
+			phaseStart = startProfilePhase();
 			acceptRejectCodonSpecificParameter(genome, model, iteration);
             //TODO:Probably do a nan check
 			if ((iteration % adaptiveWidth) == 0u)
 				model.adaptCodonSpecificParameterProposalWidth(adaptiveWidth, iteration / thinning, iteration <= stepsToAdapt);
+			recordProfilePhase(codonSpecificAcceptRejectPhase, phaseStart);
+
+			if (storeSample)
+			{
+				phaseStart = startProfilePhase();
+				updateCodonSpecificParameterTraces(model, iteration / thinning);
+				recordProfilePhase(traceWritePhase, phaseStart);
+			}
 		}
 		// update hyper parameter
-		if (estimateHyperParameter)
+		if (estimateHyperParameter && !fused)
 		{
-
+			phaseStart = startProfilePhase();
 			model.updateGibbsSampledHyperParameters(genome);
 			model.proposeHyperParameters();
 			acceptRejectHyperParameter(genome, model, iteration);
             //TODO:Probably do a nan check
 			if ((iteration % adaptiveWidth) == 0u)
 				model.adaptHyperParameterProposalWidths(adaptiveWidth, iteration <= stepsToAdapt);
+			recordProfilePhase(hyperParameterUpdatePhase, phaseStart);
 
+			if (storeSample)
+			{
+				phaseStart = startProfilePhase();
+				model.updateHyperParameterTraces(iteration / thinning);
+				recordProfilePhase(traceWritePhase, phaseStart);
+			}
 		}
 		// update expression level values
 		if (estimateSynthesisRate || estimateMixtureAssignment)
 		{
+			phaseStart = startProfilePhase();
 			model.proposeSynthesisRateLevels();
 			double logPost = acceptRejectSynthesisRateLevelForAllGenes(genome, model, iteration);
-			if ((iteration % thinning) == 0u)
+			model.countSynthesisRateTraversal(genome.getGenomeSize());
+			recordProfilePhase(synthesisRateUpdatePhase, phaseStart);
+
+			if (storeSample)
 			{
+				phaseStart = startProfilePhase();
+				updateSynthesisRateTraces(genome, model, iteration / thinning);
+				recordProfilePhase(traceWritePhase, phaseStart);
+
 				posteriorTrace[(iteration / thinning)] = logPost;
 				if (std::isnan(logPost))
 				{
 					my_printError("ERROR: Log likelihood is NaN, exiting at iteration %\n", iteration);
 					model.setLastIteration(iteration / thinning);
+					model.flushTraces();
+					return;
+				}
+				if (model.hasTraceFileWriteFailed())
+				{
+					my_printError("ERROR: Could not write the trace file, exiting at iteration %\n", iteration);
+					model.setLastIteration(iteration / thinning);
 					return;
 				}
 			}
@@ -509,6 +744,11 @@ void MCMCAlgorithm::run(Genome& genome, Model& model, unsigned numCores, unsigne
 				model.adaptSynthesisRateProposalWidth(adaptiveWidth, iteration <= stepsToAdapt);
 
   		}
+		if (storeSample)
+		{
+			genomeTraversalTrace[iteration / thinning] = model.getNumGenomeTraversals();
+			genomeTraversalBytesTrace[iteration / thinning] = model.getGenomeTraversalBytes();
+		}
 
 
 		if ((iteration % (50 * adaptiveWidth)) == 0u)
@@ -529,13 +769,17 @@ void MCMCAlgorithm::run(Genome& genome, Model& model, unsigned numCores, unsigne
 			}
 		}
 	} // end MCMC loop
+	if (!model.flushTraces())
+		my_printError("ERROR: Could not write the trace file, it misses samples of the run\n");
 
 	if (writeRestartFile)
 	{
+		std::chrono::steady_clock::time_point phaseStart = startProfilePhase();
 		std::ostringstream oss;
 		oss << file << "_final";
 		std::string tmp = oss.str();
 		model.writeRestartFile(tmp);
+		recordProfilePhase(restartFileWritePhase, phaseStart);
 	}
 	my_print("leaving MCMC loop\n");
 }
@@ -795,6 +1039,238 @@ int MCMCAlgorithm::getStepsToAdapt()
 }
 
 
+/* isSinglePassCodonSpecificParameterUpdate (NOT EXPOSED)
+ * Arguments: None
+ * Return the boolean value for if all groupings are evaluated in one pass over the genome.
+*/
+bool MCMCAlgorithm::isSinglePassCodonSpecificParameterUpdate()
+{
+	return singlePassCodonSpecificParameterUpdate;
+}
+
+
+/* setSinglePassCodonSpecificParameterUpdate (RCPP EXPOSED)
+ * Arguments: boolean describing if all groupings should be evaluated in one pass over the genome.
+ * If true, the log likelihood ratios of all groupings are calculated together (see
+ * Model::calculateLogLikelihoodRatioForAllGroupings) before they are accepted or rejected one by one. Only used for
+ * models supporting it (see Model::supportsSinglePassCodonSpecificUpdate), the others keep evaluating one grouping
+ * after the other. For those models the results only differ from the default by floating point rounding.
+*/
+void MCMCAlgorithm::setSinglePassCodonSpecificParameterUpdate(bool in)
+{
+	singlePassCodonSpecificParameterUpdate = in;
+}
+
+
+/* isFusedGenomeTraversal (NOT EXPOSED)
+ * Arguments: None
+ * Return the boolean value for if codon specific and hyper parameters are updated with a fused genome traversal.
+*/
+bool MCMCAlgorithm::isFusedGenomeTraversal()
+{
+	return fusedGenomeTraversal;
+}
+
+
+/* setFusedGenomeTraversal (RCPP EXPOSED)
+ * Arguments: boolean describing if codon specific and hyper parameters should be updated with a fused genome traversal.
+ * If true and both are estimated, run uses acceptRejectCodonSpecificAndHyperParameter for models supporting it,
+ * which evaluates both in as few passes over the genome as possible. The chain is the same as without fusing.
+*/
+void MCMCAlgorithm::setFusedGenomeTraversal(bool in)
+{
+	fusedGenomeTraversal = in;
+}
+
+
+/* getGenomeTraversalTrace (RCPP EXPOSED)
+ * Arguments: None
+ * Return the number of passes over the genome made in each stored iteration.
+*/
+std::vector<unsigned> MCMCAlgorithm::getGenomeTraversalTrace()
+{
+	return genomeTraversalTrace;
+}
+
+
+/* getGenomeTraversalBytesTrace (RCPP EXPOSED)
+ * Arguments: None
+ * Return the estimated number of bytes of gene data read in each stored iteration.
+*/
+std::vector<double> MCMCAlgorithm::getGenomeTraversalBytesTrace()
+{
+	return genomeTraversalBytesTrace;
+}
+
+
+/* isProfiling (RCPP EXPOSED)
+ * Arguments: None
+ * Returns true if run records the time spent in and the acceptances of each phase of an iteration.
+*/
+bool MCMCAlgorithm::isProfiling()
+{
+	return profiling;
+}
+
+
+/* setProfiling (RCPP EXPOSED)
+ * Arguments: bool
+ * Turns the per phase profiling of run on or off. The profile is reset at the start of every run. When off, run does
+ * not read the clock at all.
+*/
+void MCMCAlgorithm::setProfiling(bool in)
+{
+	profiling = in;
+}
+
+
+/* resetProfile (RCPP EXPOSED)
+ * Arguments: None
+ * Sets the wall time, call, proposal and acceptance counters of all phases back to zero.
+*/
+void MCMCAlgorithm::resetProfile()
+{
+	profileTimes.assign(numProfilePhases, 0.0);
+	profileCalls.assign(numProfilePhases, 0.0);
+	profileProposals.assign(numProfilePhases, 0.0);
+	profileAcceptances.assign(numProfilePhases, 0.0);
+}
+
+
+/* getProfilePhaseNames (RCPP EXPOSED)
+ * Arguments: None
+ * Returns the names of the profiled phases, in the order used by the other profile getters.
+*/
+std::vector<std::string> MCMCAlgorithm::getProfilePhaseNames()
+{
+	std::vector<std::string> names(numProfilePhases);
+	names[codonSpecificProposalPhase] = "codon_specific_proposal";
+	names[codonSpecificAcceptRejectPhase] = "codon_specific_accept_reject";
+	names[hyperParameterUpdatePhase] = "hyper_parameter_update";
+	names[synthesisRateUpdatePhase] = "synthesis_rate_update";
+	names[traceWritePhase] = "trace_write";
+	names[restartFileWritePhase] = "restart_file_write";
+	return names;
+}
+
+
+/* getProfileTimes (RCPP EXPOSED)
+ * Arguments: None
+ * Returns the wall time in seconds spent in each phase during the last run.
+*/
+std::vector<double> MCMCAlgorithm::getProfileTimes()
+{
+	return profileTimes;
+}
+
+
+/* getProfileCalls (RCPP EXPOSED)
+ * Arguments: None
+ * Returns how often each phase was executed during the last run.
+*/
+std::vector<double> MCMCAlgorithm::getProfileCalls()
+{
+	return profileCalls;
+}
+
+
+/* getProfileProposals (RCPP EXPOSED)
+ * Arguments: None
+ * Returns the number of proposals evaluated by each phase during the last run (groupings, hyper parameters or
+ * gene and category pairs). Phases without proposals stay at zero.
+*/
+std::vector<double> MCMCAlgorithm::getProfileProposals()
+{
+	return profileProposals;
+}
+
+
+/* getProfileAcceptances (RCPP EXPOSED)
+ * Arguments: None
+ * Returns the number of accepted proposals of each phase during the last run.
+*/
+std::vector<double> MCMCAlgorithm::getProfileAcceptances()
+{
+	return profileAcceptances;
+}
+
+
+/* writeProfile (RCPP EXPOSED)
+ * Arguments: file name, bool for JSON (true) or CSV (false) output
+ * Writes one record per phase with its name, calls, wall time in seconds, proposals and acceptances.
+*/
+void MCMCAlgorithm::writeProfile(std::string filename, bool json)
+{
+	std::ofstream out(filename.c_str());
+	if (!out)
+	{
+		my_printError("ERROR: Could not open file % to write the profile\n", filename);
+		return;
+	}
+
+	std::vector<std::string> names = getProfilePhaseNames();
+	out.precision(10);
+	if (json)
+	{
+		out << "[\n";
+		for (unsigned i = 0u; i < numProfilePhases; i++)
+		{
+			out << "  {\"phase\": \"" << names[i] << "\", \"calls\": " << profileCalls[i] << ", \"seconds\": "
+				<< profileTimes[i] << ", \"proposals\": " << profileProposals[i] << ", \"acceptances\": "
+				<< profileAcceptances[i] << "}" << (i + 1u < numProfilePhases ? "," : "") << "\n";
+		}
+		out << "]\n";
+	}
+	else
+	{
+		out << "phase,calls,seconds,proposals,acceptances\n";
+		for (unsigned i = 0u; i < numProfilePhases; i++)
+		{
+			out << names[i] << "," << profileCalls[i] << "," << profileTimes[i] << "," << profileProposals[i] << ","
+				<< profileAcceptances[i] << "\n";
+		}
+	}
+	out.close();
+}
+
+
+/* startProfilePhase (NOT EXPOSED)
+ * Arguments: None
+ * Returns the current time if profiling, a default constructed time point otherwise.
+*/
+std::chrono::steady_clock::time_point MCMCAlgorithm::startProfilePhase()
+{
+	return profiling ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+}
+
+
+/* recordProfilePhase (NOT EXPOSED)
+ * Arguments: phase index, time point returned by startProfilePhase
+ * Adds one call and the time passed since start to the phase. Does nothing if not profiling.
+*/
+void MCMCAlgorithm::recordProfilePhase(unsigned phase, std::chrono::steady_clock::time_point start)
+{
+	if (!profiling)
+		return;
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	profileTimes[phase] += elapsed.count();
+	profileCalls[phase] += 1.0;
+}
+
+
+/* recordProfileAcceptances (NOT EXPOSED)
+ * Arguments: phase index, number of proposals evaluated, number of proposals accepted
+ * Adds to the proposal and acceptance counters of the phase. Does nothing if not profiling.
+*/
+void MCMCAlgorithm::recordProfileAcceptances(unsigned phase, unsigned proposals, unsigned accepted)
+{
+	if (!profiling)
+		return;
+	profileProposals[phase] += proposals;
+	profileAcceptances[phase] += accepted;
+}
+
+
 /* getLogPosteriorTrace (RCPP EXPOSED)
  * Arguments: None
  * Return the log posterior trace.
@@ -1097,6 +1573,19 @@ RCPP_MODULE(MCMCAlgorithm_mod)
 		//MCMC Functions:
 		.method("run", &MCMCAlgorithm::run)
 		.method("setEstimateMixtureAssignment", &MCMCAlgorithm::setEstimateMixtureAssignment)
+		.method("setSinglePassCodonSpecificParameterUpdate", &MCMCAlgorithm::setSinglePassCodonSpecificParameterUpdate)
+		.method("setFusedGenomeTraversal", &MCMCAlgorithm::setFusedGenomeTraversal)
+		.method("getGenomeTraversalTrace", &MCMCAlgorithm::getGenomeTraversalTrace)
+		.method("getGenomeTraversalBytesTrace", &MCMCAlgorithm::getGenomeTraversalBytesTrace)
+		.method("isProfiling", &MCMCAlgorithm::isProfiling)
+		.method("setProfiling", &MCMCAlgorithm::setProfiling)
+		.method("resetProfile", &MCMCAlgorithm::resetProfile)
+		.method("getProfilePhaseNames", &MCMCAlgorithm::getProfilePhaseNames)
+		.method("getProfileTimes", &MCMCAlgorithm::getProfileTimes)
+		.method("getProfileCalls", &MCMCAlgorithm::getProfileCalls)
+		.method("getProfileProposals", &MCMCAlgorithm::getProfileProposals)
+		.method("getProfileAcceptances", &MCMCAlgorithm::getProfileAcceptances)
+		.method("writeProfile", &MCMCAlgorithm::writeProfile)
 		.method("setRestartFileSettings", &MCMCAlgorithm::setRestartFileSettings)
 		.method("getLogPosteriorTrace", &MCMCAlgorithm::getLogPosteriorTrace)
 		.method("getLogLikelihoodTrace", &MCMCAlgorithm::getLogLikelihoodTrace)
@@ -3,6 +3,9 @@
 Model::Model()
 {
 //ctor
+	useLogLikelihoodCache = false;
+	numGenomeTraversals = 0u;
+	genomeTraversalBytes = 0.0;
 }
 
 // TODO: Rule of Three dictates we may need a copy assignment operator as well (operator=)
@@ -12,6 +15,176 @@ Model::~Model()
 //dtor
 }
 
+
+/* prepareForCodonSpecificParameterUpdate (NOT EXPOSED)
+ * Arguments: reference to the genome
+ * Called by MCMCAlgorithm once per iteration before the codon specific parameters are accepted or rejected.
+ * Models that keep state derived from phi values or mixture assignments can refresh it here. Does nothing by default.
+*/
+void Model::prepareForCodonSpecificParameterUpdate(Genome & /*genome*/)
+{
+}
+
+/* calculateLogLikelihoodRatioForAllGroupings (NOT EXPOSED)
+ * Arguments: reference to the genome, vector receiving the result of calculateLogLikelihoodRatioPerGroupingPerCategory
+ * for each grouping (in group list order).
+ * Used by MCMCAlgorithm to evaluate all groupings before any of them is accepted or rejected, which is only valid for
+ * models that return true in supportsSinglePassCodonSpecificUpdate.
+ * By default the groupings are evaluated one by one, models can override this with a single pass over the genome.
+*/
+void Model::calculateLogLikelihoodRatioForAllGroupings(Genome& genome, std::vector<std::vector<double>> &logAcceptanceRatioForAllGroupings)
+{
+	unsigned numGroupings = getGroupListSize();
+	logAcceptanceRatioForAllGroupings.resize(numGroupings);
+	for (unsigned i = 0u; i < numGroupings; i++)
+	{
+		logAcceptanceRatioForAllGroupings[i].resize(5, 0.0);
+		calculateLogLikelihoodRatioPerGroupingPerCategory(getGrouping(i), genome, logAcceptanceRatioForAllGroupings[i]);
+	}
+}
+
+
+/* supportsSinglePassCodonSpecificUpdate (NOT EXPOSED)
+ * Arguments: None
+ * Returns true if the log acceptance ratio of a grouping does not depend on the current codon specific parameters of
+ * the other groupings. Only then MCMCAlgorithm may evaluate all groupings with
+ * calculateLogLikelihoodRatioForAllGroupings before accepting any of them. False by default.
+*/
+bool Model::supportsSinglePassCodonSpecificUpdate()
+{
+	return false;
+}
+
+
+/* supportsFusedGenomeTraversal (NOT EXPOSED)
+ * Arguments: None
+ * Returns true if the log acceptance ratios of the hyper parameters do not depend on the codon specific parameters,
+ * and the log acceptance ratios of the codon specific parameters do not depend on the hyper parameters. Only then
+ * MCMCAlgorithm may evaluate both with calculateLogLikelihoodRatioForAllGroupingsAndHyperParameters before accepting
+ * either of them. False by default.
+*/
+bool Model::supportsFusedGenomeTraversal()
+{
+	return false;
+}
+
+
+/* calculateLogLikelihoodRatioForAllGroupingsAndHyperParameters (NOT EXPOSED)
+ * Arguments: reference to the genome, current iteration, vector receiving the log acceptance ratios of all
+ * groupings (see calculateLogLikelihoodRatioForAllGroupings), vector receiving the log acceptance ratios of the hyper
+ * parameters (see calculateLogLikelihoodRatioForHyperParameters).
+ * Evaluates the proposed codon specific parameters and the proposed hyper parameters together. By default the two are
+ * calculated one after the other, models supporting fused traversal evaluate both in one pass over the genome.
+*/
+void Model::calculateLogLikelihoodRatioForAllGroupingsAndHyperParameters(Genome &genome, unsigned iteration,
+	std::vector<std::vector<double>> &logAcceptanceRatioForAllGroupings, std::vector <double> &logProbabilityRatio)
+{
+	calculateLogLikelihoodRatioForAllGroupings(genome, logAcceptanceRatioForAllGroupings);
+	calculateLogLikelihoodRatioForHyperParameters(genome, iteration, logProbabilityRatio);
+}
+
+
+/* setLogLikelihoodCacheMode (RCPP EXPOSED)
+ * Arguments: whether to cache the per gene log likelihood terms
+ * With the cache, calculateLogLikelihoodRatioPerGene reuses the terms of the current synthesis rate for every grouping
+ * whose codon specific parameters were not updated since the terms were calculated, and keeps the terms of the
+ * proposed synthesis rate in case the proposal is accepted. Results are identical with and without the cache, the
+ * cache trades memory (two doubles per gene, mixture element and grouping) for fewer likelihood evaluations. It is off
+ * by default, so that only runs asking for it pay for that memory (about 1 KB per gene and mixture element for PA).
+ * Takes effect with the next run of the MCMC.
+*/
+void Model::setLogLikelihoodCacheMode(bool _useLogLikelihoodCache)
+{
+	useLogLikelihoodCache = _useLogLikelihoodCache;
+	logLikelihoodCache.clear();
+}
+
+
+/* initLogLikelihoodCache (NOT EXPOSED)
+ * Arguments: number of genes
+ * Allocates an empty cache if it is enabled. Called from initTraces at the start of a run, outside of parallel regions.
+*/
+void Model::initLogLikelihoodCache(unsigned numGenes)
+{
+	if (useLogLikelihoodCache)
+		logLikelihoodCache.init(numGenes, getNumMixtureElements(), getGroupListSize());
+	else
+		logLikelihoodCache.clear();
+}
+
+
+/* invalidateLogLikelihoodCache (NOT EXPOSED)
+ * Arguments: grouping (AA or codon)
+ * Marks the cached terms of the grouping as outdated. Called whenever the codon specific parameters of the grouping are accepted.
+*/
+void Model::invalidateLogLikelihoodCache(std::string grouping)
+{
+	unsigned numGroupings = getGroupListSize();
+	for (unsigned i = 0u; i < numGroupings; i++)
+	{
+		if (getGrouping(i) == grouping)
+		{
+			logLikelihoodCache.invalidateGrouping(i);
+			break;
+		}
+	}
+}
+
+
+/* countSynthesisRateTraversal (NOT EXPOSED)
+ * Arguments: number of genes
+ * Records the pass over the genome made by the synthesis rate update in MCMCAlgorithm. The default estimate covers the
+ * current and proposed synthesis rate of every category and the mixture assignment of each gene, models add the
+ * gene data read by calculateLogLikelihoodRatioPerGene.
+*/
+void Model::countSynthesisRateTraversal(unsigned numGenes)
+{
+	countGenomeTraversal(numGenes, getNumSynthesisRateCategories() * 2u * sizeof(double) + sizeof(unsigned));
+}
+
+
+/* resetGenomeTraversalCounters (NOT EXPOSED)
+ * Arguments: None
+ * Sets the number of genome traversals and the bytes touched back to zero. MCMCAlgorithm resets them every iteration.
+*/
+void Model::resetGenomeTraversalCounters()
+{
+	numGenomeTraversals = 0u;
+	genomeTraversalBytes = 0.0;
+}
+
+
+/* getNumGenomeTraversals (NOT EXPOSED)
+ * Arguments: None
+ * Returns the number of passes over the genome since the last reset.
+*/
+unsigned Model::getNumGenomeTraversals()
+{
+	return numGenomeTraversals;
+}
+
+
+/* getGenomeTraversalBytes (NOT EXPOSED)
+ * Arguments: None
+ * Returns the estimated number of bytes of gene data read since the last reset.
+*/
+double Model::getGenomeTraversalBytes()
+{
+	return genomeTraversalBytes;
+}
+
+
+/* countGenomeTraversal (NOT EXPOSED)
+ * Arguments: number of genes, estimated bytes read per gene
+ * Records one pass over the genome. Call outside of parallel regions.
+*/
+void Model::countGenomeTraversal(unsigned numGenes, unsigned bytesPerGene)
+{
+	numGenomeTraversals++;
+	genomeTraversalBytes += (double)numGenes * bytesPerGene;
+}
+
+
 //Cedric: This functions will replace calculateMutationPrior in ROC/FONSE model and allows us to more generally use priors on codon specific parameters.
 //			We have to first change how current and proposed csp values are stored to move the function getParameterForCategory up into the base parameter class.
 
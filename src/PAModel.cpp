@@ -28,9 +28,25 @@ PAModel::~PAModel()
 double PAModel::calculateLogLikelihoodPerCodonPerGene(double currAlpha, double currLambdaPrime, unsigned currRFPValue,
                                                       unsigned currNumCodonsInMRNA, double phiValue)
 {
-	double logLikelihood = ((std::lgamma((currNumCodonsInMRNA * currAlpha) + currRFPValue)) - (std::lgamma(currNumCodonsInMRNA * currAlpha)))
-						   + (currRFPValue * (std::log(phiValue) - std::log(currLambdaPrime + phiValue)))
-						   + ((currNumCodonsInMRNA * currAlpha) * (std::log(currLambdaPrime) - std::log(currLambdaPrime + phiValue)));
+	double alphaTimesCodonCount = currNumCodonsInMRNA * currAlpha;
+	return calculateLogLikelihoodPerCodonPerGene(LogRisingFactorialTable::calculate(alphaTimesCodonCount, currRFPValue),
+		alphaTimesCodonCount, currLambdaPrime, std::log(currLambdaPrime), currRFPValue, phiValue, std::log(phiValue));
+}
+
+
+/* calculateLogLikelihoodPerCodonPerGene (NOT EXPOSED)
+ * Arguments: lgamma(alpha * codon count + RFP count) - lgamma(alpha * codon count), alpha times the codon count,
+ * lambda prime and its log, RFP count, phi and its log
+ * Same as above, but takes the terms that are shared between calls precalculated. The rising factorial does not depend
+ * on phi and the log of phi does not depend on the codon, so they are only calculated once per gene and codon.
+*/
+double PAModel::calculateLogLikelihoodPerCodonPerGene(double logRisingFactorial, double alphaTimesCodonCount,
+	double currLambdaPrime, double logLambdaPrime, unsigned currRFPValue, double phiValue, double logPhi)
+{
+	double logDenominator = std::log(currLambdaPrime + phiValue);
+	double logLikelihood = logRisingFactorial
+						   + (currRFPValue * (logPhi - logDenominator))
+						   + (alphaTimesCodonCount * (logLambdaPrime - logDenominator));
 
 	return logLikelihood;
 }
@@ -57,22 +73,49 @@ void PAModel::calculateLogLikelihoodRatioPerGene(Gene& gene, unsigned geneIndex,
 	double phiValue = parameter->getSynthesisRate(geneIndex, synthesisRateCategory, false);
 	double phiValue_proposed = parameter->getSynthesisRate(geneIndex, synthesisRateCategory, true);
 
+	double logPhi = std::log(phiValue);
+	double logPhi_proposed = std::log(phiValue_proposed);
+
+	bool useCache = useLogLikelihoodCache && logLikelihoodCache.hasEntry(geneIndex, k);
+	if (useCache)
+	{
+		logLikelihoodCache.setCurrentPhi(geneIndex, k, phiValue);
+		logLikelihoodCache.setProposedPhi(geneIndex, k, phiValue_proposed);
+	}
+
 #ifdef _OPENMP
 //#ifndef __APPLE__
 #pragma omp parallel for reduction(+:logLikelihood,logLikelihood_proposed)
 #endif
 	for (unsigned index = 0; index < getGroupListSize(); index++) //number of codons, without the stop codons
 	{
-		std::string codon = getGrouping(index);
-
-		double currAlpha = getParameterForCategory(alphaCategory, PAParameter::alp, codon, false);
-		double currLambdaPrime = getParameterForCategory(lambdaPrimeCategory, PAParameter::lmPri, codon, false);
+		// the groupings of PA are the 61 sense codons in codon index order
+		double currAlpha = getParameterForCategory(alphaCategory, PAParameter::alp, index, false);
+		double currLambdaPrime = getParameterForCategory(lambdaPrimeCategory, PAParameter::lmPri, index, false);
 		unsigned currRFPValue = gene.geneData.getCodonSpecificSumRFPCount(index, RFPCountColumn);
 		unsigned currNumCodonsInMRNA = gene.geneData.getCodonCountForCodon(index);
 		if (currNumCodonsInMRNA == 0) continue;
 
-		logLikelihood += calculateLogLikelihoodPerCodonPerGene(currAlpha, currLambdaPrime, currRFPValue, currNumCodonsInMRNA, phiValue);
-		logLikelihood_proposed += calculateLogLikelihoodPerCodonPerGene(currAlpha, currLambdaPrime, currRFPValue, currNumCodonsInMRNA, phiValue_proposed);
+		// the rising factorial does not depend on phi, the same for the current and the proposed value
+		double alphaTimesCodonCount = currNumCodonsInMRNA * currAlpha;
+		double logRisingFactorial = LogRisingFactorialTable::calculate(alphaTimesCodonCount, currRFPValue);
+		double logLambdaPrime = std::log(currLambdaPrime);
+
+		double currLogLikelihood;
+		if (!useCache || !logLikelihoodCache.getCurrent(geneIndex, k, index, currLogLikelihood))
+		{
+			currLogLikelihood = calculateLogLikelihoodPerCodonPerGene(logRisingFactorial, alphaTimesCodonCount,
+				currLambdaPrime, logLambdaPrime, currRFPValue, phiValue, logPhi);
+			if (useCache)
+				logLikelihoodCache.setCurrent(geneIndex, k, index, currLogLikelihood);
+		}
+		double propLogLikelihood = calculateLogLikelihoodPerCodonPerGene(logRisingFactorial, alphaTimesCodonCount,
+			currLambdaPrime, logLambdaPrime, currRFPValue, phiValue_proposed, logPhi_proposed);
+		if (useCache)
+			logLikelihoodCache.setProposed(geneIndex, k, index, propLogLikelihood);
+
+		logLikelihood += currLogLikelihood;
+		logLikelihood_proposed += propLogLikelihood;
 	}
 
 	double stdDevSynthesisRate = parameter->getStdDevSynthesisRate(lambdaPrimeCategory, false);
@@ -122,19 +165,27 @@ void PAModel::calculateLogLikelihoodRatioPerGroupingPerCategory(std::string grou
 		if (currNumCodonsInMRNA == 0) continue;
 
 
-		currAlpha = getParameterForCategory(alphaCategory, PAParameter::alp, grouping, false);
-		currLambdaPrime = getParameterForCategory(lambdaPrimeCategory, PAParameter::lmPri, grouping, false);
+		currAlpha = getParameterForCategory(alphaCategory, PAParameter::alp, index, false);
+		currLambdaPrime = getParameterForCategory(lambdaPrimeCategory, PAParameter::lmPri, index, false);
 
-		propAlpha = getParameterForCategory(alphaCategory, PAParameter::alp, grouping, true);
-		propLambdaPrime = getParameterForCategory(lambdaPrimeCategory, PAParameter::lmPri, grouping, true);
+		propAlpha = getParameterForCategory(alphaCategory, PAParameter::alp, index, true);
+		propLambdaPrime = getParameterForCategory(lambdaPrimeCategory, PAParameter::lmPri, index, true);
 
-		logLikelihood += calculateLogLikelihoodPerCodonPerGene(currAlpha, currLambdaPrime, currRFPValue, currNumCodonsInMRNA, phiValue);
-		logLikelihood_proposed += calculateLogLikelihoodPerCodonPerGene(propAlpha, propLambdaPrime, currRFPValue, currNumCodonsInMRNA, phiValue);
+		double logPhi = std::log(phiValue);
+		double currAlphaTimesCodonCount = currNumCodonsInMRNA * currAlpha;
+		double propAlphaTimesCodonCount = currNumCodonsInMRNA * propAlpha;
+		logLikelihood += calculateLogLikelihoodPerCodonPerGene(
+			LogRisingFactorialTable::calculate(currAlphaTimesCodonCount, currRFPValue), currAlphaTimesCodonCount,
+			currLambdaPrime, std::log(currLambdaPrime), currRFPValue, phiValue, logPhi);
+		logLikelihood_proposed += calculateLogLikelihoodPerCodonPerGene(
+			LogRisingFactorialTable::calculate(propAlphaTimesCodonCount, currRFPValue), propAlphaTimesCodonCount,
+			propLambdaPrime, std::log(propLambdaPrime), currRFPValue, phiValue, logPhi);
 
 		if(i == 0 and (grouping == "GCA" or grouping == "GCT")){
 		    my_print("%:\nAlpha: %\nLambda: %\nProp Alpha: %\nProp Lambda: %\nPhi: %\nRFP Count: %\nnumCodons: %\n\n",grouping, currAlpha, currLambdaPrime,propAlpha,propLambdaPrime, phiValue, currRFPValue,currNumCodonsInMRNA);
 		}
 	}
+	countGenomeTraversal(genome.getGenomeSize(), sizeof(double) + 3 * sizeof(unsigned));
 	logAcceptanceRatioForAllMixtures[0] = logLikelihood_proposed - logLikelihood - ((std::log(currAlpha) + std::log(currLambdaPrime))
                                                                         - (std::log(propAlpha) + std::log(propLambdaPrime)));
 	logAcceptanceRatioForAllMixtures[1] = logLikelihood - (std::log(propAlpha) + std::log(propLambdaPrime));
@@ -144,6 +195,17 @@ void PAModel::calculateLogLikelihoodRatioPerGroupingPerCategory(std::string grou
 }
 
 
+/* supportsSinglePassCodonSpecificUpdate (NOT EXPOSED)
+ * Arguments: None
+ * The log acceptance ratio of a codon only depends on its own alpha and lambda prime and phi, see
+ * Model::supportsSinglePassCodonSpecificUpdate.
+*/
+bool PAModel::supportsSinglePassCodonSpecificUpdate()
+{
+	return true;
+}
+
+
 void PAModel::calculateLogLikelihoodRatioForHyperParameters(Genome &genome, unsigned iteration, std::vector <double> & logProbabilityRatio)
 {
 
@@ -181,6 +243,7 @@ void PAModel::calculateLogLikelihoodRatioForHyperParameters(Genome &genome, unsi
 				Parameter::densityLogNorm(phi, currentMphi[mixture], currentStdDevSynthesisRate[mixture], true);
 		//my_print("LPR: %\n", lpr);
 	}
+	countGenomeTraversal(genome.getGenomeSize(), sizeof(double) + sizeof(unsigned));
 
 	logProbabilityRatio[0] = lpr;
 }
@@ -197,6 +260,7 @@ void PAModel::calculateLogLikelihoodRatioForHyperParameters(Genome &genome, unsi
 void PAModel::initTraces(unsigned samples, unsigned num_genes, bool estimateSynthesisRate)
 {
 	parameter->initAllTraces(samples, num_genes, estimateSynthesisRate);
+	initLogLikelihoodCache(num_genes);
 }
 
 
@@ -356,6 +420,12 @@ void PAModel::updateMixtureAssignmentTrace(unsigned sample, unsigned i)
 }
 
 
+void PAModel::updateSynthesisRateTraces(unsigned sample)
+{
+	parameter->updateSynthesisRateTraces(sample);
+}
+
+
 void PAModel::updateMixtureProbabilitiesTrace(unsigned sample)
 {
 	parameter->updateMixtureProbabilitiesTrace(sample);
@@ -374,15 +444,11 @@ void PAModel::updateHyperParameterTraces(unsigned sample)
 }
 
 
-void PAModel::updateTracesWithInitialValues(Genome & genome)
+void PAModel::updateTracesWithInitialValues(Genome & /*genome*/)
 {
 	std::vector <std::string> groupList = parameter->getGroupList();
 
-	for (unsigned i = 0; i < genome.getGenomeSize(); i++)
-	{
-		parameter->updateSynthesisRateTrace(0, i);
-		parameter->updateMixtureAssignmentTrace(0, i);
-	}
+	updateSynthesisRateTraces(0);
 
 	for (unsigned i = 0; i < groupList.size(); i++)
 	{
@@ -391,6 +457,18 @@ void PAModel::updateTracesWithInitialValues(Genome & genome)
 }
 
 
+bool PAModel::flushTraces()
+{
+	return parameter->flushTraces();
+}
+
+
+bool PAModel::hasTraceFileWriteFailed()
+{
+	return parameter->hasTraceFileWriteFailed();
+}
+
+
 
 
 
@@ -494,6 +572,7 @@ void PAModel::setCategoryProbability(unsigned mixture, double value)
 void PAModel::updateCodonSpecificParameter(std::string aa)
 {
 	parameter->updateCodonSpecificParameter(aa);
+	invalidateLogLikelihoodCache(aa);
 }
 
 void PAModel::updateGibbsSampledHyperParameters(Genome &genome)
@@ -533,14 +612,13 @@ void PAModel::simulateGenome(Genome &genome)
 		Gene tmpGene = gene;
 		for (unsigned codonIndex = 0u; codonIndex < 61; codonIndex++)
 		{
-			std::string codon = SequenceSummary::codonArray[codonIndex];
 			unsigned alphaCat = parameter->getMutationCategory(mixtureElement);
 			unsigned lambdaPrimeCat = parameter->getSelectionCategory(mixtureElement);
 
-			double alpha = getParameterForCategory(alphaCat, PAParameter::alp, codon, false);
-			double lambdaPrime = getParameterForCategory(lambdaPrimeCat, PAParameter::lmPri, codon, false);
+			double alpha = getParameterForCategory(alphaCat, PAParameter::alp, codonIndex, false);
+			double lambdaPrime = getParameterForCategory(lambdaPrimeCat, PAParameter::lmPri, codonIndex, false);
 
-			double alphaPrime = alpha * gene.geneData.getCodonCountForCodon(codon);
+			double alphaPrime = alpha * gene.geneData.getCodonCountForCodon(codonIndex);
 
 #ifndef STANDALONE
 			RNGScope scope;
@@ -575,6 +653,7 @@ void PAModel::printHyperParameters()
 //TODO: Assumed single mixture correct this and label values
 void PAModel::printCodonSpecificParameters()
 {
+#ifndef STANDALONE
     std::vector<std::vector<double>> alphas = parameter->getCurrentAlphaParameter();
     std::vector<std::vector<double>> lambdaPrimes = parameter->getCurrentLambdaPrimeParameter();
 
@@ -586,6 +665,7 @@ void PAModel::printCodonSpecificParameters()
 	    	my_print("Lambda Prime  estimate for selection category %: %\n", i, lambdaPrimes[i][j]);
         }
 	}
+#endif
 }
 
 /* getParameter (RCPP EXPOSED)
@@ -619,3 +699,9 @@ double PAModel::getParameterForCategory(unsigned category, unsigned param, std::
 {
 	return parameter->getParameterForCategory(category, param, codon, proposal);
 }
+
+
+double PAModel::getParameterForCategory(unsigned category, unsigned param, unsigned codonIndex, bool proposal)
+{
+	return parameter->getParameterForCategory(category, param, codonIndex, proposal);
+}
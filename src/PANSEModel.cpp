@@ -10,10 +10,24 @@ using namespace Rcpp;
 //----------- Constructors & Destructors ---------- //
 //--------------------------------------------------//
 
+const unsigned PANSEModel::maxTabulatedRFPCount = 255u;
+const unsigned PANSEModel::maxIncompleteGammaIterations = 1000u;
+
+
+/* PANSEModel constructor (RCPP EXPOSED)
+ * Arguments: RFP count column to read (starting at 1, default 1)
+ * Column 0 does not exist and is treated as column 1.
+*/
 PANSEModel::PANSEModel(unsigned _RFPCountColumn) : Model()
 {
     parameter = NULL;
+    if (_RFPCountColumn == 0u)
+    {
+        my_printError("Warning: RFP count columns start at 1, using column 1.\n");
+        _RFPCountColumn = 1u;
+    }
     RFPCountColumn = _RFPCountColumn - 1;
+    indexedGenome = NULL;
     //ctor
 }
 
@@ -29,9 +43,25 @@ PANSEModel::~PANSEModel()
 double PANSEModel::calculateLogLikelihoodPerCodonPerGene(double currAlpha, double currLambdaPrime,
         unsigned currRFPObserved, double phiValue, double prevSigma)
 {
-    double term1 = std::lgamma(currAlpha + currRFPObserved) - lgamma(currAlpha);
-    double term2 = std::log(phiValue) + std::log(prevSigma) - std::log(currLambdaPrime + (phiValue * prevSigma));
-    double term3 = std::log(currLambdaPrime) - std::log(currLambdaPrime + (phiValue * prevSigma));
+    return calculateLogLikelihoodPerCodonPerGene(LogRisingFactorialTable::calculate(currAlpha, currRFPObserved),
+        currAlpha, currLambdaPrime, std::log(currLambdaPrime), currRFPObserved, phiValue, std::log(phiValue), prevSigma);
+}
+
+
+/* calculateLogLikelihoodPerCodonPerGene (NOT EXPOSED)
+ * Arguments: lgamma(alpha + RFP count) - lgamma(alpha), alpha, lambda prime and its log, RFP count, phi and its log,
+ * sigma
+ * Same as above, but takes the terms that do not change from position to position precalculated, so the caller can
+ * look the rising factorial up in alphaLogRisingFactorial and take the logs once per codon or gene.
+*/
+double PANSEModel::calculateLogLikelihoodPerCodonPerGene(double logRisingFactorial, double currAlpha,
+        double currLambdaPrime, double logLambdaPrime, unsigned currRFPObserved, double phiValue, double logPhi,
+        double prevSigma)
+{
+    double logDenominator = std::log(currLambdaPrime + (phiValue * prevSigma));
+    double term1 = logRisingFactorial;
+    double term2 = logPhi + std::log(prevSigma) - logDenominator;
+    double term3 = logLambdaPrime - logDenominator;
 
     term2 *= currRFPObserved;
     term3 *= currAlpha;
@@ -43,6 +73,185 @@ double PANSEModel::calculateLogLikelihoodPerCodonPerGene(double currAlpha, doubl
 }
 
 
+/* updateCodonOccurrenceIndex (NOT EXPOSED)
+ * Arguments: reference to the genome
+ * Builds the inverted index used by calculateLogLikelihoodRatioPerGroupingPerCategory: for every codon, the genes
+ * containing it and the position and RFP count of each occurrence (taken from SequenceSummary::getCodonPositions and
+ * the RFPCountColumn the model is bound to). The codon and RFP count of every position are also stored in genome
+ * order (positionCodon, positionRFPCount), missing counts as -1.
+ * The index is only rebuilt if the genome or the number of positions of a gene changed since the last call, together
+ * with it alphaLogRisingFactorial is sized for the largest RFP count (up to maxTabulatedRFPCount).
+ * Afterwards the mixture assignments are compared to the ones the sigma prefix sums were calculated with, if one
+ * changed all prefix sums are recalculated by the next call to updateSigmaPrefixSums.
+*/
+void PANSEModel::updateCodonOccurrenceIndex(Genome &genome)
+{
+    unsigned numGenes = genome.getGenomeSize();
+    unsigned numCodons = getGroupListSize();
+    bool rebuild = (indexedGenome != &genome || genePositionOffset.size() != numGenes + 1);
+    unsigned numPositions = 0u;
+
+    for (unsigned i = 0u; i < numGenes; i++)
+    {
+        numPositions += genome.getGene(i).geneData.getPositionCodonIDReference().size();
+        if (!rebuild && genePositionOffset[i + 1] != numPositions) rebuild = true;
+    }
+
+    if (rebuild)
+    {
+        genePositionOffset.assign(numGenes + 1, 0u);
+        geneCodonMask.assign(numGenes, 0u);
+        codonOccurrenceGenes.assign(numCodons, std::vector <unsigned>());
+        codonOccurrenceGeneOffset.assign(numCodons, std::vector <unsigned>());
+        codonOccurrencePosition.assign(numCodons, std::vector <unsigned>());
+        codonOccurrenceRFPCount.assign(numCodons, std::vector <int>());
+        positionCodon.assign(numPositions, 0u);
+        positionRFPCount.assign(numPositions, -1);
+
+        for (unsigned i = 0u; i < numGenes; i++)
+        {
+            Gene *gene = &genome.getGene(i);
+            const std::vector <unsigned> &positions = gene->geneData.getPositionCodonIDReference();
+            const int *rfpCounts = gene->geneData.getRFPCountData(RFPCountColumn);
+            unsigned numRFPCounts = gene->geneData.getRFPCountSize(RFPCountColumn);
+            genePositionOffset[i + 1] = genePositionOffset[i] + positions.size();
+            for (unsigned positionIndex = 0u; positionIndex < positions.size(); positionIndex++)
+            {
+                geneCodonMask[i] |= (uint64_t)1 << positions[positionIndex];
+                positionCodon[genePositionOffset[i] + positionIndex] = (unsigned char)positions[positionIndex];
+                if (positionIndex < numRFPCounts)
+                    positionRFPCount[genePositionOffset[i] + positionIndex] = rfpCounts[positionIndex];
+            }
+
+            for (unsigned codonIndex = 0u; codonIndex < numCodons; codonIndex++)
+            {
+                if (gene->geneData.getCodonCountForCodon(codonIndex) == 0) continue;
+
+                codonOccurrenceGenes[codonIndex].push_back(i);
+                codonOccurrenceGeneOffset[codonIndex].push_back(codonOccurrencePosition[codonIndex].size());
+                std::vector <unsigned> *codonPositions = gene->geneData.getCodonPositions(codonIndex);
+                for (unsigned j = 0u; j < codonPositions->size(); j++)
+                {
+                    unsigned positionIndex = codonPositions->at(j);
+                    if (positionIndex >= positions.size() || positionIndex >= numRFPCounts) continue;
+                    codonOccurrencePosition[codonIndex].push_back(genePositionOffset[i] + positionIndex);
+                    codonOccurrenceRFPCount[codonIndex].push_back(rfpCounts[positionIndex]);
+                }
+            }
+        }
+        for (unsigned codonIndex = 0u; codonIndex < numCodons; codonIndex++)
+            codonOccurrenceGeneOffset[codonIndex].push_back(codonOccurrencePosition[codonIndex].size());
+
+        int maxRFPCount = 0;
+        for (unsigned codonIndex = 0u; codonIndex < numCodons; codonIndex++)
+        {
+            for (unsigned j = 0u; j < codonOccurrenceRFPCount[codonIndex].size(); j++)
+                maxRFPCount = std::max(maxRFPCount, codonOccurrenceRFPCount[codonIndex][j]);
+        }
+        alphaLogRisingFactorial.init(parameter->getNumMutationCategories(), numCodons,
+            std::min((unsigned)maxRFPCount, maxTabulatedRFPCount));
+
+        indexedGenome = &genome;
+        currSigmaPrefixSum.assign(numPositions, 0.0);
+        propSigmaPrefixSum.assign(numPositions, 0.0);
+        sigmaMixtureAssignment.clear();
+    }
+
+    bool mixturesChanged = (sigmaMixtureAssignment.size() != numGenes);
+    sigmaMixtureAssignment.resize(numGenes);
+    for (unsigned i = 0u; i < numGenes; i++)
+    {
+        unsigned mixtureElement = parameter->getMixtureAssignment(i);
+        if (sigmaMixtureAssignment[i] != mixtureElement)
+        {
+            sigmaMixtureAssignment[i] = mixtureElement;
+            mixturesChanged = true;
+        }
+    }
+    if (mixturesChanged)
+    {
+        currSigmaSummand.clear();
+        propSigmaSummand.clear();
+    }
+}
+
+
+/* updateSigmaPrefixSums (NOT EXPOSED)
+ * Arguments: reference to the genome, if the proposed or the current codon specific parameters should be used
+ * Calculates for every position the sum of alpha / (lambda * v) over the positions of the gene up to and including
+ * it, with lambda = lambdaPrime / U and v = 1 / NSERate, i.e. the sum elongationUntilIndexApproximation1Probability
+ * has reached at that position when started at the beginning of the gene. The terms only depend on the codon and the
+ * mixture element, so they are tabulated first. Only genes with a codon whose term changed are recalculated, after a
+ * codon specific parameter was accepted these are the genes containing that codon.
+ * Requires updateCodonOccurrenceIndex to be called first.
+*/
+void PANSEModel::updateSigmaPrefixSums(Genome &genome, bool proposed)
+{
+    unsigned numMixtures = getNumMixtureElements();
+    unsigned numCodons = getGroupListSize();
+
+    // stop codons are not part of the group list and do not contribute
+    std::vector <double> summand(numMixtures * 64, 0.0);
+    for (unsigned mixtureElement = 0u; mixtureElement < numMixtures; mixtureElement++)
+    {
+        double U = getPartitionFunction(mixtureElement, false)/genome.getSumRFP(RFPCountColumn);
+        unsigned alphaCategory = parameter->getMutationCategory(mixtureElement);
+        unsigned lambdaPrimeCategory = parameter->getSelectionCategory(mixtureElement);
+        for (unsigned codonIndex = 0u; codonIndex < numCodons; codonIndex++)
+        {
+            double alpha = getParameterForCategory(alphaCategory, PANSEParameter::alp, codonIndex, proposed);
+            double lambdaPrime = getParameterForCategory(lambdaPrimeCategory, PANSEParameter::lmPri, codonIndex, proposed);
+            double NSERate = getParameterForCategory(alphaCategory, PANSEParameter::nse, codonIndex, proposed);
+            summand[mixtureElement * 64 + codonIndex] = alpha / ((lambdaPrime / U) * (1 / NSERate));
+        }
+    }
+
+    std::vector <double> &currentSummand = proposed ? propSigmaSummand : currSigmaSummand;
+    if (summand == currentSummand) return;
+
+    // codons whose term changed, per mixture element (all of them if the prefix sums are not set up)
+    std::vector <uint64_t> changedCodons(numMixtures, ~(uint64_t)0);
+    if (currentSummand.size() == summand.size())
+    {
+        for (unsigned mixtureElement = 0u; mixtureElement < numMixtures; mixtureElement++)
+        {
+            changedCodons[mixtureElement] = 0u;
+            for (unsigned codonIndex = 0u; codonIndex < 64u; codonIndex++)
+            {
+                if (summand[mixtureElement * 64 + codonIndex] != currentSummand[mixtureElement * 64 + codonIndex])
+                    changedCodons[mixtureElement] |= (uint64_t)1 << codonIndex;
+            }
+        }
+    }
+    currentSummand.swap(summand);
+
+    std::vector <double> &prefixSum = proposed ? propSigmaPrefixSum : currSigmaPrefixSum;
+    const std::vector <double> &geneSummand = currentSummand;
+    unsigned numGenesUpdated = 0u;
+#ifdef _OPENMP
+    //#ifndef __APPLE__
+#pragma omp parallel for reduction(+:numGenesUpdated)
+#endif
+    for (unsigned i = 0u; i < genome.getGenomeSize(); i++)
+    {
+        if ((geneCodonMask[i] & changedCodons[sigmaMixtureAssignment[i]]) == 0u) continue;
+        numGenesUpdated++;
+
+        const std::vector <unsigned> &positions = genome.getGene(i).geneData.getPositionCodonIDReference();
+        const double *mixtureSummand = &geneSummand[sigmaMixtureAssignment[i] * 64];
+        double *genePrefixSum = prefixSum.data() + genePositionOffset[i];
+        double sum = 0.0;
+        for (unsigned positionIndex = 0u; positionIndex < positions.size(); positionIndex++)
+        {
+            sum += mixtureSummand[positions[positionIndex]];
+            genePrefixSum[positionIndex] = sum;
+        }
+    }
+    countGenomeTraversal(numGenesUpdated, sizeof(unsigned));
+}
+
+
+
 
 
 
@@ -86,25 +295,42 @@ void PANSEModel::calculateLogLikelihoodRatioPerGene(Gene& gene, unsigned geneInd
         logLikelihood_proposed += calculateLogLikelihoodPerCodonPerGene(currAlpha, currLambdaPrime, currRFPObserved, currNumCodonsInMRNA, phiValue_proposed);
     }*/
 
-    std::vector <unsigned> positions = gene.geneData.getPositionCodonID();
-    std::vector <int> rfpCounts = gene.geneData.getRFPCount(0);
-
-    for (unsigned index = 0; index < positions.size(); index++)
+    const std::vector <unsigned> &positions = gene.geneData.getPositionCodonIDReference();
+    const int *rfpCounts = gene.geneData.getRFPCountData(RFPCountColumn);
+    unsigned numPositions = std::min((unsigned)positions.size(), gene.geneData.getRFPCountSize(RFPCountColumn));
+    double logPhi = std::log(phiValue);
+    double logPhi_proposed = std::log(phiValue_proposed);
+    std::array <double, 64> logLambdaPrime;
+    logLambdaPrime.fill(0.0);
+    std::array <bool, 64> hasLogLambdaPrime;
+    hasLogLambdaPrime.fill(false);
+
+    for (unsigned index = 0; index < numPositions; index++)
     {
-        std::string codon = gene.geneData.indexToCodon(positions[index]);
+        unsigned codonIndex = positions[index];
 
-        double currAlpha = getParameterForCategory(alphaCategory, PANSEParameter::alp, codon, false);
-        double currLambdaPrime = getParameterForCategory(lambdaPrimeCategory, PANSEParameter::lmPri, codon, false);
-        double currNSERate = getParameterForCategory(alphaCategory, PANSEParameter::nse, codon, false);
+        double currAlpha = getParameterForCategory(alphaCategory, PANSEParameter::alp, codonIndex, false);
+        double currLambdaPrime = getParameterForCategory(lambdaPrimeCategory, PANSEParameter::lmPri, codonIndex, false);
+        double currNSERate = getParameterForCategory(alphaCategory, PANSEParameter::nse, codonIndex, false);
         //Should be rfp value at position not all of codon
         unsigned currRFPObserved = rfpCounts[index];
-        unsigned currNumCodonsInMRNA = gene.geneData.getCodonCountForCodon(codon);
+        unsigned currNumCodonsInMRNA = gene.geneData.getCodonCountForCodon(codonIndex);
         //This line will never execute
         if (currNumCodonsInMRNA == 0) continue;
 
+        if (!hasLogLambdaPrime[codonIndex])
+        {
+            logLambdaPrime[codonIndex] = std::log(currLambdaPrime);
+            hasLogLambdaPrime[codonIndex] = true;
+        }
+        // does not depend on phi, the same for the current and the proposed value
+        double logRisingFactorial = alphaLogRisingFactorial.get(alphaCategory, codonIndex, currAlpha, currRFPObserved);
+
         //Have to redo the math because rfp observed has changed
-        logLikelihood += calculateLogLikelihoodPerCodonPerGene(currAlpha, currLambdaPrime, currRFPObserved, phiValue, 1/currNSERate);
-        logLikelihood_proposed += calculateLogLikelihoodPerCodonPerGene(currAlpha, currLambdaPrime, currRFPObserved, phiValue_proposed, 1/currNSERate);
+        logLikelihood += calculateLogLikelihoodPerCodonPerGene(logRisingFactorial, currAlpha, currLambdaPrime,
+            logLambdaPrime[codonIndex], currRFPObserved, phiValue, logPhi, 1/currNSERate);
+        logLikelihood_proposed += calculateLogLikelihoodPerCodonPerGene(logRisingFactorial, currAlpha, currLambdaPrime,
+            logLambdaPrime[codonIndex], currRFPObserved, phiValue_proposed, logPhi_proposed, 1/currNSERate);
     }
 
     //Double check math here
@@ -124,38 +350,46 @@ void PANSEModel::calculateLogLikelihoodRatioPerGene(Gene& gene, unsigned geneInd
 }
 
 
+/* calculateLogLikelihoodRatioPerGroupingPerCategory (NOT EXPOSED)
+ * Arguments: codon, reference to the genome, vector receiving the log acceptance ratio and its components
+ * Only the occurrences of the codon are visited, using the codon occurrence index. sigma at an occurrence is one plus
+ * the prefix sum of the elongation terms of its gene (see updateSigmaPrefixSums), so the genes are independent and
+ * are evaluated in parallel. The rising factorials of the current and proposed alpha are taken from
+ * alphaLogRisingFactorial.
+*/
 void PANSEModel::calculateLogLikelihoodRatioPerGroupingPerCategory(std::string grouping, Genome& genome, std::vector<double> &logAcceptanceRatioForAllMixtures)
 {
     double logLikelihood = 0.0;
     double logLikelihood_proposed = 0.0;
-    double logLikelihood_adjusted = 0.0;
-    double logLikelihood_proposed_adjusted = 0.0;
-    double propAlpha, propLambdaPrime, propNSERate;
-    double currAlpha, currLambdaPrime, currNSERate;
     double currAdjustmentTerm = 0;
     double propAdjustmentTerm = 0;
-    Gene *gene;
     unsigned index = SequenceSummary::codonToIndex(grouping);
-    double U = getPartitionFunction(0, false)/genome.getSumRFP();
-    double propCodonSigma = 0.0;
-    double propSigma, currSigma;
-    //std::vector<double> codonSigmas;
 
-    //codonSigmas.resize(getGroupListSize(), 0.0);
-    currSigmaCalculationSummationFor1 = 0;
-    currSigmaCalculationSummationFor2 = 0;
-    propSigmaCalculationSummationFor1 = 0;
-    propSigmaCalculationSummationFor2 = 0;
+    updateCodonOccurrenceIndex(genome);
+    updateSigmaPrefixSums(genome, false);
+    updateSigmaPrefixSums(genome, true);
+
+    const std::vector <unsigned> &genes = codonOccurrenceGenes[index];
+    const std::vector <unsigned> &geneOffset = codonOccurrenceGeneOffset[index];
+    const std::vector <unsigned> &occurrencePosition = codonOccurrencePosition[index];
+    const std::vector <int> &occurrenceRFPCount = codonOccurrenceRFPCount[index];
+    unsigned numGenes = genes.size();
+
+    for (unsigned alphaCategory = 0u; alphaCategory < parameter->getNumMutationCategories(); alphaCategory++)
+    {
+        alphaLogRisingFactorial.update(alphaCategory, index,
+            getParameterForCategory(alphaCategory, PANSEParameter::alp, index, false));
+        alphaLogRisingFactorial.update(alphaCategory, index,
+            getParameterForCategory(alphaCategory, PANSEParameter::alp, index, true));
+    }
 
 #ifdef _OPENMP
     //#ifndef __APPLE__
-#pragma omp parallel for private(gene) reduction(+:logLikelihood,logLikelihood_proposed)
+#pragma omp parallel for reduction(+:logLikelihood,logLikelihood_proposed)
 #endif
-    for (unsigned i = 0u; i < genome.getGenomeSize(); i++)
+    for (unsigned j = 0u; j < numGenes; j++)
     {
-        gene = &genome.getGene(i);
-        //currSigma = 0.0;
-        //propSigma = 0.0;
+        unsigned i = genes[j];
         // which mixture element does this gene belong to
         unsigned mixtureElement = parameter->getMixtureAssignment(i);
 
@@ -165,44 +399,44 @@ void PANSEModel::calculateLogLikelihoodRatioPerGroupingPerCategory(std::string g
         unsigned synthesisRateCategory = parameter->getSynthesisRateCategory(mixtureElement);
         // get non codon specific values, calculate likelihood conditional on these
         double phiValue = parameter->getSynthesisRate(i, synthesisRateCategory, false);
-        unsigned currNumCodonsInMRNA = gene->geneData.getCodonCountForCodon(index);
-        if (currNumCodonsInMRNA == 0) continue;
-
-        std::vector <unsigned> positions = gene->geneData.getPositionCodonID();
-        std::vector <int> rfpCounts = gene->geneData.getRFPCount(/*RFPCountColumn*/ 0);
-
-        for (unsigned positionIndex = 0; positionIndex < positions.size(); positionIndex++){
-            int positionalRFPCount = rfpCounts[positionIndex];
-            int codonIndex = positions[positionIndex];
-            std::string codon = gene->geneData.indexToCodon(codonIndex);
-            currAlpha = getParameterForCategory(alphaCategory, PANSEParameter::alp, codon, false);
-            currLambdaPrime = getParameterForCategory(lambdaPrimeCategory, PANSEParameter::lmPri, codon, false);
-            currNSERate = getParameterForCategory(alphaCategory, PANSEParameter::nse, codon, false);
-            propAlpha = getParameterForCategory(alphaCategory, PANSEParameter::alp, codon, true);
-            propLambdaPrime = getParameterForCategory(lambdaPrimeCategory, PANSEParameter::lmPri, codon, true);
-            propNSERate = getParameterForCategory(alphaCategory, PANSEParameter::nse, codon, true);
-
-
-            currSigma = elongationUntilIndexApproximation2Probability(currAlpha, currLambdaPrime / U, 1/currNSERate, false);
-            propSigma = elongationUntilIndexApproximation2Probability(propAlpha, propLambdaPrime / U, 1/propNSERate, true);
-
-
-
-            if(codon == grouping){
-                //if (propCodonSigma == 0.0) propCodonSigma = elongationProbabilityLog(propAlpha, propLambdaPrime, 1/propNSERate);
-                //propSigma += propCodonSigma;
-                //if (grouping == "ACA") my_print("The prop sigma is %\n", propSigma);
-                logLikelihood_proposed += calculateLogLikelihoodPerCodonPerGene(propAlpha, propLambdaPrime, positionalRFPCount,
-                                   phiValue, propSigma);
-                logLikelihood += calculateLogLikelihoodPerCodonPerGene(currAlpha, currLambdaPrime, positionalRFPCount,
-                                   phiValue, currSigma);
-            }
-
+        double currAlpha = getParameterForCategory(alphaCategory, PANSEParameter::alp, index, false);
+        double currLambdaPrime = getParameterForCategory(lambdaPrimeCategory, PANSEParameter::lmPri, index, false);
+        double propAlpha = getParameterForCategory(alphaCategory, PANSEParameter::alp, index, true);
+        double propLambdaPrime = getParameterForCategory(lambdaPrimeCategory, PANSEParameter::lmPri, index, true);
+        double logPhi = std::log(phiValue);
+        double currLogLambdaPrime = std::log(currLambdaPrime);
+        double propLogLambdaPrime = std::log(propLambdaPrime);
+
+        for (unsigned k = geneOffset[j]; k < geneOffset[j + 1]; k++)
+        {
+            unsigned positionalRFPCount = occurrenceRFPCount[k];
+            double currSigma = 1 + currSigmaPrefixSum[occurrencePosition[k]];
+            double propSigma = 1 + propSigmaPrefixSum[occurrencePosition[k]];
+
+            logLikelihood_proposed += calculateLogLikelihoodPerCodonPerGene(
+                alphaLogRisingFactorial.get(alphaCategory, index, propAlpha, positionalRFPCount), propAlpha,
+                propLambdaPrime, propLogLambdaPrime, positionalRFPCount, phiValue, logPhi, propSigma);
+            logLikelihood += calculateLogLikelihoodPerCodonPerGene(
+                alphaLogRisingFactorial.get(alphaCategory, index, currAlpha, positionalRFPCount), currAlpha,
+                currLambdaPrime, currLogLambdaPrime, positionalRFPCount, phiValue, logPhi, currSigma);
         }
+    }
+    // estimate without the per position codon IDs and RFP counts
+    countGenomeTraversal(numGenes, sizeof(double) + 2 * sizeof(unsigned));
 
+    // proposal adjustment for the codon specific parameters of the grouping (mixture element of the last gene visited)
+    if (numGenes > 0u)
+    {
+        unsigned mixtureElement = parameter->getMixtureAssignment(genes[numGenes - 1]);
+        unsigned alphaCategory = parameter->getMutationCategory(mixtureElement);
+        unsigned lambdaPrimeCategory = parameter->getSelectionCategory(mixtureElement);
+        currAdjustmentTerm += std::log(getParameterForCategory(alphaCategory, PANSEParameter::alp, index, false))
+            + std::log(getParameterForCategory(lambdaPrimeCategory, PANSEParameter::lmPri, index, false))
+            + std::log(getParameterForCategory(alphaCategory, PANSEParameter::nse, index, false));
+        propAdjustmentTerm += std::log(getParameterForCategory(alphaCategory, PANSEParameter::alp, index, true))
+            + std::log(getParameterForCategory(lambdaPrimeCategory, PANSEParameter::lmPri, index, true))
+            + std::log(getParameterForCategory(alphaCategory, PANSEParameter::nse, index, true));
     }
-    currAdjustmentTerm += std::log(currAlpha) + std::log(currLambdaPrime) + std::log(currNSERate);
-    propAdjustmentTerm += std::log(propAlpha) + std::log(propLambdaPrime) + std::log(propNSERate);
     logAcceptanceRatioForAllMixtures[0] = logLikelihood_proposed - logLikelihood - (currAdjustmentTerm - propAdjustmentTerm);
 	logAcceptanceRatioForAllMixtures[1] = logLikelihood - propAdjustmentTerm;
 	logAcceptanceRatioForAllMixtures[2] = logLikelihood_proposed - currAdjustmentTerm;
@@ -249,55 +483,122 @@ void PANSEModel::calculateLogLikelihoodRatioForHyperParameters(Genome &genome, u
             Parameter::densityLogNorm(phi, currentMphi[mixture], currentStdDevSynthesisRate[mixture], true);
     }
 
+    countGenomeTraversal(genome.getGenomeSize(), sizeof(double) + sizeof(unsigned));
     logProbabilityRatio[0] = lpr;
 
-    Gene *gene;
-    currSigmaCalculationSummationFor1 = 0;
-    currSigmaCalculationSummationFor2 = 0;
-    propSigmaCalculationSummationFor1 = 0;
-    propSigmaCalculationSummationFor2 = 0;
-    double currSigma, propSigma;
-    double logLikelihood, logLikelihood_proposed;
-    lpr = 0.0;
-
-    for (unsigned i = 0u; i < genome.getGenomeSize(); i++)
+    logProbabilityRatio[1] = calculateLogLikelihoodRatioForPartitionFunction(genome);
+}
+
+
+/* calculateLogLikelihoodRatioForPartitionFunction (NOT EXPOSED)
+ * Arguments: reference to the genome
+ * Returns the log acceptance ratio of the proposed partition functions of all mixture elements: the Jacobian of the
+ * log normal proposal of each of them plus, for every gene, the log likelihood with the proposed minus the current
+ * partition function. With lambda = lambdaPrime / U and U = partition function / sum of the RFP counts (see
+ * updateSigmaPrefixSums) sigma at a position is 1 + U * S, where S is the running sum of alpha * NSERate /
+ * lambdaPrime over the gene. S does not depend on U, so one pass over positionCodon and positionRFPCount gives the
+ * current and the proposed sigma, and only the terms of the likelihood that depend on sigma have to be evaluated.
+ * Positions with a missing RFP count contribute to S but not to the likelihood.
+ * The genes are split among threads, each gene's ratio is stored and the ratios are summed in gene order afterwards,
+ * so the result does not depend on the number of threads.
+*/
+double PANSEModel::calculateLogLikelihoodRatioForPartitionFunction(Genome &genome)
+{
+    updateCodonOccurrenceIndex(genome);
+
+    unsigned numGenes = genome.getGenomeSize();
+    unsigned numMixtures = getNumMixtureElements();
+    unsigned numCodons = getGroupListSize();
+    double sumRFP = genome.getSumRFP(RFPCountColumn);
+    double lpr = 0.0;
+
+    std::vector <double> currU(numMixtures), propU(numMixtures);
+    // order: mixture element, codon. Stop codons are not part of the group list and do not contribute.
+    std::vector <double> sigmaSummand(numMixtures * 64, 0.0);
+    std::vector <double> alpha(numMixtures * 64, 0.0);
+    std::vector <double> lambdaPrime(numMixtures * 64, 0.0);
+    for (unsigned mixtureElement = 0u; mixtureElement < numMixtures; mixtureElement++)
     {
-        gene = &genome.getGene(i);
-        // which mixture element does this gene belong to
-        unsigned mixtureElement = parameter->getMixtureAssignment(i);
-        double currU = getPartitionFunction(i, false);
-        double propU = getPartitionFunction(i, true);
-        // how is the mixture element defined. Which categories make it up
+        double currPartitionFunction = getPartitionFunction(mixtureElement, false);
+        double propPartitionFunction = getPartitionFunction(mixtureElement, true);
+        currU[mixtureElement] = currPartitionFunction / sumRFP;
+        propU[mixtureElement] = propPartitionFunction / sumRFP;
+        // take the Jacobian into account for the non-linear transformation from logN to N distribution
+        lpr -= (std::log(currPartitionFunction) - std::log(propPartitionFunction));
+
         unsigned alphaCategory = parameter->getMutationCategory(mixtureElement);
         unsigned lambdaPrimeCategory = parameter->getSelectionCategory(mixtureElement);
+        for (unsigned codonIndex = 0u; codonIndex < numCodons; codonIndex++)
+        {
+            unsigned entry = mixtureElement * 64 + codonIndex;
+            alpha[entry] = getParameterForCategory(alphaCategory, PANSEParameter::alp, codonIndex, false);
+            lambdaPrime[entry] = getParameterForCategory(lambdaPrimeCategory, PANSEParameter::lmPri, codonIndex, false);
+            double NSERate = getParameterForCategory(alphaCategory, PANSEParameter::nse, codonIndex, false);
+            sigmaSummand[entry] = alpha[entry] * NSERate / lambdaPrime[entry];
+        }
+    }
+
+    std::vector <double> geneLogLikelihoodRatio(numGenes, 0.0);
+#ifdef _OPENMP
+    //#ifndef __APPLE__
+#pragma omp parallel for
+#endif
+    for (unsigned i = 0u; i < numGenes; i++)
+    {
+        unsigned mixtureElement = parameter->getMixtureAssignment(i);
         unsigned synthesisRateCategory = parameter->getSynthesisRateCategory(mixtureElement);
-        // get non codon specific values, calculate likelihood conditional on these
         double phiValue = parameter->getSynthesisRate(i, synthesisRateCategory, false);
+        double geneCurrU = currU[mixtureElement];
+        double genePropU = propU[mixtureElement];
+        const double *mixtureSigmaSummand = &sigmaSummand[mixtureElement * 64];
+        const double *mixtureAlpha = &alpha[mixtureElement * 64];
+        const double *mixtureLambdaPrime = &lambdaPrime[mixtureElement * 64];
+
+        double sum = 0.0;
+        double ratio = 0.0;
+        for (unsigned position = genePositionOffset[i]; position < genePositionOffset[i + 1]; position++)
+        {
+            unsigned codonIndex = positionCodon[position];
+            sum += mixtureSigmaSummand[codonIndex];
+            int positionalRFPCount = positionRFPCount[position];
+            if (positionalRFPCount < 0) continue;
+
+            double currSigma = 1.0 + geneCurrU * sum;
+            double propSigma = 1.0 + genePropU * sum;
+            double currLambdaPrime = mixtureLambdaPrime[codonIndex];
+            // see calculateLogLikelihoodPerCodonPerGene, the other terms are the same for both sigmas
+            ratio += positionalRFPCount * std::log(propSigma / currSigma)
+                - (positionalRFPCount + mixtureAlpha[codonIndex])
+                * std::log((currLambdaPrime + phiValue * propSigma) / (currLambdaPrime + phiValue * currSigma));
+        }
+        geneLogLikelihoodRatio[i] = ratio;
+    }
 
-        std::vector <unsigned> positions = gene->geneData.getPositionCodonID();
-        std::vector <int> rfpCounts = gene->geneData.getRFPCount(/*RFPCountColumn*/ 0);
-
-        for (unsigned positionIndex = 0; positionIndex < positions.size(); positionIndex++){
-            int positionalRFPCount = rfpCounts[positionIndex];
-            int codonIndex = positions[positionIndex];
-            std::string codon = gene->geneData.indexToCodon(codonIndex);
-            double currAlpha = getParameterForCategory(alphaCategory, PANSEParameter::alp, codon, false);
-            double currLambdaPrime = getParameterForCategory(lambdaPrimeCategory, PANSEParameter::lmPri, codon, false);
-            double currNSERate = getParameterForCategory(alphaCategory, PANSEParameter::nse, codon, false);
+    for (unsigned i = 0u; i < numGenes; i++)
+        lpr += geneLogLikelihoodRatio[i];
+    countGenomeTraversal(numGenes, sizeof(double) + sizeof(unsigned));
 
-            currSigma = elongationUntilIndexApproximation2Probability(currAlpha, currLambdaPrime / currU, 1/currNSERate, false);
-            propSigma = elongationUntilIndexApproximation2Probability(currAlpha, currLambdaPrime / propU, 1/currNSERate, true);
+    return lpr;
+}
 
-            logLikelihood += calculateLogLikelihoodPerCodonPerGene(currAlpha, currLambdaPrime, positionalRFPCount,
-                                phiValue, currSigma);
-            logLikelihood_proposed += calculateLogLikelihoodPerCodonPerGene(currAlpha, currLambdaPrime, positionalRFPCount,
-                               phiValue, propSigma);
 
-        }
+/* prepareForCodonSpecificParameterUpdate (NOT EXPOSED)
+ * Arguments: reference to the genome
+ * Called by MCMCAlgorithm before the codon specific parameters are updated. Brings the codon occurrence index and the
+ * sigma prefix sums up to date with the new proposal, the mixture assignments and the partition function, and
+ * tabulates the rising factorials of the current alpha values, which the synthesis rate update looks up.
+*/
+void PANSEModel::prepareForCodonSpecificParameterUpdate(Genome &genome)
+{
+    updateCodonOccurrenceIndex(genome);
+    updateSigmaPrefixSums(genome, false);
+    updateSigmaPrefixSums(genome, true);
 
-        lpr -= (std::log(getPartitionFunction(i, false)) - std::log(getPartitionFunction(i, true)));
-        lpr -= logLikelihood_proposed - logLikelihood;
-        logProbabilityRatio[1] = lpr;
+    for (unsigned alphaCategory = 0u; alphaCategory < parameter->getNumMutationCategories(); alphaCategory++)
+    {
+        for (unsigned codonIndex = 0u; codonIndex < getGroupListSize(); codonIndex++)
+            alphaLogRisingFactorial.update(alphaCategory, codonIndex,
+                getParameterForCategory(alphaCategory, PANSEParameter::alp, codonIndex, false));
     }
 }
 
@@ -501,6 +802,12 @@ void PANSEModel::updateMixtureAssignmentTrace(unsigned sample, unsigned i)
 }
 
 
+void PANSEModel::updateSynthesisRateTraces(unsigned sample)
+{
+    parameter->updateSynthesisRateTraces(sample);
+}
+
+
 void PANSEModel::updateMixtureProbabilitiesTrace(unsigned sample)
 {
     parameter->updateMixtureProbabilitiesTrace(sample);
@@ -520,15 +827,11 @@ void PANSEModel::updateHyperParameterTraces(unsigned sample)
 }
 
 
-void PANSEModel::updateTracesWithInitialValues(Genome & genome)
+void PANSEModel::updateTracesWithInitialValues(Genome & /*genome*/)
 {
     std::vector <std::string> groupList = parameter->getGroupList();
 
-    for (unsigned i = 0; i < genome.getGenomeSize(); i++)
-    {
-        parameter->updateSynthesisRateTrace(0, i);
-        parameter->updateMixtureAssignmentTrace(0, i);
-    }
+    updateSynthesisRateTraces(0);
 
     for (unsigned i = 0; i < groupList.size(); i++)
     {
@@ -537,6 +840,18 @@ void PANSEModel::updateTracesWithInitialValues(Genome & genome)
 }
 
 
+bool PANSEModel::flushTraces()
+{
+    return parameter->flushTraces();
+}
+
+
+bool PANSEModel::hasTraceFileWriteFailed()
+{
+    return parameter->hasTraceFileWriteFailed();
+}
+
+
 
 
 
@@ -683,11 +998,10 @@ void PANSEModel::simulateGenome(Genome &genome)
     for (unsigned geneIndex = 0u; geneIndex < genome.getGenomeSize(); geneIndex++)
     {
         unsigned mixtureElement = getMixtureAssignment(geneIndex);
-        Gene gene = genome.getGene(geneIndex);
+        Gene &gene = genome.getGene(geneIndex);
         double phi = parameter->getSynthesisRate(geneIndex, mixtureElement, false);
-        SequenceSummary sequence = gene.geneData;
         Gene tmpGene = gene;
-        std::vector <unsigned> positions = sequence.getPositionCodonID();
+        const std::vector <unsigned> &positions = gene.geneData.getPositionCodonIDReference();
         std::vector <int> rfpCount;
         unsigned alphaCat = parameter->getMutationCategory(mixtureElement);
         unsigned lambdaPrimeCat = parameter->getSelectionCategory(mixtureElement);
@@ -695,10 +1009,9 @@ void PANSEModel::simulateGenome(Genome &genome)
         double v;
         for (unsigned codonID : positions)
         {
-            std::string codon = SequenceSummary::codonArray[codonID];
-            double alpha = getParameterForCategory(alphaCat, PANSEParameter::alp, codon, false);
-            double lambdaPrime = getParameterForCategory(lambdaPrimeCat, PANSEParameter::lmPri, codon, false);
-            double NSERate = getParameterForCategory(alphaCat, PANSEParameter::nse, codon, false);
+            double alpha = getParameterForCategory(alphaCat, PANSEParameter::alp, codonID, false);
+            double lambdaPrime = getParameterForCategory(lambdaPrimeCat, PANSEParameter::lmPri, codonID, false);
+            double NSERate = getParameterForCategory(alphaCat, PANSEParameter::nse, codonID, false);
 
             if (NSERate == 0){v = 1000000000;}
             else {v = 1.0 / NSERate;}
@@ -711,7 +1024,7 @@ void PANSEModel::simulateGenome(Genome &genome)
             xx = rpois(1, xx[0] * phi * sigma);
             rfpCount.push_back(xx[0]);
 #else
-            std::gamma_distribution<double> GDistribution(alphaPrime, 1.0/lambdaPrime);
+            std::gamma_distribution<double> GDistribution(alpha, 1.0/lambdaPrime);
             double tmp = GDistribution(Parameter::generator);
             sigma *= (v/(tmp + v));
             std::poisson_distribution<unsigned> PDistribution(phi * tmp * sigma);
@@ -746,9 +1059,21 @@ PANSEParameter* PANSEModel::getParameter()
 }
 
 
+/* getRFPCountColumn (NOT EXPOSED)
+ * Arguments: None
+ *
+ * Returns the index (starting at 0) of the RFP count column the model reads.
+ */
+unsigned PANSEModel::getRFPCountColumn()
+{
+    return RFPCountColumn;
+}
+
+
 void PANSEModel::setParameter(PANSEParameter &_parameter)
 {
     parameter = &_parameter;
+    indexedGenome = NULL; // the number of categories of alphaLogRisingFactorial may change
 }
 
 
@@ -763,46 +1088,142 @@ double PANSEModel::getParameterForCategory(unsigned category, unsigned param, st
     return parameter->getParameterForCategory(category, param, codon, proposal);
 }
 
-//Continued fractions helper function for upper incomplete gamma
-double PANSEModel::UpperIncompleteGammaHelper(double s, double x)
-{
-    double rv;
-    int i;
-
-    rv = 10000.0 / x;
-    for(i = 10000; i > 0; i--){
-        if(i % 2 == 0) rv = (double) ((int) (i / 2)) / (x + rv);
-        if(i % 2 != 0) rv = ((double) (((int) (i / 2) + 1) - s)) / (1 + rv);
-    }
 
-    return x + rv;
+double PANSEModel::getParameterForCategory(unsigned category, unsigned param, unsigned codonIndex, bool proposal)
+{
+    return parameter->getParameterForCategory(category, param, codonIndex, proposal);
 }
 
-//Upper incomplete gamma function
-double PANSEModel::UpperIncompleteGamma(double s, double x)
+/* UpperIncompleteGammaHelper (NOT EXPOSED)
+ * Arguments: s, x > 0
+ * Returns the denominator d of the continued fraction representation x^s * exp(-x) / d of the upper incomplete gamma
+ * function. Kept for backwards compatibility, derived from UpperIncompleteGammaLog.
+*/
+double PANSEModel::UpperIncompleteGammaHelper(double s, double x)
 {
-    double d, rv;
+    return std::exp(s * std::log(x) - x - UpperIncompleteGammaLog(s, x));
+}
 
-    rv = pow(x, s) * exp(0 - x);
 
-    d = UpperIncompleteGammaHelper(s, x);
+/* UpperIncompleteGamma (NOT EXPOSED)
+ * Arguments: s, x
+ * Returns the upper incomplete gamma function Gamma(s, x). See UpperIncompleteGammaLog.
+*/
+double PANSEModel::UpperIncompleteGamma(double s, double x)
+{
+    return std::exp(UpperIncompleteGammaLog(s, x));
+}
+
+
+/* UpperIncompleteGammaLog (NOT EXPOSED)
+ * Arguments: s, x
+ * Returns log(Gamma(s, x)) for any real s and x >= 0, calculated in log space throughout so that large x or large |s|
+ * do not under- or overflow. Every branch runs at most maxIncompleteGammaIterations iterations:
+ *  - |s| < 0.01 and x < max(1, s + 1): Gamma(s, x) = (Gamma(1 + s) - 1) / s - (x^s - 1) / s - x^s * sum_n (-x)^n / (n! (s + n)),
+ *    with log(Gamma(1 + s)) from its Taylor series. Gamma(s) and gamma(s, x) both grow like 1 / s and their difference
+ *    would lose about -log10(|s|) digits.
+ *  - s > 0 and x < s + 1: series of the lower incomplete gamma function, Gamma(s, x) = Gamma(s) - gamma(s, x).
+ *  - x >= s + 1 and x >= 1: continued fraction (modified Lentz).
+ *  - s < 0 and x < 1: the value of Gamma(s + n, x) with s + n in (-0.01, 0.99] from the branches above is carried down
+ *    to s with Gamma(t, x) = (x^t * exp(-x) - Gamma(t + 1, x)) / -t. Starting next to 0 rather than next to 1 avoids
+ *    the same cancellation in the first step. If more than maxIncompleteGammaIterations steps would be needed the
+ *    continued fraction is used instead.
+ * Gamma(s, 0) is Gamma(s) for s > 0 and infinite otherwise.
+*/
+double PANSEModel::UpperIncompleteGammaLog(double s, double x)
+{
+    const double epsilon = std::numeric_limits<double>::epsilon();
+    const double tiny = std::numeric_limits<double>::min() / epsilon;
 
-    return rv/d;
+    if (x <= 0.0)
+        return s > 0.0 ? std::lgamma(s) : std::numeric_limits<double>::infinity();
 
-}
+    const double smallS = 0.01;
+    const double eulerGamma = 0.57721566490153286061;
+    double logX = std::log(x);
+    if (std::fabs(s) < smallS && x < std::max(1.0, s + 1.0))
+    {
+        //log(Gamma(1 + s)) = -EulerGamma s + sum_k zeta(k) (-s)^k / k, |s| < 0.01 needs k <= 10
+        const double zeta[] = {1.6449340668482264, 1.2020569031595943, 1.0823232337111382, 1.0369277551433699,
+            1.0173430619844491, 1.0083492773819228, 1.0040773561979443, 1.0020083928260822, 1.0009945751278181};
+        double logGamma1p = -eulerGamma * s;
+        double power = -s;
+        for (unsigned k = 2u; k <= 10u; k++)
+        {
+            power *= -s;
+            logGamma1p += zeta[k - 2u] * power / k;
+        }
+        double sum = 0.0;
+        double term = 1.0;
+        for (unsigned n = 1u; n <= maxIncompleteGammaIterations; n++)
+        {
+            term *= -x / n;
+            sum += term / (s + n);
+            if (std::fabs(term) < std::fabs(sum) * epsilon) break;
+        }
+        //at s = 0 this is the exponential integral Gamma(0, x) = -EulerGamma - log(x) - sum_n (-x)^n / (n n!)
+        double gammaPart = s == 0.0 ? -eulerGamma : std::expm1(logGamma1p) / s;
+        double powerPart = s == 0.0 ? logX : std::expm1(s * logX) / s;
+        return std::log(gammaPart - powerPart - std::exp(s * logX) * sum);
+    }
 
-//log of upper incomplete gamma function
-double PANSEModel::UpperIncompleteGammaLog(double s, double x)
-{
-    double rv, d;
+    if (s > 0.0 && x < s + 1.0)
+    {
+        //Series: gamma(s, x) = x^s * exp(-x) * sum_n x^n / (s (s + 1) ... (s + n))
+        double term = 1.0 / s;
+        double sum = term;
+        for (unsigned n = 1u; n <= maxIncompleteGammaIterations; n++)
+        {
+            term *= x / (s + n);
+            sum += term;
+            if (term < sum * epsilon) break;
+        }
+        double logGammaS = std::lgamma(s);
+        //the regularized lower part is below 1, log1p loses about -log10(s) digits, hence the branch above
+        return logGammaS + std::log1p(-std::exp(s * logX - x + std::log(sum) - logGammaS));
+    }
 
-    rv = s * std::log(x) - x;
-    d = std::log(PANSEModel::UpperIncompleteGammaHelper(s, x));
+    double steps = std::floor(-s) + 1.0;
+    if (x >= 1.0 || steps > maxIncompleteGammaIterations)
+    {
+        //Continued fraction: Gamma(s, x) = x^s * exp(-x) / (x + 1 - s - 1 (1 - s) / (x + 3 - s - 2 (2 - s) / ...))
+        double b = x + 1.0 - s;
+        double c = 1.0 / tiny;
+        double d = 1.0 / b;
+        double h = d;
+        for (unsigned i = 1u; i <= maxIncompleteGammaIterations; i++)
+        {
+            double an = -(double)i * ((double)i - s);
+            b += 2.0;
+            d = an * d + b;
+            if (std::fabs(d) < tiny) d = tiny;
+            c = b + an / c;
+            if (std::fabs(c) < tiny) c = tiny;
+            d = 1.0 / d;
+            double delta = d * c;
+            h *= delta;
+            if (std::fabs(delta - 1.0) < epsilon) break;
+        }
+        return s * logX - x + std::log(h);
+    }
 
-    return rv - d;
+    //s < 0 and x < 1: start at t = s + n in (0, 1], or at t = s + n - 1 in (-0.01, 0] next to an integer
+    unsigned numSteps = (unsigned)steps;
+    if (s + (steps - 1.0) > -smallS)
+        numSteps--;
+    double logGamma = UpperIncompleteGammaLog(s + numSteps, x);
 
+    for (unsigned step = numSteps; step > 0u; step--)
+    {
+        double t = s + (step - 1u);
+        //Gamma(t, x) = (x^t * exp(-x) - Gamma(t + 1, x)) / -t, the difference is positive for t < 0
+        double logPower = t * logX - x;
+        logGamma = logPower + std::log1p(-std::exp(logGamma - logPower)) - std::log(-t);
+    }
+    return logGamma;
 }
 
+
 //Generalized integral function
 double PANSEModel::GeneralizedIntegral(double p, double z){
     return std::pow(z, p - 1.0) * UpperIncompleteGamma(1.0 - p, z);
@@ -823,6 +1244,7 @@ double PANSEModel::elongationProbabilityLog(double currAlpha, double currLambda,
     return (currLambda * currNSE) + currAlpha * (std::log(currLambda) + std::log(currNSE)) + UpperIncompleteGammaLog(1- currAlpha, currLambda * currNSE);
 }
 
+
 double PANSEModel::elongationUntilIndexProbability(int index, std::vector <double> lambdas, std::vector <double> NSERates){
     return 0;
 }
@@ -832,60 +1254,35 @@ double PANSEModel::elongationUntilIndexProbabilityLog(int index, std::vector <do
 }
 
 
-double PANSEModel::elongationUntilIndexApproximation1Probability(double alpha, double lambda, double v, bool proposed)
+/* elongationUntilIndexApproximation1Probability (NOT EXPOSED)
+ * Arguments: alpha, lambda and v of the codon at the current position, running sum of the elongation terms
+ * The running sum is owned by the caller and has to start at 0 at the first position of a gene.
+*/
+double PANSEModel::elongationUntilIndexApproximation1Probability(double alpha, double lambda, double v, double &sigmaSum1)
 {
-    if (proposed)
-    {
-        propSigmaCalculationSummationFor1 += (alpha/(lambda * v));
-        return 1 - propSigmaCalculationSummationFor1;
-    }
-    else
-    {
-        currSigmaCalculationSummationFor1 += (alpha/(lambda * v));
-        return 1 - currSigmaCalculationSummationFor1;
-    }
+    sigmaSum1 += (alpha/(lambda * v));
+    return 1 - sigmaSum1;
 }
 
-double PANSEModel::elongationUntilIndexApproximation2Probability(double alpha, double lambda, double v, bool proposed)
+double PANSEModel::elongationUntilIndexApproximation2Probability(double alpha, double lambda, double v, double &sigmaSum1,
+        double &sigmaSum2)
 {
-    if (proposed)
-    {
-        propSigmaCalculationSummationFor2 += (alpha/(lambda * v)) *
-                elongationUntilIndexApproximation1Probability(alpha, lambda, v, proposed)
-                + (alpha/(lambda * lambda * v * v));
-        return 1 + propSigmaCalculationSummationFor1;
-    }
-    else
-    {
-        currSigmaCalculationSummationFor2 += (alpha/(lambda * v)) *
-                elongationUntilIndexApproximation1Probability(alpha, lambda, v, proposed)
-                + (alpha/(lambda * lambda * v * v));
-        return 1 + currSigmaCalculationSummationFor1;
-    }
+    sigmaSum2 += (alpha/(lambda * v)) * elongationUntilIndexApproximation1Probability(alpha, lambda, v, sigmaSum1)
+            + (alpha/(lambda * lambda * v * v));
+    return 1 + sigmaSum1;
 }
 
-double PANSEModel::elongationUntilIndexApproximation1ProbabilityLog(double alpha, double lambda, double v, bool proposed)
+double PANSEModel::elongationUntilIndexApproximation1ProbabilityLog(double alpha, double lambda, double v, double &sigmaSum1)
 {
-    if (proposed)
-    {
-        propSigmaCalculationSummationFor1 -= (alpha/(lambda * v));
-        return propSigmaCalculationSummationFor1;
-    }
-    currSigmaCalculationSummationFor1 -= (alpha/(lambda * v));
-    return currSigmaCalculationSummationFor1;
+    sigmaSum1 -= (alpha/(lambda * v));
+    return sigmaSum1;
 }
-double PANSEModel::elongationUntilIndexApproximation2ProbabilityLog(double alpha, double lambda, double v, bool proposed)
-{
-    if (proposed)
-       {
-        propSigmaCalculationSummationFor2 += -(alpha/(lambda * v)) + (alpha/(lambda * lambda * v * v))
-                   + (alpha/(lambda * v)) * (alpha/(lambda * v)) / 2;
-           return propSigmaCalculationSummationFor2;
-       }
-       currSigmaCalculationSummationFor2 += -(alpha/(lambda * v)) + (alpha/(lambda * lambda * v * v))
-                           + (alpha/(lambda * v)) * (alpha/(lambda * v)) / 2;
-       return currSigmaCalculationSummationFor2;
 
+double PANSEModel::elongationUntilIndexApproximation2ProbabilityLog(double alpha, double lambda, double v, double &sigmaSum2)
+{
+    sigmaSum2 += -(alpha/(lambda * v)) + (alpha/(lambda * lambda * v * v))
+            + (alpha/(lambda * v)) * (alpha/(lambda * v)) / 2;
+    return sigmaSum2;
 }
 
 
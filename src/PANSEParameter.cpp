@@ -735,6 +735,16 @@ double PANSEParameter::getParameterForCategory(unsigned category, unsigned param
 }
 
 
+/* getParameterForCategory (NOT EXPOSED)
+ * Arguments: category, parameter type, codon index (see SequenceSummary::codonToIndex), where or not proposed or current
+ * Same as above, but takes the index of the codon. Used in the likelihood loops, which know the codon index already.
+*/
+double PANSEParameter::getParameterForCategory(unsigned category, unsigned paramType, unsigned codonIndex, bool proposal)
+{
+	return (proposal ? proposedCodonSpecificParameter[paramType][category][codonIndex] : currentCodonSpecificParameter[paramType][category][codonIndex]);
+}
+
+
 
 
 
@@ -1200,12 +1200,108 @@ void Parameter::updateMixtureAssignmentTrace(unsigned sample, unsigned geneIndex
 }
 
 
+/* updateSynthesisRateTraces (NOT EXPOSED)
+ * Arguments: sample
+ * Stores the current synthesis rates and mixture assignments of all genes in the traces. The mixture assignments go
+ * first, the synthesis rate trace may only store the rate of the assigned category (see
+ * setActiveCategorySynthesisRateTrace).
+*/
+void Parameter::updateSynthesisRateTraces(unsigned sample)
+{
+	traces.updateMixtureAssignmentTrace(sample, mixtureAssignment);
+	traces.updateSynthesisRateTrace(sample, currentSynthesisRateLevel);
+}
+
+
 void Parameter::updateMixtureProbabilitiesTrace(unsigned samples)
 {
 	traces.updateMixtureProbabilitiesTrace(samples, categoryProbabilities);
 }
 
 
+/* setTraceFileMode (RCPP EXPOSED)
+ * Arguments: name of the trace file (empty string to keep the traces in memory), number of samples kept in memory
+ * Streams the synthesis rate and mixture assignment traces of the next run to the file, see Trace::setTraceFileMode.
+*/
+void Parameter::setTraceFileMode(std::string filename, unsigned windowSamples)
+{
+	traces.setTraceFileMode(filename, windowSamples);
+}
+
+
+/* flushTraces (NOT EXPOSED)
+ * Arguments: None
+ * Writes the samples not yet stored in the trace file (if any) to it and run length encodes the mixture assignment
+ * trace if requested (see setMixtureAssignmentRunLengthEncoding). Returns false if the trace file could not be written.
+*/
+bool Parameter::flushTraces()
+{
+	bool written = traces.flushTraceFile();
+	traces.encodeMixtureAssignmentTrace();
+	return written;
+}
+
+
+/* hasTraceFileWriteFailed (NOT EXPOSED)
+ * Arguments: None
+ * Returns true if a sample could not be written to the trace file, see Trace::hasTraceFileWriteFailed.
+*/
+bool Parameter::hasTraceFileWriteFailed()
+{
+	return traces.hasTraceFileWriteFailed();
+}
+
+
+/* loadTraceFile (RCPP EXPOSED)
+ * Arguments: name of the trace file of a finished run
+ * Reads the synthesis rate and mixture assignment traces from the trace file (memory mapped) instead of memory, so
+ * posterior summaries like getSynthesisRatePosteriorMean and getExpressionQuantile can be computed without loading
+ * the traces. The last iteration is set to the last sample in the file.
+ * Returns false if the file could not be loaded.
+*/
+bool Parameter::loadTraceFile(std::string filename)
+{
+	if (!traces.loadTraceFile(filename, (unsigned)mixtureAssignment.size(), categories))
+		return false;
+
+	unsigned numSamplesWritten = traces.getTraceFileNumSamplesWritten();
+	lastIteration = numSamplesWritten > 0u ? numSamplesWritten - 1u : 0u;
+	return true;
+}
+
+
+/* setTraceLayout (RCPP EXPOSED)
+ * Arguments: "gene" or "sample"
+ * Sets the in memory order of the synthesis rate and mixture assignment traces, see Trace::setTraceLayout. "sample"
+ * speeds up storing samples for large genomes, "gene" (the default) the posterior summaries.
+*/
+void Parameter::setTraceLayout(std::string layout)
+{
+	traces.setTraceLayout(layout);
+}
+
+
+/* setMixtureAssignmentRunLengthEncoding (RCPP EXPOSED)
+ * Arguments: true to store the mixture assignment trace as runs of equal values per gene after the run
+ * Genes rarely switch mixture elements, so the runs are usually much smaller than the bit packed trace. Off by default.
+*/
+void Parameter::setMixtureAssignmentRunLengthEncoding(bool runLength)
+{
+	traces.setMixtureAssignmentRunLengthEncoding(runLength);
+}
+
+
+/* setActiveCategorySynthesisRateTrace (RCPP EXPOSED)
+ * Arguments: true to store only the synthesis rate of the expression category each gene is assigned to
+ * Divides the synthesis rate trace by the number of expression categories, the posterior summaries do not change.
+ * Applies to the traces of the next run, see Trace::setActiveCategorySynthesisRateTrace.
+*/
+void Parameter::setActiveCategorySynthesisRateTrace(bool activeCategoryOnly)
+{
+	traces.setActiveCategorySynthesisRateTrace(activeCategoryOnly);
+}
+
+
 //----------------------------------------------//
 //---------- Adaptive Width Functions ----------//
 //----------------------------------------------//
@@ -1800,7 +1896,6 @@ unsigned Parameter::getEstimatedMixtureAssignment(unsigned samples, unsigned gen
 
 std::vector<double> Parameter::getEstimatedMixtureAssignmentProbabilities(unsigned samples, unsigned geneIndex)
 {
-	std::vector<unsigned> mixtureAssignmentTrace = traces.getMixtureAssignmentTraceForGene(geneIndex);
 	std::vector<double> probabilities(numMixtures, 0.0);
 	unsigned traceLength = lastIteration + 1;
 
@@ -1814,14 +1909,10 @@ std::vector<double> Parameter::getEstimatedMixtureAssignmentProbabilities(unsign
 	}
 
 	unsigned start = traceLength - samples;
-	for (unsigned i = start; i < traceLength; i++)
-	{
-		unsigned value = mixtureAssignmentTrace[i];
-		probabilities[value]++;
-	}
+	std::vector<unsigned> counts = traces.countMixtureAssignmentsForGene(geneIndex, start, traceLength, numMixtures);
 
 	for (unsigned i = 0; i < numMixtures; i++)
-		probabilities[i] /= (double)samples;
+		probabilities[i] = counts[i] / (double)samples;
 
 	return probabilities;
 }
@@ -22,6 +22,7 @@ RCPP_EXPOSED_CLASS(Genome)
 RCPP_MODULE(Model_mod)
 {
 	class_<Model>("Model")
+		.method("setLogLikelihoodCacheMode", &Model::setLogLikelihoodCacheMode)
 		;
 
 	class_<ROCModel>( "ROCModel" )
@@ -33,6 +34,7 @@ RCPP_MODULE(Model_mod)
   		.method("getParameter", &ROCModel::getParameter)
   		.method("setParameter", &ROCModel::setParameter)
   		.method("simulateGenome", &ROCModel::simulateGenome)
+		.method("setSufficientStatisticsMode", &ROCModel::setSufficientStatisticsMode)
 		;
 	
 	class_<PAModel>("PAModel")
@@ -57,6 +59,8 @@ RCPP_MODULE(Model_mod)
   		.method("getParameter", &FONSEModel::getParameter)
 		.method("setParameter", &FONSEModel::setParameter)
 		.method("simulateGenome", &FONSEModel::simulateGenome)
+		.method("setPositionBucketMode", &FONSEModel::setPositionBucketMode)
+		.method("calculatePositionBucketErrorBound", &FONSEModel::calculatePositionBucketErrorBound)
 		;
 }
 #endif
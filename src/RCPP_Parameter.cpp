@@ -45,6 +45,11 @@ RCPP_MODULE(Parameter_mod)
 		//Trace Functions:
 		.method("getTraceObject", &Parameter::getTraceObject) //TODO: only used in R?
 		.method("setTraceObject", &Parameter::setTraceObject)
+		.method("setTraceFileMode", &Parameter::setTraceFileMode)
+		.method("loadTraceFile", &Parameter::loadTraceFile)
+		.method("setTraceLayout", &Parameter::setTraceLayout)
+		.method("setMixtureAssignmentRunLengthEncoding", &Parameter::setMixtureAssignmentRunLengthEncoding)
+		.method("setActiveCategorySynthesisRateTrace", &Parameter::setActiveCategorySynthesisRateTrace)
 
 		//Synthesis Rate Functions:
 		.method("getSynthesisRate", &Parameter::getSynthesisRateR)
@@ -28,6 +28,7 @@ RCPP_MODULE(Trace_mod)
     .method("getMixtureProbabilitiesTraceForMixture", &Trace::getMixtureProbabilitiesTraceForMixtureR)
     .method("getStdDevSynthesisRateTraces", &Trace::getStdDevSynthesisRateTraces)
     .method("getNumberOfMixtures", &Trace::getNumberOfMixtures)
+    .method("getTraceFileName", &Trace::getTraceFileName)
     
 
     //Setter Functions:
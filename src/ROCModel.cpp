@@ -11,6 +11,8 @@ ROCModel::ROCModel(bool _withPhi, bool _fix_sEpsilon) : Model()
 	parameter = 0;
 	withPhi = _withPhi;
 	fix_sEpsilon = _fix_sEpsilon;
+	useSufficientStatistics = false;
+	numPhiBins = 0u;
 }
 
 
@@ -20,22 +22,267 @@ ROCModel::~ROCModel()
 	//delete parameter;
 }
 
-double ROCModel::calculateLogLikelihoodPerAAPerGene(unsigned numCodons, int codonCount[], double mutation[], double selection[], double phiValue)
+
+/* calculateLogCodonProbabilityCoefficients (NOT EXPOSED)
+ * Arguments: number of codons of the AA, mutation and selection parameters, arrays receiving offset, slope and
+ * whether the codon enters the denominator, reference to the initial value of the denominator.
+ * Splits calculateLogCodonProbabilityVector into its phi independent parts: before normalisation,
+ * log(codonProb[i]) = offset[i] - slope[i] * phi, and the denominator is
+ * initialDenominator + sum of exp(log(codonProb[i])) over the codons with inDenominator[i].
+ * The reference codon choice only depends on the selection parameters and is resolved here.
+*/
+void ROCModel::calculateLogCodonProbabilityCoefficients(unsigned numCodons, double mutation[], double selection[],
+	double offset[], double slope[], bool inDenominator[], double &initialDenominator)
 {
+	unsigned minIndexVal = 0u;
+	for (unsigned i = 1u; i < (numCodons - 1); i++)
+	{
+		if (selection[minIndexVal] > selection[i])
+			minIndexVal = i;
+	}
+	if (selection[minIndexVal] < 0.0)
+	{
+		initialDenominator = 0.0;
+		for (unsigned i = 0u; i < (numCodons - 1); i++)
+		{
+			offset[i] = -(mutation[i] - mutation[minIndexVal]);
+			slope[i] = selection[i] - selection[minIndexVal];
+			inDenominator[i] = true;
+		}
+		offset[numCodons - 1] = mutation[minIndexVal];
+		slope[numCodons - 1] = -selection[minIndexVal];
+		inDenominator[numCodons - 1] = true;
+	}
+	else
+	{
+		initialDenominator = 1.0;
+		for (unsigned i = 0u; i < (numCodons - 1); i++)
+		{
+			offset[i] = -mutation[i];
+			slope[i] = selection[i];
+			inDenominator[i] = true;
+		}
+		// reference codon, exp(0) is already in the initial denominator
+		offset[numCodons - 1] = 0.0;
+		slope[numCodons - 1] = 0.0;
+		inDenominator[numCodons - 1] = false;
+	}
+}
+
+
+/* calculateLogLikelihoodPerAAForGeneBatch (NOT EXPOSED)
+ * Arguments: number of codons of the AA, mutation and selection parameters shared by all genes in the batch,
+ * number of genes in the batch (at most geneBatchSize), phi value of each gene, codon counts stored codon by codon
+ * (codonCounts[codon * batchSize + gene]), array receiving the log likelihood of each gene.
+ * Calculates the log likelihood of the codon counts of one AA for a batch of genes. The reference codon choice is
+ * resolved once for the batch (see calculateLogCodonProbabilityCoefficients) and the loops over the genes run without
+ * branches, which lets the compiler vectorise them. The arithmetic is done in the same order as in
+ * calculateLogCodonProbabilityVector, so results are identical to evaluating one gene at a time.
+*/
+void ROCModel::calculateLogLikelihoodPerAAForGeneBatch(unsigned numCodons, double mutation[], double selection[],
+	unsigned batchSize, const double phiValues[], const int codonCounts[], double logLikelihoods[])
+{
+	double offset[6];
+	double slope[6];
+	bool inDenominator[6];
+	double initialDenominator;
+	calculateLogCodonProbabilityCoefficients(numCodons, mutation, selection, offset, slope, inDenominator,
+		initialDenominator);
+
+	double logCodonProbabilities[6 * geneBatchSize];
+	double denominator[geneBatchSize];
+	for (unsigned g = 0u; g < batchSize; g++)
+		denominator[g] = initialDenominator;
+	for (unsigned i = 0u; i < numCodons; i++)
+	{
+		double *logCodonProb = logCodonProbabilities + i * batchSize;
+		double codonOffset = offset[i];
+		double codonSlope = slope[i];
+		if (inDenominator[i])
+		{
+#if defined(_OPENMP) && _OPENMP >= 201307
+#pragma omp simd
+#endif
+			for (unsigned g = 0u; g < batchSize; g++)
+			{
+				logCodonProb[g] = codonOffset - (codonSlope * phiValues[g]);
+				denominator[g] += std::exp(logCodonProb[g]);
+			}
+		}
+		else
+		{
+#if defined(_OPENMP) && _OPENMP >= 201307
+#pragma omp simd
+#endif
+			for (unsigned g = 0u; g < batchSize; g++)
+				logCodonProb[g] = codonOffset - (codonSlope * phiValues[g]);
+		}
+	}
+#if defined(_OPENMP) && _OPENMP >= 201307
+#pragma omp simd
+#endif
+	for (unsigned g = 0u; g < batchSize; g++)
+	{
+		denominator[g] = std::log(denominator[g]);
+		logLikelihoods[g] = 0.0;
+	}
+	for (unsigned i = 0u; i < numCodons; i++)
+	{
+		const double *logCodonProb = logCodonProbabilities + i * batchSize;
+		const int *codonCount = codonCounts + i * batchSize;
+#if defined(_OPENMP) && _OPENMP >= 201307
+#pragma omp simd
+#endif
+		for (unsigned g = 0u; g < batchSize; g++)
+		{
+			// skip codons that do not occur in the gene, avoids 0 * -Inf
+			double term = (logCodonProb[g] - denominator[g]) * codonCount[g];
+			logLikelihoods[g] += (codonCount[g] == 0) ? 0.0 : term;
+		}
+	}
+}
+
+
+/* calculateLogLikelihoodPerAAFromSufficientStatistics (NOT EXPOSED)
+ * Arguments: number of codons of the AA, mutation and selection parameters, amino acid index, mixture element
+ * Returns the log likelihood of the AA summed over all genes of the mixture element, using the statistics collected
+ * by updateSufficientStatistics. With log(codonProb[i]) = offset[i] - slope[i] * phi - log(denominator(phi)),
+ * sum_genes sum_codons count * log(codonProb) = sum_codons offset[i] * sum(count) - slope[i] * sum(count * phi)
+ *                                             - sum_genes aaCount * log(denominator(phi)).
+ * Only the last term needs a loop, over the genes containing the AA (or the phi bins, see setSufficientStatisticsMode).
+*/
+double ROCModel::calculateLogLikelihoodPerAAFromSufficientStatistics(unsigned numCodons, double mutation[],
+	double selection[], unsigned aaIndex, unsigned mixture)
+{
+	double offset[6];
+	double slope[6];
+	bool inDenominator[6];
+	double initialDenominator;
+	calculateLogCodonProbabilityCoefficients(numCodons, mutation, selection, offset, slope, inDenominator,
+		initialDenominator);
+
 	double logLikelihood = 0.0;
-	// calculate codon probabilities
-	double logCodonProbabilities[6];
-	calculateLogCodonProbabilityVector(numCodons, mutation, selection, phiValue, logCodonProbabilities);
+	for (unsigned i = 0u; i < numCodons; i++)
+	{
+		logLikelihood += offset[i] * sufficientStatisticCodonCount[aaIndex][mixture * 6 + i]
+			- slope[i] * sufficientStatisticCodonCountPhi[aaIndex][mixture * 6 + i];
+	}
+
+	std::vector<double> &phiValues = sufficientStatisticPhi[aaIndex][mixture];
+	std::vector<double> &aaCounts = sufficientStatisticAACount[aaIndex][mixture];
+	double logDenominatorSum = 0.0;
+	for (unsigned g = 0u; g < phiValues.size(); g++)
+	{
+		double denominator = initialDenominator;
+		for (unsigned i = 0u; i < numCodons; i++)
+		{
+			if (inDenominator[i])
+				denominator += std::exp(offset[i] - (slope[i] * phiValues[g]));
+		}
+		logDenominatorSum += aaCounts[g] * std::log(denominator);
+	}
+	return logLikelihood - logDenominatorSum;
+}
+
+
+/* calculateLogLikelihoodPerAAForGeneBlock (NOT EXPOSED)
+ * Arguments: number of codons of the AA, codon counts of each codon of the AA for all genes (codonCountsPerGene[codon][gene]),
+ * first and one past last gene of the block, current and proposed mutation and selection parameters of all mixture
+ * elements (5 values per mixture element), references the current and proposed log likelihoods are added to.
+ * Within a block of at most geneBatchSize genes, the genes of each mixture element are evaluated together, since they
+ * share the mutation and selection parameters. Genes without the AA are skipped. The results are added in gene order.
+*/
+void ROCModel::calculateLogLikelihoodPerAAForGeneBlock(unsigned numCodons, const unsigned *codonCountsPerGene[],
+	unsigned blockStart, unsigned blockEnd, double mutation[], double selection[], double mutation_proposed[],
+	double selection_proposed[], double &likelihood, double &likelihood_proposed)
+{
+	unsigned numMixtures = parameter->getNumMixtureElements();
+	double geneLikelihood[geneBatchSize];
+	double geneLikelihood_proposed[geneBatchSize];
+	bool geneHasAA[geneBatchSize];
+	unsigned batchGenes[geneBatchSize];
+	double batchPhi[geneBatchSize];
+	int batchCodonCounts[6 * geneBatchSize];
+	double batchLikelihood[geneBatchSize];
+	double batchLikelihood_proposed[geneBatchSize];
+
+	// skip genes without the AA. Avoid useless calculations and multiplying by 0
+	for (unsigned i = blockStart; i < blockEnd; i++)
+	{
+		unsigned aaCount = 0u;
+		for (unsigned j = 0u; j < numCodons; j++)
+			aaCount += codonCountsPerGene[j][i];
+		geneHasAA[i - blockStart] = (aaCount != 0u);
+	}
+
+	for (unsigned k = 0u; k < numMixtures; k++)
+	{
+		// which genes of this block belong to mixture element k
+		unsigned batchSize = 0u;
+		for (unsigned i = blockStart; i < blockEnd; i++)
+		{
+			if (!geneHasAA[i - blockStart] || parameter->getMixtureAssignment(i) != k) continue;
+			batchGenes[batchSize] = i;
+			batchSize++;
+		}
+		if (batchSize == 0u) continue;
+
+		// how is the mixture element defined. Which categories make it up
+		unsigned expressionCategory = parameter->getSynthesisRateCategory(k);
+		for (unsigned g = 0u; g < batchSize; g++)
+		{
+			unsigned i = batchGenes[g];
+			// get phi value, calculate likelihood conditional on phi
+			batchPhi[g] = parameter->getSynthesisRate(i, expressionCategory, false);
+			for (unsigned j = 0u; j < numCodons; j++)
+				batchCodonCounts[j * batchSize + g] = codonCountsPerGene[j][i];
+		}
+
+		calculateLogLikelihoodPerAAForGeneBatch(numCodons, &mutation[k * 5], &selection[k * 5], batchSize, batchPhi,
+			batchCodonCounts, batchLikelihood);
+		calculateLogLikelihoodPerAAForGeneBatch(numCodons, &mutation_proposed[k * 5], &selection_proposed[k * 5],
+			batchSize, batchPhi, batchCodonCounts, batchLikelihood_proposed);
+		for (unsigned g = 0u; g < batchSize; g++)
+		{
+			geneLikelihood[batchGenes[g] - blockStart] = batchLikelihood[g];
+			geneLikelihood_proposed[batchGenes[g] - blockStart] = batchLikelihood_proposed[g];
+		}
+	}
+
+	for (unsigned i = blockStart; i < blockEnd; i++)
+	{
+		if (!geneHasAA[i - blockStart]) continue;
+		likelihood += geneLikelihood[i - blockStart];
+		likelihood_proposed += geneLikelihood_proposed[i - blockStart];
+	}
+}
 
-	// calculate likelihood for current AA for this combination of selection and mutation category
-	for (unsigned i = 0; i < numCodons; i++)
+
+/* calculateLogAcceptanceRatioForGrouping (NOT EXPOSED)
+ * Arguments: grouping, current and proposed log likelihood of the grouping, vector receiving the log acceptance ratio,
+ * the current and proposed log likelihood and the current and proposed log posterior (in this order).
+ * Adds the mutation prior to the log likelihoods unless the mutation parameters are fixed.
+*/
+void ROCModel::calculateLogAcceptanceRatioForGrouping(std::string grouping, double likelihood, double likelihood_proposed,
+	std::vector<double> &logAcceptanceRatioForAllMixtures)
+{
+	double posterior, posterior_proposed;
+	bool dm_fixed = parameter -> isDMFixed();
+	if (!dm_fixed)
+	{
+		posterior_proposed = likelihood_proposed + calculateMutationPrior(grouping, true);
+		posterior = likelihood + calculateMutationPrior(grouping, false);
+	}
+	else
 	{
-		if (codonCount[i] == 0) continue;
-	//	my_print("\tCurrent LogLike for codon i: %\n",logLikelihood);
-		logLikelihood += logCodonProbabilities[i] * codonCount[i];
-	// my_print("\t%\t%\t%\t%\t%\n",numCodons,logCodonProbabilities[i],codonCount[i],(logCodonProbabilities[i]*codonCount[i]),logLikelihood);
+		posterior_proposed = likelihood_proposed;
+		posterior = likelihood;
 	}
-	return logLikelihood;
+	logAcceptanceRatioForAllMixtures[0] = (posterior_proposed - posterior);
+	logAcceptanceRatioForAllMixtures[1] = likelihood;
+	logAcceptanceRatioForAllMixtures[2] = likelihood_proposed;
+	logAcceptanceRatioForAllMixtures[3] = posterior;
+	logAcceptanceRatioForAllMixtures[4] = posterior_proposed;
 }
 
 
@@ -59,10 +306,10 @@ double ROCModel::calculateMutationPrior(std::string grouping, bool proposed)
 }
 
 
-void ROCModel::obtainCodonCount(SequenceSummary *sequenceSummary, std::string curAA, int codonCount[])
+void ROCModel::obtainCodonCount(SequenceSummary *sequenceSummary, unsigned aaIndex, int codonCount[])
 {
 	unsigned aaStart, aaEnd;
-	SequenceSummary::AAToCodonRange(curAA, aaStart, aaEnd, false);
+	SequenceSummary::AAIndexToCodonRange(aaIndex, aaStart, aaEnd, false);
 	// get codon counts for AA
 	unsigned j = 0u;
 	for (unsigned i = aaStart; i < aaEnd; i++, j++)
@@ -96,27 +343,60 @@ void ROCModel::calculateLogLikelihoodRatioPerGene(Gene& gene, unsigned geneIndex
 	double mutation[5];
 	double selection[5];
 	int codonCount[6];
-#ifdef _OPENMP
-//#ifndef __APPLE__
-#pragma omp parallel for private(mutation, selection, codonCount) reduction(+:logLikelihood,logLikelihood_proposed)
-#endif
-	for (unsigned i = 0u; i < getGroupListSize(); i++)
+	// current and proposed phi are evaluated as a batch of two, or only the proposed phi if the current term is cached
+	double phiValues[2] = {phiValue, phiValue_proposed};
+	int codonCounts[12];
+	double logLikelihoods[2];
+	double cachedLogLikelihood = 0.0;
+	bool useCache = useLogLikelihoodCache && logLikelihoodCache.hasEntry(geneIndex, k);
+	if (useCache)
+	{
+		logLikelihoodCache.setCurrentPhi(geneIndex, k, phiValue);
+		logLikelihoodCache.setProposedPhi(geneIndex, k, phiValue_proposed);
+	}
+	// No OpenMP here: this is called once per gene and mixture, and MCMCAlgorithm already
+	// distributes the genes over the threads. Forking a team for ~20 amino acids costs more than it saves.
+	unsigned numGroupings = getGroupListSize();
+	// groupingAAIndex is set up in setParameter. Fall back to the lookup by name if the group list changed since.
+	bool useGroupingAAIndex = (groupingAAIndex.size() == numGroupings);
+	for (unsigned i = 0u; i < numGroupings; i++)
 	{
-		std::string curAA = getGrouping(i);
+		unsigned aaIndex = useGroupingAAIndex ? groupingAAIndex[i] : SequenceSummary::AAToAAIndex(getGrouping(i));
 
 		// skip amino acids which do not occur in current gene. Avoid useless calculations and multiplying by 0
 		if (sequenceSummary->getAACountForAA(i) == 0) continue;
 
 		// get number of codons for AA (total number not parameter->count)
-		unsigned numCodons = sequenceSummary->GetNumCodonsForAA(curAA);
+		unsigned aaStart, aaEnd;
+		SequenceSummary::AAIndexToCodonRange(aaIndex, aaStart, aaEnd, false);
+		unsigned numCodons = aaEnd - aaStart;
 		// get mutation and selection parameter->for gene
-		parameter->getParameterForCategory(mutationCategory, ROCParameter::dM, curAA, false, mutation);
-		parameter->getParameterForCategory(selectionCategory, ROCParameter::dEta, curAA, false, selection);
-		// get codon occurrence in sequence
-		obtainCodonCount(sequenceSummary, curAA, codonCount);
+		parameter->getParameterForCategory(mutationCategory, ROCParameter::dM, aaIndex, false, mutation);
+		parameter->getParameterForCategory(selectionCategory, ROCParameter::dEta, aaIndex, false, selection);
+		obtainCodonCount(sequenceSummary, aaIndex, codonCount);
 
-		logLikelihood += calculateLogLikelihoodPerAAPerGene(numCodons, codonCount, mutation, selection, phiValue);
-		logLikelihood_proposed += calculateLogLikelihoodPerAAPerGene(numCodons, codonCount, mutation, selection, phiValue_proposed);
+		if (useCache && logLikelihoodCache.getCurrent(geneIndex, k, i, cachedLogLikelihood))
+		{
+			calculateLogLikelihoodPerAAForGeneBatch(numCodons, mutation, selection, 1u, phiValues + 1, codonCount, logLikelihoods + 1);
+			logLikelihoods[0] = cachedLogLikelihood;
+		}
+		else
+		{
+			// get codon occurrence in sequence, once for the current and once for the proposed phi
+			for (unsigned j = 0u; j < numCodons; j++)
+			{
+				codonCounts[2 * j] = codonCount[j];
+				codonCounts[2 * j + 1] = codonCount[j];
+			}
+			calculateLogLikelihoodPerAAForGeneBatch(numCodons, mutation, selection, 2u, phiValues, codonCounts, logLikelihoods);
+			if (useCache)
+				logLikelihoodCache.setCurrent(geneIndex, k, i, logLikelihoods[0]);
+		}
+		if (useCache)
+			logLikelihoodCache.setProposed(geneIndex, k, i, logLikelihoods[1]);
+
+		logLikelihood += logLikelihoods[0];
+		logLikelihood_proposed += logLikelihoods[1];
 	}
 	unsigned mixture = getMixtureAssignment(geneIndex);
 	mixture = getSynthesisRateCategory(mixture);
@@ -156,89 +436,326 @@ void ROCModel::calculateLogLikelihoodRatioPerGene(Gene& gene, unsigned geneIndex
 
 void ROCModel::calculateLogLikelihoodRatioPerGroupingPerCategory(std::string grouping, Genome& genome, std::vector<double> &logAcceptanceRatioForAllMixtures)
 {
-	int numGenes = genome.getGenomeSize();
-	unsigned numCodons = SequenceSummary::GetNumCodonsForAA(grouping);
+	unsigned numGenes = genome.getGenomeSize();
+	unsigned aaIndex = SequenceSummary::AAToAAIndex(grouping);
+	unsigned aaStart, aaEnd;
+	SequenceSummary::AAIndexToCodonRange(aaIndex, aaStart, aaEnd, false);
+	unsigned numCodons = aaEnd - aaStart;
 	//my_print("Current grouping: %\n",grouping);
 	double likelihood = 0.0;
 	double likelihood_proposed = 0.0;
-	double posterior, posterior_proposed;
-	double mutation[5];
-	double selection[5];
-	double mutation_proposed[5];
-	double selection_proposed[5];
 
-	int codonCount[6];
-	Gene *gene;
-	SequenceSummary *sequenceSummary;
-	unsigned aaIndex = SequenceSummary::AAToAAIndex(grouping);
+	// Mutation and selection parameters only depend on the mixture element, get them once per mixture
+	// instead of once per gene. Five values per mixture element, the maximum number of parameters per AA.
+	unsigned numMixtures = parameter->getNumMixtureElements();
+	std::vector <double> mutation(numMixtures * 5, 0.0);
+	std::vector <double> selection(numMixtures * 5, 0.0);
+	std::vector <double> mutation_proposed(numMixtures * 5, 0.0);
+	std::vector <double> selection_proposed(numMixtures * 5, 0.0);
+	for (unsigned k = 0u; k < numMixtures; k++)
+	{
+		unsigned mutationCategory = parameter->getMutationCategory(k);
+		unsigned selectionCategory = parameter->getSelectionCategory(k);
+		parameter->getParameterForCategory(mutationCategory, ROCParameter::dM, aaIndex, false, &mutation[k * 5]);
+		parameter->getParameterForCategory(selectionCategory, ROCParameter::dEta, aaIndex, false, &selection[k * 5]);
+		parameter->getParameterForCategory(mutationCategory, ROCParameter::dM, aaIndex, true, &mutation_proposed[k * 5]);
+		parameter->getParameterForCategory(selectionCategory, ROCParameter::dEta, aaIndex, true, &selection_proposed[k * 5]);
+	}
+
+	if (useSufficientStatistics && sufficientStatisticPhi.size() != 0)
+	{
+		for (unsigned k = 0u; k < numMixtures; k++)
+		{
+			likelihood += calculateLogLikelihoodPerAAFromSufficientStatistics(numCodons, &mutation[k * 5],
+				&selection[k * 5], aaIndex, k);
+			likelihood_proposed += calculateLogLikelihoodPerAAFromSufficientStatistics(numCodons,
+				&mutation_proposed[k * 5], &selection_proposed[k * 5], aaIndex, k);
+		}
+	}
+	else
+	{
+		// codon counts of this AA for all genes, read straight from the genome's codon count matrix
+		const unsigned *codonCountsPerGene[6];
+		for (unsigned j = 0u; j < numCodons; j++)
+			codonCountsPerGene[j] = genome.getCodonCountsForCodonIndex(aaStart + j);
+
+		countGenomeTraversal(numGenes, numCodons * sizeof(unsigned) + sizeof(double) + sizeof(unsigned));
+
+		// Genes are processed in blocks of geneBatchSize, see calculateLogLikelihoodPerAAForGeneBlock.
+		int numBlocks = (int)((numGenes + geneBatchSize - 1) / geneBatchSize);
 #ifdef _OPENMP
 //#ifndef __APPLE__
-#pragma omp parallel for private(mutation, selection, mutation_proposed, selection_proposed, codonCount, gene, sequenceSummary) reduction(+:likelihood,likelihood_proposed)
+#pragma omp parallel for reduction(+:likelihood,likelihood_proposed)
 #endif
-	for (unsigned i = 0u; i < numGenes; i++)
+		for (int block = 0; block < numBlocks; block++)
+		{
+			unsigned blockStart = block * geneBatchSize;
+			unsigned blockEnd = std::min(blockStart + geneBatchSize, numGenes);
+			calculateLogLikelihoodPerAAForGeneBlock(numCodons, codonCountsPerGene, blockStart, blockEnd, &mutation[0],
+				&selection[0], &mutation_proposed[0], &selection_proposed[0], likelihood, likelihood_proposed);
+		}
+	}
+	calculateLogAcceptanceRatioForGrouping(grouping, likelihood, likelihood_proposed, logAcceptanceRatioForAllMixtures);
+}
+
+
+/* calculateLogLikelihoodRatioForAllGroupings (NOT EXPOSED)
+ * Arguments: reference to the genome, vector receiving the result of calculateLogLikelihoodRatioPerGroupingPerCategory
+ * for each grouping (in group list order).
+ * Evaluates all groupings in a single pass over the genome, see calculateLogLikelihoodRatioInOnePass. With sufficient
+ * statistics the genome is not traversed and the groupings are evaluated one by one.
+*/
+void ROCModel::calculateLogLikelihoodRatioForAllGroupings(Genome& genome, std::vector<std::vector<double>> &logAcceptanceRatioForAllGroupings)
+{
+	if (useSufficientStatistics && sufficientStatisticPhi.size() != 0)
 	{
-		gene = &genome.getGene(i);
-		sequenceSummary = gene->getSequenceSummary();
-		if (sequenceSummary->getAACountForAA(aaIndex) == 0) continue;
+		Model::calculateLogLikelihoodRatioForAllGroupings(genome, logAcceptanceRatioForAllGroupings);
+		return;
+	}
+	std::vector <double> logProbabilityRatio;
+	calculateLogLikelihoodRatioInOnePass(genome, logAcceptanceRatioForAllGroupings, false, logProbabilityRatio);
+}
 
-		// which mixture element does this gene belong to
-		unsigned mixtureElement = parameter->getMixtureAssignment(i);
-		// how is the mixture element defined. Which categories make it up
-		unsigned mutationCategory = parameter->getMutationCategory(mixtureElement);
-		unsigned selectionCategory = parameter->getSelectionCategory(mixtureElement);
-		unsigned expressionCategory = parameter->getSynthesisRateCategory(mixtureElement);
-		// get phi value, calculate likelihood conditional on phi
-		double phiValue = parameter->getSynthesisRate(i, expressionCategory, false);
-
-		// get current mutation and selection parameter
-		parameter->getParameterForCategory(mutationCategory, ROCParameter::dM, grouping, false, mutation);
-		parameter->getParameterForCategory(selectionCategory, ROCParameter::dEta, grouping, false, selection);
-		// get proposed mutation and selection parameter
-		parameter->getParameterForCategory(mutationCategory, ROCParameter::dM, grouping, true, mutation_proposed);
-		parameter->getParameterForCategory(selectionCategory, ROCParameter::dEta, grouping, true, selection_proposed);
-		obtainCodonCount(sequenceSummary, grouping, codonCount);
-		likelihood += calculateLogLikelihoodPerAAPerGene(numCodons, codonCount, mutation, selection, phiValue);
-		likelihood_proposed += calculateLogLikelihoodPerAAPerGene(numCodons, codonCount, mutation_proposed, selection_proposed, phiValue);
+
+/* calculateLogLikelihoodRatioForAllGroupingsAndHyperParameters (NOT EXPOSED)
+ * Arguments: reference to the genome, current iteration, vector receiving the log acceptance ratios of all groupings,
+ * vector receiving the log acceptance ratios of the hyper parameters.
+ * Evaluates the codon specific parameters and the hyper parameters in the same pass over the genome, see
+ * calculateLogLikelihoodRatioInOnePass. The hyper parameter ratios are identical to the ones of
+ * calculateLogLikelihoodRatioForHyperParameters.
+*/
+void ROCModel::calculateLogLikelihoodRatioForAllGroupingsAndHyperParameters(Genome &genome, unsigned iteration,
+	std::vector<std::vector<double>> &logAcceptanceRatioForAllGroupings, std::vector <double> &logProbabilityRatio)
+{
+	if (useSufficientStatistics && sufficientStatisticPhi.size() != 0)
+	{
+		Model::calculateLogLikelihoodRatioForAllGroupingsAndHyperParameters(genome, iteration,
+			logAcceptanceRatioForAllGroupings, logProbabilityRatio);
+		return;
 	}
-	bool dm_fixed = parameter -> isDMFixed();
-	if (!dm_fixed)
+	calculateLogLikelihoodRatioInOnePass(genome, logAcceptanceRatioForAllGroupings, true, logProbabilityRatio);
+}
+
+
+/* calculateLogLikelihoodRatioInOnePass (NOT EXPOSED)
+ * Arguments: reference to the genome, vector receiving the log acceptance ratios of all groupings, whether to evaluate
+ * the hyper parameters as well, vector receiving the log acceptance ratios of the hyper parameters.
+ * Genes are processed in blocks of geneBatchSize and every block is evaluated for all groupings (and the per gene
+ * terms of the hyper parameters) before moving on, so the codon counts and phi values of a block are read once per
+ * iteration instead of once per grouping, and there is a single parallel region. Block results are summed in block
+ * order and hyper parameter terms in gene order, which makes the result independent of the number of threads.
+*/
+void ROCModel::calculateLogLikelihoodRatioInOnePass(Genome& genome, std::vector<std::vector<double>> &logAcceptanceRatioForAllGroupings,
+	bool withHyperParameters, std::vector <double> &logProbabilityRatio)
+{
+	unsigned numGenes = genome.getGenomeSize();
+	unsigned numGroupings = getGroupListSize();
+	unsigned numMixtures = parameter->getNumMixtureElements();
+	unsigned numParam = numMixtures * 5; // parameters per grouping, five per mixture element
+	bool useGroupingAAIndex = (groupingAAIndex.size() == numGroupings);
+
+	std::vector <unsigned> numCodons(numGroupings, 0u);
+	std::vector <const unsigned*> codonCountsPerGene(numGroupings * 6, (const unsigned*)0);
+	std::vector <double> mutation(numGroupings * numParam, 0.0);
+	std::vector <double> selection(numGroupings * numParam, 0.0);
+	std::vector <double> mutation_proposed(numGroupings * numParam, 0.0);
+	std::vector <double> selection_proposed(numGroupings * numParam, 0.0);
+	unsigned totalNumCodons = 0u;
+	for (unsigned a = 0u; a < numGroupings; a++)
 	{
-		posterior_proposed = likelihood_proposed + calculateMutationPrior(grouping, true);
-		posterior = likelihood + calculateMutationPrior(grouping, false);
+		unsigned aaIndex = useGroupingAAIndex ? groupingAAIndex[a] : SequenceSummary::AAToAAIndex(getGrouping(a));
+		unsigned aaStart, aaEnd;
+		SequenceSummary::AAIndexToCodonRange(aaIndex, aaStart, aaEnd, false);
+		numCodons[a] = aaEnd - aaStart;
+		totalNumCodons += numCodons[a];
+		// getCodonCountsForCodonIndex may rebuild the codon count matrix, keep it out of the parallel region
+		for (unsigned j = 0u; j < numCodons[a]; j++)
+			codonCountsPerGene[a * 6 + j] = genome.getCodonCountsForCodonIndex(aaStart + j);
+
+		for (unsigned k = 0u; k < numMixtures; k++)
+		{
+			unsigned mutationCategory = parameter->getMutationCategory(k);
+			unsigned selectionCategory = parameter->getSelectionCategory(k);
+			unsigned offset = a * numParam + k * 5;
+			parameter->getParameterForCategory(mutationCategory, ROCParameter::dM, aaIndex, false, &mutation[offset]);
+			parameter->getParameterForCategory(selectionCategory, ROCParameter::dEta, aaIndex, false, &selection[offset]);
+			parameter->getParameterForCategory(mutationCategory, ROCParameter::dM, aaIndex, true, &mutation_proposed[offset]);
+			parameter->getParameterForCategory(selectionCategory, ROCParameter::dEta, aaIndex, true, &selection_proposed[offset]);
+		}
 	}
-	else
-  {
-		posterior_proposed = likelihood_proposed;
-		posterior = likelihood;
+
+	HyperParameterValues hyperParameterValues;
+	double jacobian = 0.0;
+	unsigned numTerms = 0u;
+	if (withHyperParameters)
+	{
+		jacobian = initHyperParameterValues(hyperParameterValues);
+		numTerms = hyperParameterValues.noiseOffset.size() + 1u;
 	}
-	logAcceptanceRatioForAllMixtures[0] = (posterior_proposed - posterior);
-	logAcceptanceRatioForAllMixtures[1] = likelihood;
-	logAcceptanceRatioForAllMixtures[2] = likelihood_proposed;
-	logAcceptanceRatioForAllMixtures[3] = posterior;
-	logAcceptanceRatioForAllMixtures[4] = posterior_proposed;
+	std::vector <double> hyperParameterTerms(numGenes * numTerms, 0.0); //order: gene, term
+
+	int numBlocks = (int)((numGenes + geneBatchSize - 1) / geneBatchSize);
+	std::vector <double> blockLikelihood(numBlocks * numGroupings, 0.0); //order: block, grouping
+	std::vector <double> blockLikelihood_proposed(numBlocks * numGroupings, 0.0);
+#ifdef _OPENMP
+//#ifndef __APPLE__
+#pragma omp parallel for schedule(dynamic)
+#endif
+	for (int block = 0; block < numBlocks; block++)
+	{
+		unsigned blockStart = block * geneBatchSize;
+		unsigned blockEnd = std::min(blockStart + geneBatchSize, numGenes);
+		for (unsigned a = 0u; a < numGroupings; a++)
+		{
+			unsigned offset = a * numParam;
+			calculateLogLikelihoodPerAAForGeneBlock(numCodons[a], &codonCountsPerGene[a * 6], blockStart, blockEnd,
+				&mutation[offset], &selection[offset], &mutation_proposed[offset], &selection_proposed[offset],
+				blockLikelihood[block * numGroupings + a], blockLikelihood_proposed[block * numGroupings + a]);
+		}
+		if (withHyperParameters)
+		{
+			for (unsigned i = blockStart; i < blockEnd; i++)
+				calculateHyperParameterTermsForGene(genome, i, hyperParameterValues, &hyperParameterTerms[i * numTerms]);
+		}
+	}
+
+	logAcceptanceRatioForAllGroupings.resize(numGroupings);
+	for (unsigned a = 0u; a < numGroupings; a++)
+	{
+		double likelihood = 0.0;
+		double likelihood_proposed = 0.0;
+		for (int block = 0; block < numBlocks; block++)
+		{
+			likelihood += blockLikelihood[block * numGroupings + a];
+			likelihood_proposed += blockLikelihood_proposed[block * numGroupings + a];
+		}
+		logAcceptanceRatioForAllGroupings[a].resize(5, 0.0);
+		calculateLogAcceptanceRatioForGrouping(getGrouping(a), likelihood, likelihood_proposed,
+			logAcceptanceRatioForAllGroupings[a]);
+	}
+
+	unsigned bytesPerGene = totalNumCodons * sizeof(unsigned) + sizeof(double) + sizeof(unsigned);
+	if (withHyperParameters)
+	{
+		sumHyperParameterTerms(genome, jacobian, numTerms, &hyperParameterTerms[0], logProbabilityRatio);
+		bytesPerGene += (numTerms - 1u) * sizeof(double); // observed phi values
+	}
+	countGenomeTraversal(numGenes, bytesPerGene);
+}
+
+
+/* supportsSinglePassCodonSpecificUpdate (NOT EXPOSED)
+ * Arguments: None
+ * The log acceptance ratio of an amino acid only depends on its own codon specific parameters and phi, see
+ * Model::supportsSinglePassCodonSpecificUpdate.
+*/
+bool ROCModel::supportsSinglePassCodonSpecificUpdate()
+{
+	return true;
 }
 
 
 void ROCModel::calculateLogLikelihoodRatioForHyperParameters(Genome &genome, unsigned iteration, std::vector <double> &logProbabilityRatio)
+{
+	HyperParameterValues hyperParameterValues;
+	double jacobian = initHyperParameterValues(hyperParameterValues);
+	unsigned numTerms = hyperParameterValues.noiseOffset.size() + 1u;
+	unsigned numGenes = genome.getGenomeSize();
+
+	// stdDevSynthesisRate and all noise offsets in one pass over the genome
+	std::vector <double> hyperParameterTerms(numGenes * numTerms, 0.0); //order: gene, term
+	for (unsigned i = 0u; i < numGenes; i++)
+		calculateHyperParameterTermsForGene(genome, i, hyperParameterValues, &hyperParameterTerms[i * numTerms]);
+
+	sumHyperParameterTerms(genome, jacobian, numTerms, &hyperParameterTerms[0], logProbabilityRatio);
+	countGenomeTraversal(numGenes, numTerms * sizeof(double) + sizeof(unsigned));
+}
+
+
+/* initHyperParameterValues (NOT EXPOSED)
+ * Arguments: reference to the values to fill
+ * Collects the current and proposed stdDevSynthesisRate of every synthesis rate category and, with observed phi, the
+ * current and proposed noise offset and the observed synthesis noise of every observed phi set. Returns the log Jacobian
+ * of the stdDevSynthesisRate proposals.
+*/
+double ROCModel::initHyperParameterValues(HyperParameterValues &values)
 {
 	double lpr = 0.0;
 	unsigned selectionCategory = getNumSynthesisRateCategories();
-	std::vector<double> currentStdDevSynthesisRate(selectionCategory, 0.0);
-	std::vector<double> currentMphi(selectionCategory, 0.0);
-	std::vector<double> proposedStdDevSynthesisRate(selectionCategory, 0.0);
-	std::vector<double> proposedMphi(selectionCategory, 0.0);
+	values.currentStdDevSynthesisRate.assign(selectionCategory, 0.0);
+	values.currentMphi.assign(selectionCategory, 0.0);
+	values.proposedStdDevSynthesisRate.assign(selectionCategory, 0.0);
+	values.proposedMphi.assign(selectionCategory, 0.0);
 
 	//Calculating reverse jump probabilities due to asymmetry of logNormal
 	for (unsigned i = 0u; i < selectionCategory; i++)
 	{
-		currentStdDevSynthesisRate[i] = getStdDevSynthesisRate(i, false);
-		currentMphi[i] = -((currentStdDevSynthesisRate[i] * currentStdDevSynthesisRate[i]) * 0.5);
-		proposedStdDevSynthesisRate[i] = getStdDevSynthesisRate(i, true);
-		proposedMphi[i] = -((proposedStdDevSynthesisRate[i] * proposedStdDevSynthesisRate[i]) * 0.5);
+		values.currentStdDevSynthesisRate[i] = getStdDevSynthesisRate(i, false);
+		values.currentMphi[i] = -((values.currentStdDevSynthesisRate[i] * values.currentStdDevSynthesisRate[i]) * 0.5);
+		values.proposedStdDevSynthesisRate[i] = getStdDevSynthesisRate(i, true);
+		values.proposedMphi[i] = -((values.proposedStdDevSynthesisRate[i] * values.proposedStdDevSynthesisRate[i]) * 0.5);
 		// take the Jacobian into account for the non-linear transformation from logN to N distribution
-		lpr -= (std::log(currentStdDevSynthesisRate[i]) - std::log(proposedStdDevSynthesisRate[i]));
+		lpr -= (std::log(values.currentStdDevSynthesisRate[i]) - std::log(values.proposedStdDevSynthesisRate[i]));
+	}
+
+	unsigned numObservedPhiSets = withPhi ? parameter->getNumObservedPhiSets() : 0u;
+	values.noiseOffset.assign(numObservedPhiSets, 0.0);
+	values.noiseOffset_proposed.assign(numObservedPhiSets, 0.0);
+	values.observedSynthesisNoise.assign(numObservedPhiSets, 0.0);
+	for (unsigned i = 0u; i < numObservedPhiSets; i++)
+	{
+		values.noiseOffset[i] = getNoiseOffset(i, false);
+		values.noiseOffset_proposed[i] = getNoiseOffset(i, true);
+		values.observedSynthesisNoise[i] = getObservedSynthesisNoise(i);
 	}
+	return lpr;
+}
+
+
+/* calculateHyperParameterTermsForGene (NOT EXPOSED)
+ * Arguments: reference to the genome, gene index, current and proposed hyper parameters, array receiving the terms
+ * Calculates the contribution of one gene to the log acceptance ratio of stdDevSynthesisRate (terms[0]) and of the
+ * noise offset of each observed phi set (terms[1 + set], 0 if the observation is missing).
+*/
+void ROCModel::calculateHyperParameterTermsForGene(Genome &genome, unsigned gene, HyperParameterValues &values, double terms[])
+{
+	unsigned mixture = getMixtureAssignment(gene);
+	mixture = getSynthesisRateCategory(mixture);
+	double phi = getSynthesisRate(gene, mixture, false);
+
+	terms[0] = Parameter::densityLogNorm(phi, values.proposedMphi[mixture], values.proposedStdDevSynthesisRate[mixture], true)
+		- Parameter::densityLogNorm(phi, values.currentMphi[mixture], values.currentStdDevSynthesisRate[mixture], true);
+
+	unsigned numObservedPhiSets = values.noiseOffset.size();
+	if (numObservedPhiSets == 0u) return;
+
+	double logPhi = std::log(phi);
+	Gene &currentGene = genome.getGene(gene);
+	for (unsigned i = 0u; i < numObservedPhiSets; i++)
+	{
+		terms[i + 1] = 0.0;
+		double obsPhi = currentGene.getObservedSynthesisRate(i);
+		if (obsPhi > -1.0)
+		{
+			double logObsPhi = std::log(obsPhi);
+			double proposed = Parameter::densityNorm(logObsPhi, logPhi + values.noiseOffset_proposed[i], values.observedSynthesisNoise[i], true);
+			double current = Parameter::densityNorm(logObsPhi, logPhi + values.noiseOffset[i], values.observedSynthesisNoise[i], true);
+			terms[i + 1] = proposed - current;
+		}
+	}
+}
 
+
+/* sumHyperParameterTerms (NOT EXPOSED)
+ * Arguments: reference to the genome, log Jacobian of the stdDevSynthesisRate proposal, number of terms per gene,
+ * per gene terms (see calculateHyperParameterTermsForGene), vector receiving the log acceptance ratios.
+ * Sums the terms in gene order: element 0 is the ratio of stdDevSynthesisRate, with observed phi followed by the ratio
+ * of every noise offset.
+*/
+void ROCModel::sumHyperParameterTerms(Genome &genome, double jacobian, unsigned numTerms, const double hyperParameterTerms[],
+	std::vector <double> &logProbabilityRatio)
+{
+	unsigned numGenes = genome.getGenomeSize();
 	if (withPhi)
 	{
 		// one for each noiseOffset, and one for stdDevSynthesisRate
@@ -247,53 +764,27 @@ void ROCModel::calculateLogLikelihoodRatioForHyperParameters(Genome &genome, uns
 	else
 		logProbabilityRatio.resize(1);
 
-#ifdef _OPENMP
-//#ifndef __APPLE__
-//#pragma omp parallel for reduction(+:lpr)
-#endif
-	for (unsigned i = 0u; i < genome.getGenomeSize(); i++)
+	double lpr = jacobian;
+	for (unsigned i = 0u; i < numGenes; i++)
 	{
-		unsigned mixture = getMixtureAssignment(i);
-		mixture = getSynthesisRateCategory(mixture);
-		double phi = getSynthesisRate(i, mixture, false);
-		if (!std::isfinite(phi))
-			my_printError("Error: Phi value for gene % is not finite (%)!", i, phi);
-
-		lpr += Parameter::densityLogNorm(phi, proposedMphi[mixture], proposedStdDevSynthesisRate[mixture], true)
-			   - Parameter::densityLogNorm(phi, currentMphi[mixture], currentStdDevSynthesisRate[mixture], true);
+		double term = hyperParameterTerms[i * numTerms];
+		if (!std::isfinite(term))
+		{
+			double phi = getSynthesisRate(i, getSynthesisRateCategory(getMixtureAssignment(i)), false);
+			if (!std::isfinite(phi))
+				my_printError("Error: Phi value for gene % is not finite (%)!", i, phi);
+		}
+		lpr += term;
 	}
-
 	// TODO: USE CONSTANTS INSTEAD OF 0
 	logProbabilityRatio[0] = lpr;
 
-	if (withPhi)
+	for (unsigned j = 1u; j < numTerms; j++)
 	{
-		for (unsigned i = 0; i < parameter->getNumObservedPhiSets(); i++)
-		{
-			lpr = 0.0;
-			double noiseOffset = getNoiseOffset(i, false);
-			double noiseOffset_proposed = getNoiseOffset(i, true);
-			double observedSynthesisNoise = getObservedSynthesisNoise(i);
-#ifdef _OPENMP
-//#ifndef __APPLE__
-//#pragma omp parallel for reduction(+:lpr)
-#endif
-			for (unsigned j = 0u; j < genome.getGenomeSize(); j++)
-			{
-				unsigned mixtureAssignment = getMixtureAssignment(j);
-				mixtureAssignment = getSynthesisRateCategory(mixtureAssignment);
-				double logPhi = std::log(getSynthesisRate(j, mixtureAssignment, false));
-				double obsPhi = genome.getGene(j).getObservedSynthesisRate(i);
-				if (obsPhi > -1.0)
-				{
-					double logObsPhi = std::log(obsPhi);
-					double proposed = Parameter::densityNorm(logObsPhi, logPhi + noiseOffset_proposed, observedSynthesisNoise, true);
-					double current = Parameter::densityNorm(logObsPhi, logPhi + noiseOffset, observedSynthesisNoise, true);
-					lpr += proposed - current;
-				}
-			}
-			logProbabilityRatio[i+1] = lpr;
-		}
+		lpr = 0.0;
+		for (unsigned i = 0u; i < numGenes; i++)
+			lpr += hyperParameterTerms[i * numTerms + j];
+		logProbabilityRatio[j] = lpr;
 	}
 }
 
@@ -309,6 +800,7 @@ void ROCModel::calculateLogLikelihoodRatioForHyperParameters(Genome &genome, uns
 void ROCModel::initTraces(unsigned samples, unsigned num_genes, bool estimateSynthesisRate)
 {
 	parameter -> initAllTraces(samples, num_genes,estimateSynthesisRate);
+	initLogLikelihoodCache(num_genes);
 }
 
 
@@ -469,6 +961,12 @@ void ROCModel::updateMixtureAssignmentTrace(unsigned sample, unsigned i)
 }
 
 
+void ROCModel::updateSynthesisRateTraces(unsigned sample)
+{
+	parameter->updateSynthesisRateTraces(sample);
+}
+
+
 void ROCModel::updateMixtureProbabilitiesTrace(unsigned sample)
 {
 	parameter->updateMixtureProbabilitiesTrace(sample);
@@ -507,6 +1005,18 @@ void ROCModel::updateTracesWithInitialValues(Genome &genome)
 }
 
 
+bool ROCModel::flushTraces()
+{
+	return parameter->flushTraces();
+}
+
+
+bool ROCModel::hasTraceFileWriteFailed()
+{
+	return parameter->hasTraceFileWriteFailed();
+}
+
+
 
 
 
@@ -614,6 +1124,170 @@ void ROCModel::setCategoryProbability(unsigned mixture, double value)
 void ROCModel::updateCodonSpecificParameter(std::string grouping)
 {
 	parameter->updateCodonSpecificParameter(grouping);
+	invalidateLogLikelihoodCache(grouping);
+}
+
+
+/* supportsFusedGenomeTraversal (NOT EXPOSED)
+ * Arguments: None
+ * The hyper parameters of ROC (stdDevSynthesisRate, noise offsets) only depend on phi, and the codon specific
+ * parameters do not depend on them, see Model::supportsFusedGenomeTraversal.
+*/
+bool ROCModel::supportsFusedGenomeTraversal()
+{
+	return true;
+}
+
+
+/* countSynthesisRateTraversal (NOT EXPOSED)
+ * Arguments: number of genes
+ * Adds the codon counts of all groupings read by calculateLogLikelihoodRatioPerGene to the default estimate.
+*/
+void ROCModel::countSynthesisRateTraversal(unsigned numGenes)
+{
+	unsigned numCodons = 0u;
+	for (unsigned a = 0u; a < getGroupListSize(); a++)
+	{
+		std::string grouping = getGrouping(a);
+		numCodons += SequenceSummary::GetNumCodonsForAA(grouping, false);
+	}
+	countGenomeTraversal(numGenes, getNumSynthesisRateCategories() * 2u * sizeof(double) + sizeof(unsigned)
+		+ numCodons * sizeof(unsigned));
+}
+
+
+/* prepareForCodonSpecificParameterUpdate (NOT EXPOSED)
+ * Arguments: reference to the genome
+ * Called by MCMCAlgorithm before the codon specific parameters are updated. Rebuilds the sufficient
+ * statistics if they are used, since phi values and mixture assignments have changed since the last call.
+*/
+void ROCModel::prepareForCodonSpecificParameterUpdate(Genome &genome)
+{
+	if (useSufficientStatistics)
+		updateSufficientStatistics(genome);
+}
+
+
+/* setSufficientStatisticsMode (RCPP EXPOSED)
+ * Arguments: whether to use sufficient statistics, number of phi bins per AA and mixture element (0 = no binning)
+ * With sufficient statistics, calculateLogLikelihoodRatioPerGroupingPerCategory does not visit every gene, but works
+ * on the codon counts and codon counts times phi summed per mixture element, and on the phi value and AA count of each
+ * gene containing the AA. This is exact up to floating point rounding. If numPhiBins is larger than 0, genes are in
+ * addition pooled into numPhiBins bins of equal width on the log(phi) scale, and the log denominator of the codon
+ * probabilities is evaluated at the AA count weighted mean phi of each bin. This is an approximation: the log
+ * denominator is convex in phi, so the binned likelihood is an upper bound and the error shrinks with the phi range
+ * within a bin.
+*/
+void ROCModel::setSufficientStatisticsMode(bool _useSufficientStatistics, unsigned _numPhiBins)
+{
+	useSufficientStatistics = _useSufficientStatistics;
+	numPhiBins = _numPhiBins;
+	sufficientStatisticCodonCount.clear();
+	sufficientStatisticCodonCountPhi.clear();
+	sufficientStatisticPhi.clear();
+	sufficientStatisticAACount.clear();
+}
+
+
+/* updateSufficientStatistics (NOT EXPOSED)
+ * Arguments: reference to the genome
+ * Collects, per AA and mixture element, the sums used by calculateLogLikelihoodPerAAFromSufficientStatistics from the
+ * current phi values and mixture assignments. One pass over the genome for all groupings.
+*/
+void ROCModel::updateSufficientStatistics(Genome &genome)
+{
+	unsigned numGenes = genome.getGenomeSize();
+	unsigned numMixtures = parameter->getNumMixtureElements();
+	unsigned numAA = (unsigned)SequenceSummary::AminoAcidArray.size();
+
+	sufficientStatisticCodonCount.assign(numAA, std::vector<double>(numMixtures * 6, 0.0));
+	sufficientStatisticCodonCountPhi.assign(numAA, std::vector<double>(numMixtures * 6, 0.0));
+	sufficientStatisticPhi.assign(numAA, std::vector<std::vector<double>>(numMixtures));
+	sufficientStatisticAACount.assign(numAA, std::vector<std::vector<double>>(numMixtures));
+
+	std::vector<unsigned> mixtureOfGene(numGenes);
+	std::vector<double> phiOfGene(numGenes);
+	for (unsigned i = 0u; i < numGenes; i++)
+	{
+		mixtureOfGene[i] = parameter->getMixtureAssignment(i);
+		unsigned expressionCategory = parameter->getSynthesisRateCategory(mixtureOfGene[i]);
+		phiOfGene[i] = parameter->getSynthesisRate(i, expressionCategory, false);
+	}
+
+	// make sure the codon count matrix is current before entering the parallel region
+	genome.getCodonCountsForCodonIndex(0);
+
+	// one pass for phi and mixture assignments, and one over the codon counts of each grouping
+	unsigned numGroupings = (unsigned)groupingAAIndex.size();
+	countGenomeTraversal(numGenes, sizeof(double) + sizeof(unsigned));
+	for (unsigned a = 0u; a < numGroupings; a++)
+	{
+		std::string grouping = getGrouping(a);
+		countGenomeTraversal(numGenes, SequenceSummary::GetNumCodonsForAA(grouping, false) * sizeof(unsigned));
+	}
+
+#ifdef _OPENMP
+//#ifndef __APPLE__
+#pragma omp parallel for
+#endif
+	for (unsigned a = 0u; a < numGroupings; a++)
+	{
+		unsigned aaIndex = groupingAAIndex[a];
+		unsigned aaStart, aaEnd;
+		SequenceSummary::AAIndexToCodonRange(aaIndex, aaStart, aaEnd, false);
+		unsigned numCodons = aaEnd - aaStart;
+		const unsigned *codonCountsPerGene[6];
+		for (unsigned j = 0u; j < numCodons; j++)
+			codonCountsPerGene[j] = genome.getCodonCountsForCodonIndex(aaStart + j);
+
+		std::vector<double> &codonCount = sufficientStatisticCodonCount[aaIndex];
+		std::vector<double> &codonCountPhi = sufficientStatisticCodonCountPhi[aaIndex];
+		for (unsigned i = 0u; i < numGenes; i++)
+		{
+			unsigned aaCount = 0u;
+			for (unsigned j = 0u; j < numCodons; j++)
+				aaCount += codonCountsPerGene[j][i];
+			if (aaCount == 0u) continue;
+
+			unsigned k = mixtureOfGene[i];
+			for (unsigned j = 0u; j < numCodons; j++)
+			{
+				codonCount[k * 6 + j] += codonCountsPerGene[j][i];
+				codonCountPhi[k * 6 + j] += codonCountsPerGene[j][i] * phiOfGene[i];
+			}
+			sufficientStatisticPhi[aaIndex][k].push_back(phiOfGene[i]);
+			sufficientStatisticAACount[aaIndex][k].push_back(aaCount);
+		}
+
+		if (numPhiBins == 0u) continue;
+		for (unsigned k = 0u; k < numMixtures; k++)
+		{
+			std::vector<double> &phiValues = sufficientStatisticPhi[aaIndex][k];
+			std::vector<double> &aaCounts = sufficientStatisticAACount[aaIndex][k];
+			if (phiValues.size() <= numPhiBins) continue;
+
+			double minLogPhi = std::log(*std::min_element(phiValues.begin(), phiValues.end()));
+			double maxLogPhi = std::log(*std::max_element(phiValues.begin(), phiValues.end()));
+			double binWidth = (maxLogPhi - minLogPhi) / numPhiBins;
+			std::vector<double> binAACount(numPhiBins, 0.0);
+			std::vector<double> binAACountPhi(numPhiBins, 0.0);
+			for (unsigned g = 0u; g < phiValues.size(); g++)
+			{
+				unsigned bin = binWidth > 0.0 ? (unsigned)((std::log(phiValues[g]) - minLogPhi) / binWidth) : 0u;
+				if (bin >= numPhiBins) bin = numPhiBins - 1;
+				binAACount[bin] += aaCounts[g];
+				binAACountPhi[bin] += aaCounts[g] * phiValues[g];
+			}
+			phiValues.clear();
+			aaCounts.clear();
+			for (unsigned b = 0u; b < numPhiBins; b++)
+			{
+				if (binAACount[b] == 0.0) continue;
+				phiValues.push_back(binAACountPhi[b] / binAACount[b]);
+				aaCounts.push_back(binAACount[b]);
+			}
+		}
+	}
 }
 
 
@@ -625,27 +1299,40 @@ void ROCModel::updateGibbsSampledHyperParameters(Genome &genome)
 	{
 		if(!fix_sEpsilon){
 			double shape = ((double)genome.getGenomeSize() - 1.0) / 2.0;
-			for (unsigned i = 0; i < parameter->getNumObservedPhiSets(); i++)
+			unsigned numObservedPhiSets = parameter->getNumObservedPhiSets();
+			std::vector <double> noiseOffset(numObservedPhiSets, 0.0);
+			std::vector <double> rate(numObservedPhiSets, 0.0); //Prior on s_epsilon goes here?
+			std::vector <unsigned> numMissing(numObservedPhiSets, 0u);
+			for (unsigned i = 0; i < numObservedPhiSets; i++)
+				noiseOffset[i] = getNoiseOffset(i);
+
+			// all observed phi sets in one pass over the genome
+			for (unsigned j = 0; j < genome.getGenomeSize(); j++)
 			{
-				double rate = 0.0; //Prior on s_epsilon goes here?
-				unsigned mixtureAssignment;
-				double noiseOffset = getNoiseOffset(i);
-				for (unsigned j = 0; j < genome.getGenomeSize(); j++)
+				unsigned mixtureAssignment = getMixtureAssignment(j);
+				double logPhi = std::log(getSynthesisRate(j, mixtureAssignment, false));
+				Gene &gene = genome.getGene(j);
+				for (unsigned i = 0; i < numObservedPhiSets; i++)
 				{
-					mixtureAssignment = getMixtureAssignment(j);
-					double obsPhi = genome.getGene(j).getObservedSynthesisRate(i);
+					double obsPhi = gene.getObservedSynthesisRate(i);
 					if (obsPhi > -1.0)
 					{
-						double sum = std::log(obsPhi) - noiseOffset - std::log(getSynthesisRate(j, mixtureAssignment, false));
-						rate += (sum * sum);
-					}else{
-						// missing observation.
-						shape -= 0.5;
-						//Reduce shape because initial estimate assumes there are no missing observations
+						double sum = std::log(obsPhi) - noiseOffset[i] - logPhi;
+						rate[i] += (sum * sum);
 					}
+					else
+						numMissing[i]++; // missing observation.
 				}
-				rate /= 2.0;
-				double rand = parameter->randGamma(shape, rate);
+			}
+			countGenomeTraversal(genome.getGenomeSize(), (numObservedPhiSets + 1u) * sizeof(double) + sizeof(unsigned));
+
+			for (unsigned i = 0; i < numObservedPhiSets; i++)
+			{
+				//Reduce shape because initial estimate assumes there are no missing observations
+				for (unsigned m = 0u; m < numMissing[i]; m++)
+					shape -= 0.5;
+				rate[i] /= 2.0;
+				double rand = parameter->randGamma(shape, rate[i]);
 
 				// Below the gamma sample is transformed into an inverse gamma sample
 				// According to Gilchrist et al (2015) Supporting Materials p. S6
@@ -773,6 +1460,11 @@ ROCParameter ROCModel::getParameter()
 void ROCModel::setParameter(ROCParameter &_parameter)
 {
 	parameter = &_parameter;
+
+	unsigned numGroupings = parameter->getGroupListSize();
+	groupingAAIndex.resize(numGroupings);
+	for (unsigned i = 0u; i < numGroupings; i++)
+		groupingAAIndex[i] = SequenceSummary::AAToAAIndex(parameter->getGrouping(i));
 }
 
 
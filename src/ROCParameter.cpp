@@ -1028,6 +1028,27 @@ void ROCParameter::getParameterForCategory(unsigned category, unsigned paramType
 }
 
 
+/* getParameterForCategory (NOT EXPOSED)
+ * Same as above, but takes the amino acid index (as in SequenceSummary::aaToIndex) instead of the amino acid.
+ * Used in the likelihood loops to avoid the string handling.
+*/
+void ROCParameter::getParameterForCategory(unsigned category, unsigned paramType, unsigned aaIndex, bool proposal,
+										   double *returnSet)
+{
+	const std::vector<double> &tempSet = (proposal ? proposedCodonSpecificParameter[paramType][category] :
+		currentCodonSpecificParameter[paramType][category]);
+
+	unsigned aaStart, aaEnd;
+	SequenceSummary::AAIndexToCodonRange(aaIndex, aaStart, aaEnd, true);
+
+	unsigned j = 0u;
+	for (unsigned i = aaStart; i < aaEnd; i++, j++)
+	{
+		returnSet[j] = tempSet[i];
+	}
+}
+
+
 
 
 
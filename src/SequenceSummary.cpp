@@ -75,6 +75,7 @@ SequenceSummary::SequenceSummary(const SequenceSummary& other)
 	ncodons = other.ncodons;
 	naa = other.naa;
 	RFPCount = other.RFPCount;
+	RFPCountColumnOffset = other.RFPCountColumnOffset;
 	sumRFPCount = other.sumRFPCount;
 	positionCodonID = other.positionCodonID;
 }
@@ -88,6 +89,7 @@ SequenceSummary& SequenceSummary::operator=(const SequenceSummary& rhs)
     ncodons = rhs.ncodons;
     naa = rhs.naa;
 	RFPCount = rhs.RFPCount;
+	RFPCountColumnOffset = rhs.RFPCountColumnOffset;
 	sumRFPCount = rhs.sumRFPCount;
 	positionCodonID = rhs.positionCodonID;
 
@@ -103,6 +105,7 @@ bool SequenceSummary::operator==(const SequenceSummary& other) const
 	if (this->ncodons != other.ncodons) { match = false; }
 	if (this->naa != other.naa) { match = false; }
 	if (this->RFPCount != other.RFPCount) {match = false; }
+	if (this->RFPCountColumnOffset != other.RFPCountColumnOffset) {match = false; }
 	if (this->sumRFPCount != other.sumRFPCount) {match = false; }
 	if (this->positionCodonID != other.positionCodonID) { match = false; }
 
@@ -171,27 +174,66 @@ std::vector <unsigned> *SequenceSummary::getCodonPositions(unsigned index)
 
 /* initRFPCount (NOT EXPOSED)
  * Arguments: A number representing the number of RFP categories.
- * Initializes the vector of vectors that describes, for each category, the RFPCount vector.
+ * Sets the number of RFP categories (columns) of the RFPCount store. Added categories are empty, categories beyond
+ * the number given are removed.
  * Note: When programming in C, this function should be called before manipulating RFPCount.
  * Reminder: It must be called after setting the sequence, since that function
  * resets the sequence summary, including the RFPCount.
  */
 void SequenceSummary::initRFPCount(unsigned numCategories)
 {
-	RFPCount.resize(numCategories);
+	if (numCategories + 1 < RFPCountColumnOffset.size())
+		RFPCount.resize(RFPCountColumnOffset[numCategories]);
+	RFPCountColumnOffset.resize(numCategories + 1, RFPCountColumnOffset.back());
+}
+
+
+/* getNumRFPCountColumns (NOT EXPOSED)
+ * Arguments: None
+ * Returns the number of RFP categories (columns) stored.
+ */
+unsigned SequenceSummary::getNumRFPCountColumns() const
+{
+	return (unsigned)RFPCountColumnOffset.size() - 1;
 }
 
 
 /* getRFPCount (NOT EXPOSED)
  * Arguments: A number representing the RFP category to return (default 0)
- * Returns the RFPCount vector for the category index specified.
- * Note: If initRFPCount is not called beforehand, it is called now to return a vector of 0s.
+ * Returns a copy of the RFPCount vector for the category index specified.
+ * Note: If initRFPCount is not called beforehand, it is called now to return an empty vector.
  */
 std::vector <int> SequenceSummary::getRFPCount(unsigned RFPCountColumn)
 {
 	// Note: If the user forgets to initRFPCount manually, this statement is executed but returns an empty vector.
-	if (RFPCount.size() < RFPCountColumn + 1) initRFPCount(RFPCountColumn + 1);
-	return RFPCount[RFPCountColumn];
+	if (getNumRFPCountColumns() < RFPCountColumn + 1) initRFPCount(RFPCountColumn + 1);
+	return std::vector <int>(RFPCount.begin() + RFPCountColumnOffset[RFPCountColumn],
+		RFPCount.begin() + RFPCountColumnOffset[RFPCountColumn + 1]);
+}
+
+
+/* getRFPCountData (NOT EXPOSED)
+ * Arguments: A number representing the RFP category to return (default 0)
+ * Returns a read only pointer to the RFP counts of the category index specified, one per position, without copying
+ * them (see getRFPCountSize for their number). The object is never modified, so it is safe to call from parallel
+ * regions. The pointer is invalidated by any function changing the RFPCount.
+ * Note: If the category does not exist or is empty, NULL is returned.
+ */
+const int *SequenceSummary::getRFPCountData(unsigned RFPCountColumn) const
+{
+	if (getRFPCountSize(RFPCountColumn) == 0u) return NULL;
+	return &RFPCount[RFPCountColumnOffset[RFPCountColumn]];
+}
+
+
+/* getRFPCountSize (NOT EXPOSED)
+ * Arguments: A number representing the RFP category (default 0)
+ * Returns the number of RFP counts stored for the category index specified, 0 if the category does not exist.
+ */
+unsigned SequenceSummary::getRFPCountSize(unsigned RFPCountColumn) const
+{
+	if (getNumRFPCountColumns() < RFPCountColumn + 1) return 0u;
+	return RFPCountColumnOffset[RFPCountColumn + 1] - RFPCountColumnOffset[RFPCountColumn];
 }
 
 
@@ -202,20 +244,32 @@ std::vector <int> SequenceSummary::getRFPCount(unsigned RFPCountColumn)
  */
 int SequenceSummary::getSingleRFPCount(unsigned position, unsigned RFPCountColumn)
 {
-	if (RFPCount.size() < RFPCountColumn + 1) initRFPCount(RFPCountColumn + 1);
-	return RFPCount[RFPCountColumn][position];
+	if (getNumRFPCountColumns() < RFPCountColumn + 1) initRFPCount(RFPCountColumn + 1);
+	return RFPCount[RFPCountColumnOffset[RFPCountColumn] + position];
 }
 
 
 /* setRFPCount (NOT EXPOSED)
  * Arguments: A vector argument to set the RFP count to for the given RFP category (default 0)
- * Sets the RFPCount vector for the category index specified to the vector argument given.
+ * Sets the RFPCount vector for the category index specified to the vector argument given. If the length changes,
+ * the categories stored after it are moved.
  * Note: If initRFPCount is not called beforehand, it is called now.
  */
 void SequenceSummary::setRFPCount(std::vector <int> arg, unsigned RFPCountColumn)
 {
-	if (RFPCount.size() < RFPCountColumn + 1) initRFPCount(RFPCountColumn + 1);
-	RFPCount[RFPCountColumn] = arg;
+	if (getNumRFPCountColumns() < RFPCountColumn + 1) initRFPCount(RFPCountColumn + 1);
+
+	unsigned begin = RFPCountColumnOffset[RFPCountColumn];
+	unsigned end = RFPCountColumnOffset[RFPCountColumn + 1];
+	unsigned size = (unsigned)arg.size();
+	if (size != end - begin)
+	{
+		RFPCount.erase(RFPCount.begin() + begin, RFPCount.begin() + end);
+		RFPCount.insert(RFPCount.begin() + begin, size, 0);
+		for (unsigned i = RFPCountColumn + 1; i < RFPCountColumnOffset.size(); i++)
+			RFPCountColumnOffset[i] = RFPCountColumnOffset[i] - (end - begin) + size;
+	}
+	std::copy(arg.begin(), arg.end(), RFPCount.begin() + begin);
 }
 
 
@@ -321,6 +375,17 @@ std::vector <unsigned> SequenceSummary::getPositionCodonID()
 }
 
 
+/* getPositionCodonIDReference (NOT EXPOSED)
+ * Arguments: None.
+ * Returns a read only reference to the vector of codon IDs for each position, avoiding the copy made by
+ * getPositionCodonID.
+ */
+const std::vector <unsigned> &SequenceSummary::getPositionCodonIDReference() const
+{
+	return positionCodonID;
+}
+
+
 /* setPositionCodonID (NOT EXPOSED)
  * Arguments: An vector to be set as the vector of codonIDs for each position.
  * Sets the positionCodonID vector specified to the vector argument given.
@@ -340,6 +405,7 @@ void SequenceSummary::clear()
 {
 	codonPositions.clear();
 	RFPCount.clear();
+	RFPCountColumnOffset.assign(1, 0u);
 	sumRFPCount.clear();
 	ncodons.fill(0);
 	naa.fill(0);
@@ -390,14 +456,16 @@ bool SequenceSummary::processPA(std::vector<std::vector<int>> table)
 
 	// There should be at least 1 table entry to get to this point, so this should be a valid operation
     unsigned numCats = (unsigned)table[0].size() - 2; // numCats = after position, codon.
-	initRFPCount(numCats);
 	sumRFPCount.resize(numCats);
 
+	// All categories are stored in one block, category j starts at j * nRows.
+	RFPCount.assign(numCats * nRows, 0);
+	RFPCountColumnOffset.resize(numCats + 1);
+	for (unsigned j = 0; j <= numCats; j++)
+		RFPCountColumnOffset[j] = j * nRows;
+
 	for (unsigned j = 0; j < numCats; j++)
-	{
-		RFPCount[j].resize(nRows);
 		sumRFPCount[j].fill(0);
-	}
 
 	for (unsigned i = 0; i < nRows; i++)
 	{
@@ -418,7 +486,7 @@ bool SequenceSummary::processPA(std::vector<std::vector<int>> table)
 			for (unsigned j = 0; j < numCats; j++)
 			{
 				// Category j has an RFPCount at the position equal to the 2-indexed (after position, codon) value of j.
-				RFPCount[j][row[0]] = row[j + 2];
+				RFPCount[RFPCountColumnOffset[j] + row[0]] = row[j + 2];
 				if (row[j+2] > 0) sumRFPCount[j][codonID] += row[j + 2];
                 // Recall: We store RFP counts < 0, but do not need to process this information in calculations
                 // So we only add to the sumRFPCount if the value is "valid" (> 0).
@@ -448,14 +516,16 @@ bool SequenceSummary::processPANSE(std::vector<std::vector<int>> table)
 
 	// There should be at least 1 table entry to get to this point, so this should be a valid operation
     unsigned numCats = (unsigned)table[0].size() - 2; // numCats = after position, codon.
-	initRFPCount(numCats);
 	sumRFPCount.resize(numCats);
 
+	// All categories are stored in one block, category j starts at j * nRows.
+	RFPCount.assign(numCats * nRows, 0);
+	RFPCountColumnOffset.resize(numCats + 1);
+	for (unsigned j = 0; j <= numCats; j++)
+		RFPCountColumnOffset[j] = j * nRows;
+
 	for (unsigned j = 0; j < numCats; j++)
-	{
-		RFPCount[j].resize(nRows);
 		sumRFPCount[j].fill(0);
-	}
 
 	for (unsigned i = 0; i < nRows; i++)
 	{
@@ -476,7 +546,7 @@ bool SequenceSummary::processPANSE(std::vector<std::vector<int>> table)
 			for (unsigned j = 0; j < numCats; j++)
 			{
 				// Category j has an RFPCount at the position equal to the 2-indexed (after position, codon) value of j.
-				RFPCount[j][row[0]] = row[j + 2];
+				RFPCount[RFPCountColumnOffset[j] + row[0]] = row[j + 2];
 				if (row[j+2] > 0) sumRFPCount[j][codonID] += row[j + 2];
                 // Recall: We store RFP counts < 0, but do not need to process this information in calculations
                 // So we only add to the sumRFPCount if the value is "valid" (> 0).
@@ -511,8 +581,16 @@ unsigned SequenceSummary::AAToAAIndex(std::string aa)
 // Note: From function definition in header, default forParamVector is false.
 void SequenceSummary::AAIndexToCodonRange(unsigned aaIndex, unsigned& startAAIndex, unsigned& endAAIndex, bool forParamVector)
 {
-	std::string aa = indexToAA(aaIndex);
-	AAToCodonRange(aa, startAAIndex, endAAIndex, forParamVector);
+	// First codon index of each amino acid in aaToIndex order; entry aaIndex + 1 closes the range.
+	// Same ranges as AAToCodonRange, without going through the amino acid string.
+	static const unsigned codonRangeStart[] = {0, 4, 6, 8, 10, 12, 16, 18, 21, 23, 29, 30, 32, 36, 38, 44, 48,
+		52, 56, 57, 59, 61, 64};
+	static const unsigned codonRangeStartParameter[] = {0, 3, 4, 5, 6, 7, 10, 11, 13, 14, 19, 19, 20, 23, 24, 29,
+		32, 35, 38, 38, 39, 40, 40};
+
+	const unsigned *rangeStart = forParamVector ? codonRangeStartParameter : codonRangeStart;
+	startAAIndex = rangeStart[aaIndex];
+	endAAIndex = rangeStart[aaIndex + 1];
 }
 
 //std::array<unsigned, 2>
@@ -1,5 +1,6 @@
 #include "include/Testing.h"
 #include <cstring>
+#include <cstdio>
 
 #ifndef STANDALONE
 #include <Rcpp.h>
@@ -288,6 +289,32 @@ int testSequenceSummary()
     else
         error = 0; //Reset for next function.
 
+    //-----------------------------------------//
+    //------ AAIndexToCodonRange Function------//
+    //-----------------------------------------//
+    for (unsigned aaIndex = 0; aaIndex < SequenceSummary::AminoAcidArray.size(); aaIndex++)
+    {
+        std::string aa = SequenceSummary::indexToAA(aaIndex);
+        for (unsigned forParamVector = 0; forParamVector < 2; forParamVector++)
+        {
+            unsigned start, end, expectedStart, expectedEnd;
+            SequenceSummary::AAIndexToCodonRange(aaIndex, start, end, forParamVector == 1);
+            SequenceSummary::AAToCodonRange(aa, expectedStart, expectedEnd, forParamVector == 1);
+            if (start != expectedStart || end != expectedEnd)
+            {
+                my_printError("Error in AAIndexToCodonRange for AA %, forParamVector %. Should return %-%, but returns %-%.\n",
+                              aa, forParamVector, expectedStart, expectedEnd, start, end);
+                error = 1;
+                globalError = 1;
+            }
+        }
+    }
+
+    if (!error)
+        my_print("Sequence Summary AAIndexToCodonRange --- Pass\n");
+    else
+        error = 0; //Reset for next function.
+
     //----------------------------------------------//
     //------ getAACountForAA(string) Function ------//
     //----------------------------------------------//
@@ -880,6 +907,42 @@ int testSequenceSummary()
         }
     }
 
+    if (SS.getRFPCountSize(0) != 5u || !std::equal(iVect.begin(), iVect.end(), SS.getRFPCountData(0)))
+    {
+        my_printError("Error in getRFPCountData or getRFPCountSize. Function should return 1, 2, 3, 4, 5.\n");
+        error = 1;
+        globalError = 1;
+    }
+
+    if (SS.getRFPCountData(1) != NULL || SS.getRFPCountSize(1) != 0u)
+    {
+        my_printError("Error in getRFPCountData or getRFPCountSize. Function should return no counts for a missing category.\n");
+        error = 1;
+        globalError = 1;
+    }
+
+    // Categories share one block: changing the length of one category must not change the others.
+    std::vector <int> iVect2 = {7, 8, 9};
+    std::vector <int> iVect3 = {-1, 0};
+    SS.setRFPCount(iVect2, 2);
+    SS.setRFPCount(iVect3, 0);
+    if (SS.getNumRFPCountColumns() != 3u || SS.getRFPCount(0) != iVect3 || SS.getRFPCount(1).size() != 0u
+        || SS.getRFPCount(2) != iVect2 || SS.getSingleRFPCount(1, 2) != 8)
+    {
+        my_printError("Error in setRFPCount or getNumRFPCountColumns with several categories.\n");
+        error = 1;
+        globalError = 1;
+    }
+
+    SS.initRFPCount(1);
+    SS.setRFPCount(iVect, 0);
+    if (SS.getNumRFPCountColumns() != 1u || SS.getRFPCount(0) != iVect)
+    {
+        my_printError("Error in initRFPCount. Function should remove the categories beyond the number given.\n");
+        error = 1;
+        globalError = 1;
+    }
+
     if (!error)
         my_print("Sequence Summary init/get/setRFPCount / getSingleRFPCount --- Pass\n");
     else
@@ -962,6 +1025,14 @@ int testSequenceSummary()
         globalError = 1;
     }
 
+    if (SS.getPositionCodonIDReference() != uVect
+        || &SS.getPositionCodonIDReference() != &SS.getPositionCodonIDReference())
+    {
+        my_printError("Error in getPositionCodonIDReference. Function should return a reference to 4, 7, 16, 32.\n");
+        error = 1;
+        globalError = 1;
+    }
+
     if (!error)
         my_print("Sequence Summary get/setPositionCodonID --- Pass\n");
     else
@@ -1802,6 +1873,22 @@ int testGenome(std::string testFileDir)
         globalError = 1;
     }
 
+    // a sequence changed through getGene is only seen after invalidateCodonCountMatrix
+    Gene &changedGene = genome1.getGene(0u, false);
+    changedGene.setSequence("GATGATTAG");
+    genome1.invalidateCodonCountMatrix();
+    std::string changedCodon = "GAT";
+    unsigned codonIndex = SequenceSummary::codonToIndex(changedCodon);
+    uVector.resize(genome1.getGenomeSize());
+    for (unsigned i = 0u; i < genome1.getGenomeSize(); i++)
+        uVector[i] = genome1.getGene(i, false).getSequenceSummary()->getCodonCountForCodon(codonIndex);
+    if (uVector != genome1.getCodonCountsPerGene("GAT") || uVector[0] == 0u)
+    {
+        my_printError("Error in testGenome: getCodonCountsPerGene returns stale counts after a gene was changed.\n");
+        error = 1;
+        globalError = 1;
+    }
+
     if (!error)
         my_print("Genome getCodonCountsPerGene --- Pass\n");
     else
@@ -2008,6 +2095,33 @@ int testGenome(std::string testFileDir)
         globalError = 1;
     }
 
+    //--------------------------------//
+    //------ getSumRFP Function ------//
+    //--------------------------------//
+
+    // genome2 was built with addGene, which has to count the RFP counts the same way readRFPData does, per column.
+    for (unsigned column = 0u; column < 2u; column++)
+    {
+        if (genome1.getSumRFP(column) != genome2.getSumRFP(column) || genome1.getSumRFP(column) == 0u)
+        {
+            my_printError("Error in testGenome: getSumRFP. Total RFP count of column % is % after readRFPData but % after addGene.\n",
+                          column, genome1.getSumRFP(column), genome2.getSumRFP(column));
+            error = 1;
+            globalError = 1;
+        }
+    }
+    if (genome1.getSumRFP(2) != 0u)
+    {
+        my_printError("Error in testGenome: getSumRFP. A missing column should have a total RFP count of 0.\n");
+        error = 1;
+        globalError = 1;
+    }
+
+    if (!error)
+        my_print("Genome getSumRFP --- Pass\n");
+    else
+        error = 0; //Reset for next function.
+
     //-----------------------------------//
     //------ writeRFPData Function ------//
     //-----------------------------------//
@@ -3617,6 +3731,115 @@ int testMCMCAlgorithm()
     else
         error = 0; //Reset for next function.
 
+    //--------------------------------------------------------------------//
+    //------ is/setSinglePassCodonSpecificParameterUpdate Functions ------//
+    //--------------------------------------------------------------------//
+
+    // NOTE: By default, both constructors initialize singlePassCodonSpecificParameterUpdate to false
+    if (mcmc.isSinglePassCodonSpecificParameterUpdate())
+    {
+        my_printError("Error in isSinglePassCodonSpecificParameterUpdate. Function should return false, but returns true.\n");
+        error = 1;
+        globalError = 1;
+    }
+
+    mcmc.setSinglePassCodonSpecificParameterUpdate(true);
+    if (!mcmc.isSinglePassCodonSpecificParameterUpdate())
+    {
+        my_printError("Error in isSinglePassCodonSpecificParameterUpdate or setSinglePassCodonSpecificParameterUpdate.");
+        my_printError(" Function should return true, but returns false.\n");
+        error = 1;
+        globalError = 1;
+    }
+    mcmc.setSinglePassCodonSpecificParameterUpdate(false);
+
+    if (!error)
+        my_print("MCMCAlgorithm is/setSinglePassCodonSpecificParameterUpdate --- Pass\n");
+    else
+        error = 0; //Reset for next function.
+
+    //--------------------------------------------------//
+    //------ is/setFusedGenomeTraversal Functions ------//
+    //--------------------------------------------------//
+
+    // NOTE: By default, both constructors initialize fusedGenomeTraversal to false
+    if (mcmc.isFusedGenomeTraversal())
+    {
+        my_printError("Error in isFusedGenomeTraversal. Function should return false, but returns true.\n");
+        error = 1;
+        globalError = 1;
+    }
+
+    mcmc.setFusedGenomeTraversal(true);
+    if (!mcmc.isFusedGenomeTraversal())
+    {
+        my_printError("Error in isFusedGenomeTraversal or setFusedGenomeTraversal.");
+        my_printError(" Function should return true, but returns false.\n");
+        error = 1;
+        globalError = 1;
+    }
+    mcmc.setFusedGenomeTraversal(false);
+
+    if (!error)
+        my_print("MCMCAlgorithm is/setFusedGenomeTraversal --- Pass\n");
+    else
+        error = 0; //Reset for next function.
+
+    //---------------------------------------//
+    //------ is/setProfiling Functions ------//
+    //---------------------------------------//
+
+    // NOTE: By default, both constructors initialize profiling to false
+    if (mcmc.isProfiling())
+    {
+        my_printError("Error in isProfiling. Function should return false, but returns true.\n");
+        error = 1;
+        globalError = 1;
+    }
+
+    mcmc.setProfiling(true);
+    if (!mcmc.isProfiling())
+    {
+        my_printError("Error in isProfiling or setProfiling. Function should return true, but returns false.\n");
+        error = 1;
+        globalError = 1;
+    }
+    mcmc.setProfiling(false);
+
+    if (!error)
+        my_print("MCMCAlgorithm is/setProfiling --- Pass\n");
+    else
+        error = 0; //Reset for next function.
+
+    //--------------------------------------//
+    //------ Profile Getter Functions ------//
+    //--------------------------------------//
+
+    // NOTE: By default, the profile holds one zero entry per phase.
+    std::vector <std::string> phaseNames = mcmc.getProfilePhaseNames();
+    std::vector <double> zeroProfile(MCMCAlgorithm::numProfilePhases, 0.0);
+    if (phaseNames.size() != MCMCAlgorithm::numProfilePhases
+        || phaseNames[MCMCAlgorithm::synthesisRateUpdatePhase] != "synthesis_rate_update")
+    {
+        my_printError("Error in getProfilePhaseNames. Function should return % phase names.\n",
+                      MCMCAlgorithm::numProfilePhases);
+        error = 1;
+        globalError = 1;
+    }
+    if (mcmc.getProfileTimes() != zeroProfile || mcmc.getProfileCalls() != zeroProfile
+        || mcmc.getProfileProposals() != zeroProfile || mcmc.getProfileAcceptances() != zeroProfile)
+    {
+        my_printError("Error in getProfileTimes, getProfileCalls, getProfileProposals or getProfileAcceptances.");
+        my_printError(" Functions should return a vector of % zeroes.\n", MCMCAlgorithm::numProfilePhases);
+        error = 1;
+        globalError = 1;
+    }
+
+    if (!error)
+        my_print("MCMCAlgorithm Profile Getter Functions --- Pass\n");
+    else
+        error = 0; //Reset for next function.
+
     //-------------------------------------------//
     //------ getLogPosteriorTrace Function ------//
     //-------------------------------------------//
@@ -3652,6 +3875,1209 @@ int testMCMCAlgorithm()
 //---------------------------------------- R SECTION --------------------------------------------------//
 //-----------------------------------------------------------------------------------------------------//
 
+/* testROCModel (RCPP EXPOSED)
+ * Arguments: string containing the directory of the unit testing files
+ * Performs Unit Testing on functions within ROCModel.cpp
+ * that are not exposed to RCPP already.
+ * Returns 0 if successful, 1 if error found.
+*/
+int testROCModel(std::string testFileDir)
+{
+    int error = 0;
+    int globalError = 0;
+
+    std::string dir = testFileDir + "/testMCMCROCFiles/";
+    Genome genome;
+    genome.readFasta(dir + "simulatedAllUniqueR.fasta");
+
+    unsigned numMixtures = 2;
+    std::vector<unsigned> geneAssignment(genome.getGenomeSize());
+    for (unsigned i = 0u; i < genome.getGenomeSize(); i++)
+        geneAssignment[i] = i % numMixtures;
+    std::vector<double> sphi_init(numMixtures, 1.0);
+    std::vector<std::vector<unsigned>> mixtureDefinitionMatrix;
+    ROCParameter parameter(sphi_init, numMixtures, geneAssignment, mixtureDefinitionMatrix, true, "allUnique");
+
+    std::vector<std::string> files = {dir + "mutation_1.csv", dir + "mutation_2.csv"};
+    parameter.initMutationCategories(files, numMixtures);
+    files = {dir + "selection_1.csv", dir + "selection_2.csv"};
+    parameter.initSelectionCategories(files, numMixtures);
+    parameter.setMutationPriorStandardDeviation(std::vector<std::vector<double>>(numMixtures, std::vector<double>(40, 0.35)));
+    parameter.InitializeSynthesisRate(genome, sphi_init[0]);
+    parameter.proposeCodonSpecificParameter();
+
+    ROCModel model(false);
+    model.setParameter(parameter);
+
+    unsigned numGroupings = model.getGroupListSize();
+    std::vector<std::vector<double>> perGene(numGroupings, std::vector<double>(5, 0.0));
+    for (unsigned i = 0u; i < numGroupings; i++)
+        model.calculateLogLikelihoodRatioPerGroupingPerCategory(model.getGrouping(i), genome, perGene[i]);
+
+    //-----------------------------------------------------------------//
+    //------ calculateLogLikelihoodRatioForAllGroupings Function ------//
+    //-----------------------------------------------------------------//
+    std::vector<std::vector<double>> allGroupings;
+    model.calculateLogLikelihoodRatioForAllGroupings(genome, allGroupings);
+    for (unsigned i = 0u; i < numGroupings; i++)
+    {
+        for (unsigned j = 0u; j < 5u; j++)
+        {
+            if (std::fabs(allGroupings[i][j] - perGene[i][j]) > 1e-9 * std::max(1.0, std::fabs(perGene[i][j])))
+            {
+                my_printError("Error in calculateLogLikelihoodRatioForAllGroupings for %: ", model.getGrouping(i));
+                my_printError("element % should be %, but is %.\n", j, perGene[i][j], allGroupings[i][j]);
+                error = 1;
+                globalError = 1;
+            }
+        }
+    }
+
+    if (!error)
+        my_print("ROCModel calculateLogLikelihoodRatioForAllGroupings --- Pass\n");
+    else
+        error = 0; //Reset for next function.
+
+    //-----------------------------------------------------------------------------------//
+    //------ calculateLogLikelihoodRatioForAllGroupingsAndHyperParameters Function ------//
+    //-----------------------------------------------------------------------------------//
+    model.proposeHyperParameters();
+    std::vector<double> hyperParameters;
+    model.calculateLogLikelihoodRatioForHyperParameters(genome, 0u, hyperParameters);
+    std::vector<std::vector<double>> fusedGroupings;
+    std::vector<double> fusedHyperParameters;
+    model.calculateLogLikelihoodRatioForAllGroupingsAndHyperParameters(genome, 0u, fusedGroupings, fusedHyperParameters);
+    if (fusedGroupings != allGroupings || fusedHyperParameters != hyperParameters)
+    {
+        my_printError("Error in calculateLogLikelihoodRatioForAllGroupingsAndHyperParameters. ");
+        my_printError("Ratios should be identical to the ones calculated separately.\n");
+        error = 1;
+        globalError = 1;
+    }
+
+    if (!error)
+        my_print("ROCModel calculateLogLikelihoodRatioForAllGroupingsAndHyperParameters --- Pass\n");
+    else
+        error = 0; //Reset for next function.
+
+    //---------------------------------------------//
+    //------ Sufficient Statistics Functions ------//
+    //---------------------------------------------//
+    model.setSufficientStatisticsMode(true, 0u);
+    model.prepareForCodonSpecificParameterUpdate(genome);
+    for (unsigned i = 0u; i < numGroupings; i++)
+    {
+        std::string grouping = model.getGrouping(i);
+        std::vector<double> sufficientStatistics(5, 0.0);
+        model.calculateLogLikelihoodRatioPerGroupingPerCategory(grouping, genome, sufficientStatistics);
+        // [1] and [2] are the current and proposed log likelihood
+        for (unsigned j = 1u; j < 3u; j++)
+        {
+            if (std::fabs(sufficientStatistics[j] - perGene[i][j]) > 1e-9 * std::fabs(perGene[i][j]))
+            {
+                my_printError("Error in calculateLogLikelihoodRatioPerGroupingPerCategory with sufficient statistics for %: ", grouping);
+                my_printError("log likelihood should be %, but is %.\n", perGene[i][j], sufficientStatistics[j]);
+                error = 1;
+                globalError = 1;
+            }
+        }
+    }
+
+    if (!error)
+        my_print("ROCModel sufficient statistics --- Pass\n");
+    else
+        error = 0; //Reset for next function.
+
+    // Binned phi is an approximation, but an upper bound of the exact log likelihood that should be close.
+    model.setSufficientStatisticsMode(true, 100u);
+    model.prepareForCodonSpecificParameterUpdate(genome);
+    for (unsigned i = 0u; i < numGroupings; i++)
+    {
+        std::string grouping = model.getGrouping(i);
+        std::vector<double> binned(5, 0.0);
+        model.calculateLogLikelihoodRatioPerGroupingPerCategory(grouping, genome, binned);
+        for (unsigned j = 1u; j < 3u; j++)
+        {
+            double tolerance = 1e-9 * std::fabs(perGene[i][j]);
+            if (binned[j] < perGene[i][j] - tolerance || binned[j] - perGene[i][j] > 1e-3 * std::fabs(perGene[i][j]))
+            {
+                my_printError("Error in calculateLogLikelihoodRatioPerGroupingPerCategory with binned phi for %: ", grouping);
+                my_printError("log likelihood is %, exact log likelihood is %.\n", binned[j], perGene[i][j]);
+                error = 1;
+                globalError = 1;
+            }
+        }
+    }
+
+    if (!error)
+        my_print("ROCModel sufficient statistics with binned phi --- Pass\n");
+    else
+        error = 0; //Reset for next function.
+
+    //--------------------------------------------//
+    //------ Log Likelihood Cache Functions ------//
+    //--------------------------------------------//
+    // A second model without cache on the same parameter serves as reference. Between the rounds phi proposals
+    // of every other gene and the proposal for one grouping are accepted, which must invalidate the right terms.
+    model.setSufficientStatisticsMode(false);
+    model.setLogLikelihoodCacheMode(true);
+    model.initTraces(1u, genome.getGenomeSize());
+    ROCModel referenceModel(false);
+    referenceModel.setParameter(parameter);
+    referenceModel.setLogLikelihoodCacheMode(false);
+    for (unsigned round = 0u; round < 3u; round++)
+    {
+        for (unsigned i = 0u; i < genome.getGenomeSize(); i++)
+        {
+            unsigned k = model.getMixtureAssignment(i);
+            double cached[7];
+            double reference[7];
+            model.calculateLogLikelihoodRatioPerGene(genome.getGene(i), i, k, cached);
+            referenceModel.calculateLogLikelihoodRatioPerGene(genome.getGene(i), i, k, reference);
+            if (cached[5] != reference[5] || cached[6] != reference[6])
+            {
+                my_printError("Error in calculateLogLikelihoodRatioPerGene with log likelihood cache for gene % in round %: ", i, round);
+                my_printError("log likelihoods should be % and %, but are % and %.\n", reference[5], reference[6], cached[5], cached[6]);
+                error = 1;
+                globalError = 1;
+            }
+            if (round > 0u && i % 2u == 0u)
+                model.updateSynthesisRate(i, k);
+        }
+        parameter.proposeSynthesisRateLevels();
+        model.updateCodonSpecificParameter(model.getGrouping(round));
+    }
+
+    if (!error)
+        my_print("ROCModel log likelihood cache --- Pass\n");
+    // No need to reset error
+
+    return globalError;
+}
+
+
+int testLogRisingFactorialTable()
+{
+    LogRisingFactorialTable table;
+    int error = 0;
+    int globalError = 0;
+    std::vector <double> alphas = {0.001, 0.37, 1.0, 2.5, 17.3, 1000.0};
+
+    //------------------------------------------//
+    //------ init & getMaxCount Functions ------//
+    //------------------------------------------//
+
+    if (table.getMaxCount() != 0u)
+    {
+        my_printError("Error in getMaxCount: an empty table should return 0 but returns %.\n", table.getMaxCount());
+        error = 1;
+        globalError = 1;
+    }
+
+    table.init(2u, 61u, 50u);
+    if (table.getMaxCount() != 50u)
+    {
+        my_printError("Error in init or getMaxCount: should return 50 but returns %.\n", table.getMaxCount());
+        error = 1;
+        globalError = 1;
+    }
+
+    if (!error)
+        my_print("LogRisingFactorialTable init & getMaxCount --- Pass\n");
+    else
+        error = 0; //Reset for next function.
+
+    //--------------------------------//
+    //------ calculate Function ------//
+    //--------------------------------//
+
+    // compare to the rising factorial summed as logs, alpha (alpha + 1) ... (alpha + n - 1)
+    for (unsigned i = 0u; i < alphas.size(); i++)
+    {
+        double logProduct = 0.0;
+        for (unsigned count = 0u; count <= 200u; count++)
+        {
+            double value = LogRisingFactorialTable::calculate(alphas[i], count);
+            if (std::fabs(value - logProduct) > 1e-10 * std::max(1.0, std::fabs(logProduct)))
+            {
+                my_printError("Error in calculate: for alpha % and count % should return % but returns %.\n",
+                              alphas[i], count, logProduct, value);
+                error = 1;
+                globalError = 1;
+            }
+            logProduct += std::log(alphas[i] + count);
+        }
+    }
+
+    if (!error)
+        my_print("LogRisingFactorialTable calculate --- Pass\n");
+    else
+        error = 0; //Reset for next function.
+
+    //------------------------------------//
+    //------ update & get Functions ------//
+    //------------------------------------//
+
+    // Tabulated values have to be identical to the untabulated likelihood term, lgamma(alpha + n) - lgamma(alpha),
+    // for both rows of a codon, after rows were replaced, and for counts beyond the table.
+    for (unsigned i = 0u; i < alphas.size(); i++)
+    {
+        unsigned category = i % 2u;
+        unsigned codon = 7u;
+        table.update(category, codon, alphas[i]);
+        if (i > 0u)
+            table.update(category, codon, alphas[i - 1]);
+
+        for (unsigned count = 0u; count <= 60u; count++)
+        {
+            double expected = std::lgamma(alphas[i] + count) - std::lgamma(alphas[i]);
+            double value = table.get(category, codon, alphas[i], count);
+            if (value != expected)
+            {
+                my_printError("Error in update or get: for alpha % and count % should return % but returns %.\n",
+                              alphas[i], count, expected, value);
+                error = 1;
+                globalError = 1;
+            }
+        }
+    }
+
+    // alpha values without a row and pairs outside of the table are calculated directly
+    if (table.get(0u, 3u, 4.2, 10u) != std::lgamma(4.2 + 10u) - std::lgamma(4.2)
+        || table.get(5u, 70u, 4.2, 10u) != std::lgamma(4.2 + 10u) - std::lgamma(4.2))
+    {
+        my_printError("Error in get: values without a row are not calculated directly.\n");
+        error = 1;
+        globalError = 1;
+    }
+
+    if (!error)
+        my_print("LogRisingFactorialTable update & get --- Pass\n");
+    else
+        error = 0; //Reset for next function.
+
+    //----------------------------//
+    //------ clear Function ------//
+    //----------------------------//
+
+    table.clear();
+    if (table.getMaxCount() != 0u || table.get(0u, 7u, 2.5, 3u) != std::lgamma(2.5 + 3u) - std::lgamma(2.5))
+    {
+        my_printError("Error in clear: the table should be empty.\n");
+        error = 1;
+        globalError = 1;
+    }
+
+    if (!error)
+        my_print("LogRisingFactorialTable clear --- Pass\n");
+    // No need to reset error
+
+    return globalError;
+}
+
+
+
+int testPANSEModel()
+{
+    PANSEModel model;
+    int error = 0;
+    int globalError = 0;
+    std::vector <double> xs = {1e-6, 0.01, 0.3, 0.99, 1.0, 2.5, 10.0, 50.0, 700.0};
+    const double pi = 3.14159265358979323846;
+
+    //------------------------------------------------------//
+    //------ Constructor & getRFPCountColumn Function ------//
+    //------------------------------------------------------//
+
+    // RFP count columns are numbered from 1, so the default model and a model given column 0 read the first column
+    Genome rfpGenome;
+    rfpGenome.addRFPCountColumnName("test");
+    Gene rfpGene;
+    rfpGene.setId("rfpGene");
+    std::vector <std::vector <int>> table = {{0, 0, 3}, {1, 5, 0}, {2, 12, 4}};
+    rfpGene.setPANSESequence(table);
+    rfpGenome.addGene(rfpGene, false);
+
+    PANSEModel zeroColumnModel(0u);
+    if (model.getRFPCountColumn() != 0u || rfpGenome.getSumRFP(model.getRFPCountColumn()) != 7u)
+    {
+        my_printError("Error in PANSEModel constructor: the default model should read RFP count column 1 (sum 7), "
+                      "but reads index % (sum %).\n", model.getRFPCountColumn(),
+                      rfpGenome.getSumRFP(model.getRFPCountColumn()));
+        error = 1;
+        globalError = 1;
+    }
+    if (zeroColumnModel.getRFPCountColumn() != 0u)
+    {
+        my_printError("Error in PANSEModel constructor: column 0 should be treated as column 1, but reads index %.\n",
+                      zeroColumnModel.getRFPCountColumn());
+        error = 1;
+        globalError = 1;
+    }
+
+    if (!error)
+        my_print("PANSEModel Constructor & getRFPCountColumn --- Pass\n");
+    else
+        error = 0; //Reset for next function.
+
+    //-------------------------------------------------//
+    //------ UpperIncompleteGamma(Log) Functions ------//
+    //-------------------------------------------------//
+
+    // compare to closed forms for s = 2, 1, 0.5, 0 and -0.5, including the exponential integral E1(1)
+    for (unsigned i = 0u; i < xs.size(); i++)
+    {
+        double x = xs[i];
+        std::vector <double> s = {2.0, 1.0, 0.5, -0.5};
+        std::vector <double> logExpected = {std::log(x + 1.0) - x, -x,
+            0.5 * std::log(pi) + std::log(std::erfc(std::sqrt(x))),
+            std::log(2.0 * (std::exp(-x) / std::sqrt(x) - std::sqrt(pi) * std::erfc(std::sqrt(x))))};
+        for (unsigned j = 0u; j < s.size(); j++)
+        {
+            if (!std::isfinite(logExpected[j]) || (x > 10.0 && s[j] <= 0.5))
+                continue; // closed forms that under- or overflow or cancel
+            double value = model.UpperIncompleteGammaLog(s[j], x);
+            if (std::fabs(value - logExpected[j]) > 1e-9 * std::max(1.0, std::fabs(logExpected[j])))
+            {
+                my_printError("Error in UpperIncompleteGammaLog: for s % and x % should return % but returns %.\n",
+                              s[j], x, logExpected[j], value);
+                error = 1;
+                globalError = 1;
+            }
+        }
+    }
+
+    if (std::fabs(model.UpperIncompleteGamma(0.0, 1.0) - 0.219383934395520) > 1e-12
+        || std::fabs(model.UpperIncompleteGamma(-1.0, 1.0) - (std::exp(-1.0) - 0.219383934395520)) > 1e-12)
+    {
+        my_printError("Error in UpperIncompleteGamma: Gamma(0, 1) or Gamma(-1, 1) is wrong.\n");
+        error = 1;
+        globalError = 1;
+    }
+
+    // for s next to 0, Gamma(s, x) = E1(x) + s * int_x^inf log(t) exp(-t) / t dt up to O(s^2)
+    std::vector <double> smallXs = {0.3, 0.99};
+    std::vector <double> exponentialIntegral = {0.9056766516758468, 0.2230998257901773};
+    std::vector <double> logIntegral = {-0.36076045778267396, 0.09782449311698921};
+    std::vector <double> smallS = {1e-9, -1e-9, 1e-12, -1e-12, 0.0};
+    for (unsigned i = 0u; i < smallXs.size(); i++)
+    {
+        for (unsigned j = 0u; j < smallS.size(); j++)
+        {
+            double expected = exponentialIntegral[i] + smallS[j] * logIntegral[i];
+            double value = model.UpperIncompleteGamma(smallS[j], smallXs[i]);
+            if (std::fabs(value - expected) > 1e-13 * expected)
+            {
+                my_printError("Error in UpperIncompleteGamma: for s % and x % should return % but returns %.\n",
+                              smallS[j], smallXs[i], expected, value);
+                error = 1;
+                globalError = 1;
+            }
+        }
+    }
+
+    // the branches agree where they meet next to s = +-0.01 and s = -1
+    std::vector <double> edges = {0.01, -0.01, -0.99, -1.01};
+    for (unsigned i = 0u; i < edges.size(); i++)
+    {
+        double below = model.UpperIncompleteGammaLog(edges[i] - 1e-12, 0.5);
+        double above = model.UpperIncompleteGammaLog(edges[i] + 1e-12, 0.5);
+        if (std::fabs(below - above) > 1e-11)
+        {
+            my_printError("Error in UpperIncompleteGammaLog: jumps from % to % at s % and x 0.5.\n",
+                          below, above, edges[i]);
+            error = 1;
+            globalError = 1;
+        }
+    }
+
+    // Gamma(s, x) approaches Gamma(s) for x much smaller than s
+    if (std::fabs(model.UpperIncompleteGammaLog(25.0, 0.05) - std::lgamma(25.0)) > 1e-10)
+    {
+        my_printError("Error in UpperIncompleteGammaLog: for s 25 and x 0.05 should return % but returns %.\n",
+                      std::lgamma(25.0), model.UpperIncompleteGammaLog(25.0, 0.05));
+        error = 1;
+        globalError = 1;
+    }
+
+    if (!error)
+        my_print("PANSEModel UpperIncompleteGamma(Log) --- Pass\n");
+    else
+        error = 0; //Reset for next function.
+
+    //------------------------------------------------------------//
+    //------ supportsSinglePassCodonSpecificUpdate Function ------//
+    //------------------------------------------------------------//
+
+    // the sigma prefix sums of a codon include the codons accepted before it in the same sweep
+    if (model.supportsSinglePassCodonSpecificUpdate())
+    {
+        my_printError("Error in supportsSinglePassCodonSpecificUpdate. Function should return false, but returns true.\n");
+        error = 1;
+        globalError = 1;
+    }
+
+    if (!error)
+        my_print("PANSEModel supportsSinglePassCodonSpecificUpdate --- Pass\n");
+    // No need to reset error
+
+    return globalError;
+}
+
+
+/* testFONSEModel (RCPP EXPOSED)
+ * Arguments: string of the directory with the test files
+ * Performs Unit Testing on the position bucket mode of FONSEModel.
+ * Returns 0 if successful, 1 if error found.
+*/
+int testFONSEModel(std::string testFileDir)
+{
+    int error = 0;
+    int globalError = 0;
+
+    // genes of 400 codons, long enough for buckets to pool several occurrences of a codon
+    Genome genome;
+    unsigned numGenes = 10u;
+    for (unsigned i = 0u; i < numGenes; i++)
+    {
+        Gene gene;
+        std::string seq = "ATG";
+        for (unsigned j = 1u; j < 400u; j++)
+            seq += SequenceSummary::codonArray[(i * 7u + j * 13u + j / 17u) % 61u]; //sense codons only
+        std::ostringstream oss;
+        oss << "FONSE_gene_" << i;
+        gene.setId(oss.str());
+        gene.setSequence(seq);
+        genome.addGene(gene, false);
+    }
+
+    std::string dir = testFileDir + "/testMCMCROCFiles/";
+    std::vector<double> sphi_init(1, 1.0);
+    std::vector<unsigned> geneAssignment(numGenes, 0u);
+    std::vector<std::vector<unsigned>> mixtureDefinitionMatrix;
+    FONSEParameter parameter(sphi_init, 1u, geneAssignment, mixtureDefinitionMatrix, true, "allUnique");
+    parameter.initMutationCategories({dir + "mutation_1.csv"}, 1u);
+    parameter.initSelectionCategories({dir + "selection_1.csv"}, 1u);
+    // small phi values keep phi * position * selection in a range where the codon probabilities do not overflow
+    std::vector<double> phiValues(numGenes);
+    for (unsigned i = 0u; i < numGenes; i++)
+        phiValues[i] = 0.01 * (i + 1u);
+    parameter.InitializeSynthesisRate(phiValues);
+
+    FONSEModel model;
+    model.setParameter(parameter);
+    model.proposeSynthesisRateLevels();
+
+    // [3] is the current log likelihood (plus the phi prior, which does not depend on the mode)
+    std::vector<double> exact(numGenes);
+    for (unsigned i = 0u; i < numGenes; i++)
+    {
+        double logProbabilityRatio[5];
+        model.calculateLogLikelihoodRatioPerGene(genome.getGene(i), i, 0u, logProbabilityRatio);
+        exact[i] = logProbabilityRatio[3];
+    }
+
+    //-------------------------------------------//
+    //------ setPositionBucketMode Function ------//
+    //-------------------------------------------//
+
+    // a bucket width of 1 is exact up to rounding, 0 switches back to the exact likelihood
+    std::vector<unsigned> bucketWidths = {1u, 0u};
+    for (unsigned w = 0u; w < bucketWidths.size(); w++)
+    {
+        model.setPositionBucketMode(genome, bucketWidths[w]);
+        for (unsigned i = 0u; i < numGenes; i++)
+        {
+            double logProbabilityRatio[5];
+            model.calculateLogLikelihoodRatioPerGene(genome.getGene(i), i, 0u, logProbabilityRatio);
+            double tolerance = bucketWidths[w] == 0u ? 0.0 : 1e-9 * std::fabs(exact[i]);
+            if (std::fabs(logProbabilityRatio[3] - exact[i]) > tolerance)
+            {
+                my_printError("Error in setPositionBucketMode: with bucket width % the log likelihood of gene % ",
+                              bucketWidths[w], i);
+                my_printError("should be %, but is %.\n", exact[i], logProbabilityRatio[3]);
+                error = 1;
+                globalError = 1;
+            }
+        }
+    }
+
+    if (!error)
+        my_print("FONSEModel setPositionBucketMode --- Pass\n");
+    else
+        error = 0; //Reset for next function.
+
+    //-------------------------------------------------------//
+    //------ calculatePositionBucketErrorBound Function ------//
+    //-------------------------------------------------------//
+
+    // with wider buckets the log likelihood can only be overestimated, and by no more than the bound
+    model.setPositionBucketMode(genome, 25u);
+    double errorBound = model.calculatePositionBucketErrorBound(genome);
+    double totalError = 0.0;
+    for (unsigned i = 0u; i < numGenes; i++)
+    {
+        double logProbabilityRatio[5];
+        model.calculateLogLikelihoodRatioPerGene(genome.getGene(i), i, 0u, logProbabilityRatio);
+        double difference = logProbabilityRatio[3] - exact[i];
+        if (difference < -1e-9 * std::fabs(exact[i]))
+        {
+            my_printError("Error in setPositionBucketMode: the bucketed log likelihood % of gene % ",
+                          logProbabilityRatio[3], i);
+            my_printError("is smaller than the exact one %.\n", exact[i]);
+            error = 1;
+            globalError = 1;
+        }
+        totalError += difference;
+    }
+    if (!(errorBound > 0.0) || totalError > errorBound * (1.0 + 1e-9))
+    {
+        my_printError("Error in calculatePositionBucketErrorBound: the bound % ", errorBound);
+        my_printError("should be positive and at least the error of the log likelihood %.\n", totalError);
+        error = 1;
+        globalError = 1;
+    }
+
+    model.setPositionBucketMode(genome, 0u);
+    if (model.calculatePositionBucketErrorBound(genome) != 0.0)
+    {
+        my_printError("Error in calculatePositionBucketErrorBound: should return 0 without position buckets.\n");
+        error = 1;
+        globalError = 1;
+    }
+
+    if (!error)
+        my_print("FONSEModel calculatePositionBucketErrorBound --- Pass\n");
+    // No need to reset error
+
+    return globalError;
+}
+
+
+/* testTraceFile (RCPP EXPOSED)
+ * Arguments: string of the directory to write the trace files to
+ * Performs Unit Testing on TraceFile and on the trace file mode of Trace.
+ * Returns 0 if successful, 1 if error found.
+*/
+int testTraceFile(std::string outputDir)
+{
+    int error = 0;
+    int globalError = 0;
+    std::string filename = outputDir + "/traceFile.bin";
+
+    //---------------------------------//
+    //------ TraceFile Functions ------//
+    //---------------------------------//
+
+    // 3 columns of 10 samples in chunks of 4 samples. Sample 5 of column 1 is never set and keeps its fill value,
+    // sample 1 of column 0 is patched after its chunk was written.
+    TraceFile traceFile;
+    std::vector<float> fillValues = {1.0, 2.0, 3.0};
+    std::vector<unsigned> metadata = {7u, 8u};
+    if (!traceFile.init(filename, 10u, 4u, fillValues, metadata))
+    {
+        my_printError("Error in TraceFile::init: could not create %.\n", filename);
+        error = 1;
+        globalError = 1;
+    }
+    else
+    {
+        std::vector<std::vector<float>> expected(3, std::vector<float>(10));
+        for (unsigned sample = 0u; sample < 10u; sample++)
+        {
+            for (unsigned column = 0u; column < 3u; column++)
+            {
+                expected[column][sample] = (float)(column * 100u + sample);
+                if (column == 1u && sample == 5u)
+                    expected[column][sample] = fillValues[column];
+                else
+                    traceFile.setValue(column, sample, expected[column][sample]);
+            }
+        }
+        traceFile.setValue(0u, 1u, -1.0);
+        expected[0][1] = -1.0;
+
+        for (unsigned flushed = 0u; flushed < 2u; flushed++)
+        {
+            for (unsigned column = 0u; column < 3u; column++)
+            {
+                if (traceFile.getColumn(column) != expected[column])
+                {
+                    my_printError("Error in TraceFile::getColumn: column % is not as expected", column);
+                    my_printError(flushed ? " after flush.\n" : " before flush.\n");
+                    error = 1;
+                    globalError = 1;
+                }
+            }
+            traceFile.flush();
+        }
+
+        // header of 4 characters, 6 + 2 unsigned values and 3 fill values, then 3 full chunks of 3 columns of 4 samples
+        std::ifstream in(filename.c_str(), std::ios::in | std::ios::binary | std::ios::ate);
+        std::streamoff expectedSize = 4 + 8 * (std::streamoff)sizeof(unsigned)
+            + (3 + 3 * 3 * 4) * (std::streamoff)sizeof(float);
+        if (!in || (std::streamoff)in.tellg() != expectedSize)
+        {
+            my_printError("Error in TraceFile::flush: the file should hold % bytes.\n", expectedSize);
+            error = 1;
+            globalError = 1;
+        }
+        if (traceFile.getMetadata() != metadata)
+        {
+            my_printError("Error in TraceFile::getMetadata: metadata is not as expected.\n");
+            error = 1;
+            globalError = 1;
+        }
+
+        // a finished file read back (memory mapped) by a read only TraceFile and a copy of it
+        TraceFile reader;
+        if (!reader.openForReading(filename) || reader.getNumSamplesWritten() != 10u || reader.getMetadata() != metadata)
+        {
+            my_printError("Error in TraceFile::openForReading: could not read the header of %.\n", filename);
+            error = 1;
+            globalError = 1;
+        }
+        else
+        {
+            TraceFile readerCopy(reader);
+            for (unsigned column = 0u; column < 3u; column++)
+            {
+                if (reader.getColumn(column) != expected[column] || readerCopy.getColumn(column) != expected[column])
+                {
+                    my_printError("Error in TraceFile::openForReading: column % is not as expected.\n", column);
+                    error = 1;
+                    globalError = 1;
+                }
+            }
+        }
+
+        // chunks that never receive a value hold the fill values
+        traceFile.init(filename, 10u, 4u, fillValues, metadata);
+        traceFile.setValue(2u, 9u, -3.0);
+        traceFile.flush();
+        std::vector<float> column = traceFile.getColumn(2u);
+        std::vector<float> expectedColumn(10, fillValues[2]);
+        expectedColumn[9] = -3.0;
+        if (column != expectedColumn)
+        {
+            my_printError("Error in TraceFile::flush: unwritten chunks should hold the fill value.\n");
+            error = 1;
+            globalError = 1;
+        }
+    }
+
+    if (!error)
+        my_print("TraceFile Functions --- Pass\n");
+    else
+        error = 0; //Reset for next function.
+
+    //-------------------------------------//
+    //------ TraceFile Write Failure ------//
+    //-------------------------------------//
+
+    // the file disappears while the window holds the first chunk, moving the window on and flushing have to fail
+    std::string removedFilename = outputDir + "/traceFileRemoved.bin";
+    TraceFile removedTraceFile;
+    if (!removedTraceFile.init(removedFilename, 10u, 4u, fillValues, metadata) || !removedTraceFile.setValue(0u, 0u, 1.5)
+        || removedTraceFile.hasWriteFailed())
+    {
+        my_printError("Error in TraceFile::setValue: could not set a value in the window of %.\n", removedFilename);
+        error = 1;
+        globalError = 1;
+    }
+    std::remove(removedFilename.c_str());
+    if (removedTraceFile.setValue(0u, 4u, 2.5) || !removedTraceFile.hasWriteFailed()
+        || removedTraceFile.setValue(0u, 5u, 3.5) || removedTraceFile.flush())
+    {
+        my_printError("Error in TraceFile::setValue: writing to the removed file % should fail.\n", removedFilename);
+        error = 1;
+        globalError = 1;
+    }
+
+    if (!error)
+        my_print("TraceFile Write Failure --- Pass\n");
+    else
+        error = 0; //Reset for next function.
+
+    //---------------------------------------//
+    //------ setTraceFileMode Function ------//
+    //---------------------------------------//
+
+    // two mixture elements with their own expression category, genes switch between them. The getters of a trace
+    // streamed to the file with a small window have to match the in memory trace.
+    unsigned numGenes = 5u;
+    unsigned samples = 11u;
+    std::vector<mixtureDefinition> categories(2);
+    categories[0].delM = 0u;
+    categories[0].delEta = 0u;
+    categories[1].delM = 0u;
+    categories[1].delEta = 1u;
+    std::vector<double> init_phi = {0.5, 1.0, 1.5, 2.0, 2.5};
+    std::vector<unsigned> init_mix_assign = {0u, 1u, 0u, 1u, 0u};
+
+    Trace memoryTrace(2u);
+    Trace fileTrace(2u);
+    fileTrace.setTraceFileMode(filename, 3u);
+    memoryTrace.initializeROCTrace(samples, numGenes, 1u, 2u, 1u, 2u, categories, 1u, 0u, init_phi, init_mix_assign);
+    fileTrace.initializeROCTrace(samples, numGenes, 1u, 2u, 1u, 2u, categories, 1u, 0u, init_phi, init_mix_assign);
+
+    if (fileTrace.getTraceFileName() != filename || memoryTrace.getTraceFileName() != "")
+    {
+        my_printError("Error in setTraceFileMode: getTraceFileName should return % and an empty string.\n", filename);
+        error = 1;
+        globalError = 1;
+    }
+
+    // samples 7 to 10 are left at their initial values
+    std::vector<std::vector<double>> synthesisRateLevel(2, std::vector<double>(numGenes));
+    for (unsigned sample = 0u; sample < 7u; sample++)
+    {
+        for (unsigned geneIndex = 0u; geneIndex < numGenes; geneIndex++)
+        {
+            synthesisRateLevel[0][geneIndex] = 0.1 * (sample + 1u) + geneIndex;
+            synthesisRateLevel[1][geneIndex] = 0.2 * (sample + 1u) + geneIndex;
+            unsigned mixtureElement = (sample + geneIndex) % 2u;
+            memoryTrace.updateSynthesisRateTrace(sample, geneIndex, synthesisRateLevel);
+            memoryTrace.updateMixtureAssignmentTrace(sample, geneIndex, mixtureElement);
+            fileTrace.updateSynthesisRateTrace(sample, geneIndex, synthesisRateLevel);
+            fileTrace.updateMixtureAssignmentTrace(sample, geneIndex, mixtureElement);
+        }
+    }
+
+    for (unsigned flushed = 0u; flushed < 2u; flushed++)
+    {
+        if (fileTrace.getSynthesisRateTrace() != memoryTrace.getSynthesisRateTrace()
+            || fileTrace.getMixtureAssignmentTrace() != memoryTrace.getMixtureAssignmentTrace()
+            || fileTrace.getExpectedSynthesisRateTrace() != memoryTrace.getExpectedSynthesisRateTrace())
+        {
+            my_printError("Error in setTraceFileMode: the traces of the trace file do not match the in memory traces.\n");
+            error = 1;
+            globalError = 1;
+        }
+        for (unsigned geneIndex = 0u; geneIndex < numGenes; geneIndex++)
+        {
+            if (fileTrace.getSynthesisRateTraceForGene(geneIndex) != memoryTrace.getSynthesisRateTraceForGene(geneIndex)
+                || fileTrace.getSynthesisRateTraceByMixtureElementForGene(1u, geneIndex)
+                   != memoryTrace.getSynthesisRateTraceByMixtureElementForGene(1u, geneIndex)
+                || fileTrace.getMixtureAssignmentTraceForGene(geneIndex)
+                   != memoryTrace.getMixtureAssignmentTraceForGene(geneIndex))
+            {
+                my_printError("Error in setTraceFileMode: the traces of gene % do not match the in memory traces.\n",
+                              geneIndex);
+                error = 1;
+                globalError = 1;
+            }
+        }
+        fileTrace.flushTraceFile();
+    }
+
+    if (!error)
+        my_print("Trace setTraceFileMode --- Pass\n");
+    else
+        error = 0; //Reset for next function.
+
+    //------------------------------------//
+    //------ loadTraceFile Function ------//
+    //------------------------------------//
+
+    // the finished file is read by a new trace, which only knows the mixture definitions
+    Trace readTrace(2u);
+    if (readTrace.loadTraceFile(filename, numGenes + 1u, categories))
+    {
+        my_printError("Error in loadTraceFile: a file of % genes should not load for % genes.\n", numGenes, numGenes + 1u);
+        error = 1;
+        globalError = 1;
+    }
+    if (!readTrace.loadTraceFile(filename, numGenes, categories) || readTrace.getTraceFileNumSamplesWritten() != 7u)
+    {
+        my_printError("Error in loadTraceFile: could not load % with 7 samples.\n", filename);
+        error = 1;
+        globalError = 1;
+    }
+    else
+    {
+        Trace readTraceCopy = readTrace;
+        for (unsigned geneIndex = 0u; geneIndex < numGenes; geneIndex++)
+        {
+            if (readTrace.getSynthesisRateTraceForGene(geneIndex) != memoryTrace.getSynthesisRateTraceForGene(geneIndex)
+                || readTraceCopy.getSynthesisRateTraceForGene(geneIndex)
+                   != memoryTrace.getSynthesisRateTraceForGene(geneIndex)
+                || readTrace.getMixtureAssignmentTraceForGene(geneIndex)
+                   != memoryTrace.getMixtureAssignmentTraceForGene(geneIndex))
+            {
+                my_printError("Error in loadTraceFile: the traces of gene % do not match the in memory traces.\n",
+                              geneIndex);
+                error = 1;
+                globalError = 1;
+            }
+        }
+    }
+
+    if (!error)
+        my_print("Trace loadTraceFile --- Pass\n");
+    // No need to reset error
+
+    return globalError;
+}
+
+
+/* testTrace (RCPP EXPOSED)
+ * Arguments: None
+ * Performs Unit Testing on the layouts of the synthesis rate and mixture assignment traces.
+ * Returns 0 if successful, 1 if error found.
+*/
+int testTrace()
+{
+    int error = 0;
+    int globalError = 0;
+
+    // two mixture elements with their own expression category, genes switch between them
+    unsigned numGenes = 4u;
+    unsigned samples = 6u;
+    std::vector<mixtureDefinition> categories(2);
+    categories[0].delM = 0u;
+    categories[0].delEta = 0u;
+    categories[1].delM = 0u;
+    categories[1].delEta = 1u;
+    std::vector<double> init_phi = {0.5, 1.0, 1.5, 2.0};
+    std::vector<unsigned> init_mix_assign = {0u, 1u, 0u, 1u};
+
+    // reference: gene major layout, stored gene by gene
+    Trace geneTrace(2u);
+    Trace sampleTrace(2u);
+    Trace switchedTrace(2u);
+    sampleTrace.setTraceLayout("sample");
+    geneTrace.initializeROCTrace(samples, numGenes, 1u, 2u, 1u, 2u, categories, 1u, 0u, init_phi, init_mix_assign);
+    sampleTrace.initializeROCTrace(samples, numGenes, 1u, 2u, 1u, 2u, categories, 1u, 0u, init_phi, init_mix_assign);
+    switchedTrace.initializeROCTrace(samples, numGenes, 1u, 2u, 1u, 2u, categories, 1u, 0u, init_phi, init_mix_assign);
+
+    // the last sample is left at its initial values
+    std::vector<std::vector<double>> synthesisRateLevel(2, std::vector<double>(numGenes));
+    std::vector<unsigned> mixtureAssignment(numGenes);
+    for (unsigned sample = 0u; sample < samples - 1u; sample++)
+    {
+        for (unsigned geneIndex = 0u; geneIndex < numGenes; geneIndex++)
+        {
+            synthesisRateLevel[0][geneIndex] = 0.1 * (sample + 1u) + geneIndex;
+            synthesisRateLevel[1][geneIndex] = 0.2 * (sample + 1u) + geneIndex;
+            mixtureAssignment[geneIndex] = (sample + geneIndex) % 2u;
+            geneTrace.updateSynthesisRateTrace(sample, geneIndex, synthesisRateLevel);
+            geneTrace.updateMixtureAssignmentTrace(sample, geneIndex, mixtureAssignment[geneIndex]);
+        }
+        sampleTrace.updateSynthesisRateTrace(sample, synthesisRateLevel);
+        sampleTrace.updateMixtureAssignmentTrace(sample, mixtureAssignment);
+        switchedTrace.updateSynthesisRateTrace(sample, synthesisRateLevel);
+        switchedTrace.updateMixtureAssignmentTrace(sample, mixtureAssignment);
+    }
+
+    //--------------------------------------------------//
+    //------ updateSynthesisRateTrace (all genes) ------//
+    //--------------------------------------------------//
+
+    if (sampleTrace.getSynthesisRateTrace() != geneTrace.getSynthesisRateTrace()
+        || switchedTrace.getSynthesisRateTrace() != geneTrace.getSynthesisRateTrace())
+    {
+        my_printError("Error in updateSynthesisRateTrace: storing all genes at once should match storing each gene.\n");
+        error = 1;
+        globalError = 1;
+    }
+    if (sampleTrace.getMixtureAssignmentTrace() != geneTrace.getMixtureAssignmentTrace()
+        || switchedTrace.getMixtureAssignmentTrace() != geneTrace.getMixtureAssignmentTrace())
+    {
+        my_printError("Error in updateMixtureAssignmentTrace: storing all genes at once should match storing each gene.\n");
+        error = 1;
+        globalError = 1;
+    }
+
+    if (!error)
+        my_print("Trace updateSynthesisRateTrace (all genes) --- Pass\n");
+    else
+        error = 0; //Reset for next function.
+
+    //-------------------------------------//
+    //------ setTraceLayout Function ------//
+    //-------------------------------------//
+
+    // switching the layout of a filled trace reorders it, the getters do not change
+    switchedTrace.setTraceLayout("sample");
+    if (geneTrace.getTraceLayout() != "gene" || sampleTrace.getTraceLayout() != "sample"
+        || switchedTrace.getTraceLayout() != "sample")
+    {
+        my_printError("Error in getTraceLayout: the layouts should be gene, sample and sample.\n");
+        error = 1;
+        globalError = 1;
+    }
+    for (unsigned geneIndex = 0u; geneIndex < numGenes; geneIndex++)
+    {
+        std::vector<float> expected = geneTrace.getSynthesisRateTraceForGene(geneIndex);
+        std::vector<unsigned> expectedMixture = geneTrace.getMixtureAssignmentTraceForGene(geneIndex);
+        if (sampleTrace.getSynthesisRateTraceForGene(geneIndex) != expected
+            || switchedTrace.getSynthesisRateTraceForGene(geneIndex) != expected
+            || sampleTrace.getSynthesisRateTraceByMixtureElementForGene(1u, geneIndex)
+               != geneTrace.getSynthesisRateTraceByMixtureElementForGene(1u, geneIndex)
+            || sampleTrace.getMixtureAssignmentTraceForGene(geneIndex) != expectedMixture
+            || switchedTrace.getMixtureAssignmentTraceForGene(geneIndex) != expectedMixture)
+        {
+            my_printError("Error in setTraceLayout: the traces of gene % depend on the layout.\n", geneIndex);
+            error = 1;
+            globalError = 1;
+        }
+    }
+    if (sampleTrace.getExpectedSynthesisRateTrace() != geneTrace.getExpectedSynthesisRateTrace())
+    {
+        my_printError("Error in setTraceLayout: getExpectedSynthesisRateTrace depends on the layout.\n");
+        error = 1;
+        globalError = 1;
+    }
+
+    if (!error)
+        my_print("Trace setTraceLayout --- Pass\n");
+    else
+        error = 0; //Reset for next function.
+
+    //-------------------------------------------------------//
+    //------ Mixture Assignment Trace Compression Test ------//
+    //-------------------------------------------------------//
+
+    // 16 mixture elements are packed into 4 bits per value
+    unsigned numMixtures = 16u;
+    unsigned longSamples = 200u;
+    std::vector<mixtureDefinition> manyCategories(numMixtures);
+    for (unsigned mixtureElement = 0u; mixtureElement < numMixtures; mixtureElement++)
+    {
+        manyCategories[mixtureElement].delM = 0u;
+        manyCategories[mixtureElement].delEta = 0u;
+    }
+    std::vector<double> few_phi = {0.5, 1.0, 1.5};
+    std::vector<unsigned> few_mix_assign = {0u, 15u, 0u};
+    std::vector<std::vector<unsigned>> expectedAssignment(3u, std::vector<unsigned>(longSamples));
+    Trace packedTrace(2u);
+    packedTrace.initializeROCTrace(longSamples, 3u, 1u, 1u, 1u, numMixtures, manyCategories, 1u, 0u, few_phi,
+        few_mix_assign);
+    for (unsigned sample = 0u; sample < longSamples; sample++)
+    {
+        expectedAssignment[0][sample] = sample < 120u ? 0u : 9u;
+        expectedAssignment[1][sample] = 15u;
+        expectedAssignment[2][sample] = sample / 50u;
+        for (unsigned geneIndex = 0u; geneIndex < 3u; geneIndex++)
+            packedTrace.updateMixtureAssignmentTrace(sample, geneIndex, expectedAssignment[geneIndex][sample]);
+    }
+
+    if (packedTrace.getMixtureAssignmentTrace() != expectedAssignment)
+    {
+        my_printError("Error in the packed mixture assignment trace: the values read back differ from the stored ones.\n");
+        error = 1;
+        globalError = 1;
+    }
+    if (packedTrace.getMixtureAssignmentTraceBytes() != 3u * longSamples / 2u)
+    {
+        my_printError("Error in the packed mixture assignment trace: it should use 4 bits per value but uses % bytes.\n",
+            packedTrace.getMixtureAssignmentTraceBytes());
+        error = 1;
+        globalError = 1;
+    }
+
+    // run length encoding only takes effect at the end of a run
+    std::vector<std::vector<unsigned>> packedCounts(3u);
+    for (unsigned geneIndex = 0u; geneIndex < 3u; geneIndex++)
+        packedCounts[geneIndex] = packedTrace.countMixtureAssignmentsForGene(geneIndex, 100u, longSamples, numMixtures);
+    std::size_t packedBytes = packedTrace.getMixtureAssignmentTraceBytes();
+    packedTrace.setMixtureAssignmentRunLengthEncoding(true);
+    packedTrace.encodeMixtureAssignmentTrace();
+    if (packedTrace.getMixtureAssignmentTrace() != expectedAssignment
+        || packedTrace.getMixtureAssignmentTraceBytes() >= packedBytes)
+    {
+        my_printError("Error in encodeMixtureAssignmentTrace: the runs should decode to the trace and be smaller.\n");
+        error = 1;
+        globalError = 1;
+    }
+    for (unsigned geneIndex = 0u; geneIndex < 3u; geneIndex++)
+    {
+        std::vector<unsigned> expectedCounts(numMixtures, 0u);
+        for (unsigned sample = 100u; sample < longSamples; sample++)
+            expectedCounts[expectedAssignment[geneIndex][sample]]++;
+        if (packedCounts[geneIndex] != expectedCounts
+            || packedTrace.countMixtureAssignmentsForGene(geneIndex, 100u, longSamples, numMixtures) != expectedCounts)
+        {
+            my_printError("Error in countMixtureAssignmentsForGene: wrong counts for gene %.\n", geneIndex);
+            error = 1;
+            globalError = 1;
+        }
+    }
+
+    // single values are read from the runs, which stay encoded
+    std::size_t encodedBytes = packedTrace.getMixtureAssignmentTraceBytes();
+    for (unsigned geneIndex = 0u; geneIndex < 3u; geneIndex++)
+    {
+        for (unsigned sample = 0u; sample < longSamples; sample++)
+        {
+            if (packedTrace.getMixtureAssignment(geneIndex, sample) != expectedAssignment[geneIndex][sample])
+            {
+                my_printError("Error in getMixtureAssignment: wrong value for gene % in sample % of the runs.\n",
+                    geneIndex, sample);
+                error = 1;
+                globalError = 1;
+            }
+        }
+    }
+    if (packedTrace.getMixtureAssignmentTraceBytes() != encodedBytes)
+    {
+        my_printError("Error in getMixtureAssignment: reading a value decoded the run length encoded trace.\n");
+        error = 1;
+        globalError = 1;
+    }
+
+    // storing a sample returns to the packed trace
+    packedTrace.updateMixtureAssignmentTrace(longSamples - 1u, 1u, 3u);
+    expectedAssignment[1][longSamples - 1u] = 3u;
+    if (packedTrace.getMixtureAssignmentTrace() != expectedAssignment
+        || packedTrace.getMixtureAssignmentTraceBytes() != packedBytes)
+    {
+        my_printError("Error in updateMixtureAssignmentTrace: updating a run length encoded trace failed.\n");
+        error = 1;
+        globalError = 1;
+    }
+
+    // values beyond the number of mixture elements widen the packed values
+    std::vector<unsigned> wideAssignment = geneTrace.getMixtureAssignmentTraceForGene(0u);
+    wideAssignment[2] = 37u;
+    geneTrace.updateMixtureAssignmentTrace(2u, 0u, 37u);
+    if (geneTrace.getMixtureAssignmentTraceForGene(0u) != wideAssignment
+        || geneTrace.getMixtureAssignmentTraceForGene(1u) != sampleTrace.getMixtureAssignmentTraceForGene(1u))
+    {
+        my_printError("Error in updateMixtureAssignmentTrace: a value needing more bits was not stored correctly.\n");
+        error = 1;
+        globalError = 1;
+    }
+
+    if (!error)
+        my_print("Trace mixture assignment trace compression --- Pass\n");
+    else
+        error = 0; //Reset for next function.
+
+    //----------------------------------------------------------//
+    //------ setActiveCategorySynthesisRateTrace Function ------//
+    //----------------------------------------------------------//
+
+    // only the rate of the assigned category is stored, the per gene traces match the full trace
+    Trace fullTrace(2u);
+    Trace activeTrace(2u);
+    Trace activeSampleTrace(2u);
+    activeTrace.setActiveCategorySynthesisRateTrace(true);
+    activeSampleTrace.setActiveCategorySynthesisRateTrace(true);
+    activeSampleTrace.setTraceLayout("sample");
+    fullTrace.initializeROCTrace(samples, numGenes, 1u, 2u, 1u, 2u, categories, 1u, 0u, init_phi, init_mix_assign);
+    activeTrace.initializeROCTrace(samples, numGenes, 1u, 2u, 1u, 2u, categories, 1u, 0u, init_phi, init_mix_assign);
+    activeSampleTrace.initializeROCTrace(samples, numGenes, 1u, 2u, 1u, 2u, categories, 1u, 0u, init_phi,
+        init_mix_assign);
+    for (unsigned sample = 0u; sample < samples; sample++)
+    {
+        for (unsigned geneIndex = 0u; geneIndex < numGenes; geneIndex++)
+        {
+            synthesisRateLevel[0][geneIndex] = 0.1 * (sample + 1u) + geneIndex;
+            synthesisRateLevel[1][geneIndex] = 0.2 * (sample + 1u) + geneIndex;
+            mixtureAssignment[geneIndex] = (sample * geneIndex) % 2u;
+            activeSampleTrace.updateMixtureAssignmentTrace(sample, geneIndex, mixtureAssignment[geneIndex]);
+            activeSampleTrace.updateSynthesisRateTrace(sample, geneIndex, synthesisRateLevel);
+        }
+        fullTrace.updateMixtureAssignmentTrace(sample, mixtureAssignment);
+        fullTrace.updateSynthesisRateTrace(sample, synthesisRateLevel);
+        activeTrace.updateMixtureAssignmentTrace(sample, mixtureAssignment);
+        activeTrace.updateSynthesisRateTrace(sample, synthesisRateLevel);
+    }
+
+    if (!activeTrace.getActiveCategorySynthesisRateTrace() || fullTrace.getActiveCategorySynthesisRateTrace()
+        || 2u * activeTrace.getSynthesisRateTraceBytes() != fullTrace.getSynthesisRateTraceBytes())
+    {
+        my_printError("Error in setActiveCategorySynthesisRateTrace: the trace should store one of two categories.\n");
+        error = 1;
+        globalError = 1;
+    }
+    for (unsigned geneIndex = 0u; geneIndex < numGenes; geneIndex++)
+    {
+        std::vector<float> expected = fullTrace.getSynthesisRateTraceForGene(geneIndex);
+        std::vector<unsigned> assignment = fullTrace.getMixtureAssignmentTraceForGene(geneIndex);
+        if (activeTrace.getSynthesisRateTraceForGene(geneIndex) != expected
+            || activeSampleTrace.getSynthesisRateTraceForGene(geneIndex) != expected
+            || activeTrace.getMixtureAssignmentTraceForGene(geneIndex) != assignment)
+        {
+            my_printError("Error in setActiveCategorySynthesisRateTrace: the trace of gene % differs from the full trace.\n",
+                geneIndex);
+            error = 1;
+            globalError = 1;
+        }
+
+        // samples in the other category were not recorded
+        std::vector<float> categoryTrace = activeTrace.getSynthesisRateTraceByMixtureElementForGene(1u, geneIndex);
+        std::vector<float> fullCategoryTrace = fullTrace.getSynthesisRateTraceByMixtureElementForGene(1u, geneIndex);
+        for (unsigned sample = 0u; sample < samples; sample++)
+        {
+            bool recorded = assignment[sample] == 1u;
+            if (recorded != !std::isnan(categoryTrace[sample])
+                || (recorded && categoryTrace[sample] != fullCategoryTrace[sample]))
+            {
+                my_printError("Error in getSynthesisRateTraceByMixtureElementForGene: wrong value for gene % in sample %.\n",
+                    geneIndex, sample);
+                error = 1;
+                globalError = 1;
+            }
+        }
+    }
+    if (activeTrace.getExpectedSynthesisRateTrace() != fullTrace.getExpectedSynthesisRateTrace())
+    {
+        my_printError("Error in setActiveCategorySynthesisRateTrace: getExpectedSynthesisRateTrace differs from the full trace.\n");
+        error = 1;
+        globalError = 1;
+    }
+
+
+    // the mode applies to the next run, toggling it leaves filled traces and their per gene reads unchanged
+    std::vector<std::vector<float>> fullGeneTraces(numGenes), activeGeneTraces(numGenes);
+    for (unsigned geneIndex = 0u; geneIndex < numGenes; geneIndex++)
+    {
+        fullGeneTraces[geneIndex] = fullTrace.getSynthesisRateTraceForGene(geneIndex);
+        activeGeneTraces[geneIndex] = activeTrace.getSynthesisRateTraceForGene(geneIndex);
+    }
+    std::size_t fullBytes = fullTrace.getSynthesisRateTraceBytes();
+    std::size_t activeBytes = activeTrace.getSynthesisRateTraceBytes();
+    fullTrace.setActiveCategorySynthesisRateTrace(true);
+    activeTrace.setActiveCategorySynthesisRateTrace(false);
+    if (!fullTrace.getActiveCategorySynthesisRateTrace() || activeTrace.getActiveCategorySynthesisRateTrace()
+        || fullTrace.getSynthesisRateTraceBytes() != fullBytes || activeTrace.getSynthesisRateTraceBytes() != activeBytes)
+    {
+        my_printError("Error in setActiveCategorySynthesisRateTrace: toggling the mode should not reshape filled traces.\n");
+        error = 1;
+        globalError = 1;
+    }
+    for (unsigned geneIndex = 0u; geneIndex < numGenes; geneIndex++)
+    {
+        if (fullTrace.getSynthesisRateTraceForGene(geneIndex) != fullGeneTraces[geneIndex]
+            || activeTrace.getSynthesisRateTraceForGene(geneIndex) != activeGeneTraces[geneIndex])
+        {
+            my_printError("Error in setActiveCategorySynthesisRateTrace: toggling the mode changed the trace of gene %.\n",
+                geneIndex);
+            error = 1;
+            globalError = 1;
+        }
+    }
+
+    // the next run takes the requested mode
+    fullTrace.initializeROCTrace(samples, numGenes, 1u, 2u, 1u, 2u, categories, 1u, 0u, init_phi, init_mix_assign);
+    activeTrace.initializeROCTrace(samples, numGenes, 1u, 2u, 1u, 2u, categories, 1u, 0u, init_phi, init_mix_assign);
+    if (fullTrace.getSynthesisRateTraceBytes() != activeBytes || activeTrace.getSynthesisRateTraceBytes() != fullBytes)
+    {
+        my_printError("Error in setActiveCategorySynthesisRateTrace: the next run should use the requested mode.\n");
+        error = 1;
+        globalError = 1;
+    }
+
+    if (!error)
+        my_print("Trace setActiveCategorySynthesisRateTrace --- Pass\n");
+    // No need to reset error
+
+    return globalError;
+}
+
 #ifndef STANDALONE
 //---------------------------------//
 //---------- RCPP Module ----------//
@@ -3667,5 +5093,11 @@ RCPP_MODULE(Test_mod)
 	function("testCovarianceMatrix", &testCovarianceMatrix);
 	//function("testPAParameter", &testPAParameter);
 	function("testMCMCAlgorithm", &testMCMCAlgorithm);
+	function("testROCModel", &testROCModel);
+	function("testLogRisingFactorialTable", &testLogRisingFactorialTable);
+	function("testPANSEModel", &testPANSEModel);
+	function("testFONSEModel", &testFONSEModel);
+	function("testTraceFile", &testTraceFile);
+	function("testTrace", &testTrace);
 }
 #endif
@@ -1,6 +1,9 @@
 #include "include/base/Trace.h"
 #include "include/SequenceSummary.h"
 #include <assert.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 #ifndef STANDALONE
 #include <Rcpp.h>
@@ -17,6 +20,16 @@ using namespace Rcpp;
 Trace::Trace()
 {
 	categories = 0;
+	numTraceExpressionCategories = 0u;
+	numTraceGenes = 0u;
+	synthesisRateTraceSamples = 0u;
+	mixtureAssignmentTraceSamples = 0u;
+	sampleMajorTraceLayout = false;
+	mixtureAssignmentBits = 1u;
+	runLengthMixtureAssignmentTrace = false;
+	activeCategorySynthesisRateTrace = false;
+	activeCategorySynthesisRateTraceMode = false;
+	traceFileWindowSamples = 100u;
 	numCodonSpecificParamTypes = 2;
 	codonSpecificParameterTrace.resize(numCodonSpecificParamTypes);
 	// TODO: fill this
@@ -32,6 +45,16 @@ Trace::~Trace()
 Trace::Trace(unsigned _numCodonSpecificParamTypes)
 {
 	categories = 0;
+	numTraceExpressionCategories = 0u;
+	numTraceGenes = 0u;
+	synthesisRateTraceSamples = 0u;
+	mixtureAssignmentTraceSamples = 0u;
+	sampleMajorTraceLayout = false;
+	mixtureAssignmentBits = 1u;
+	runLengthMixtureAssignmentTrace = false;
+	activeCategorySynthesisRateTrace = false;
+	activeCategorySynthesisRateTraceMode = false;
+	traceFileWindowSamples = 100u;
 	numCodonSpecificParamTypes = _numCodonSpecificParamTypes;
 	codonSpecificParameterTrace.resize(numCodonSpecificParamTypes);
 }
@@ -53,8 +76,15 @@ void Trace::initializeSharedTraces(unsigned samples, unsigned num_genes, unsigne
 	initStdDevSynthesisRateTrace(numSelectionCategories, samples);
 	initSynthesisRateAcceptanceRateTrace(num_genes, numSelectionCategories);
 	codonSpecificAcceptanceRateTrace.resize(maxGrouping);
-	initSynthesisRateTrace(samples, num_genes, numSelectionCategories,init_phi,estimateSynthesisRate);
-	initMixtureAssignmentTrace(samples, num_genes,init_mix_assign);
+	activeCategorySynthesisRateTrace = activeCategorySynthesisRateTraceMode;
+	// without estimating synthesis rates and mixture assignments the traces do not grow, keep them in memory
+	if (traceFileName.empty() || !estimateSynthesisRate
+		|| !initTraceFile(samples, num_genes, numSelectionCategories, _categories, init_phi, init_mix_assign))
+	{
+		traceFile.clear();
+		initSynthesisRateTrace(samples, num_genes, numSelectionCategories,init_phi,estimateSynthesisRate);
+		initMixtureAssignmentTrace(samples, num_genes,init_mix_assign, numMixtures);
+	}
 	initMixtureProbabilitiesTrace(samples, numMixtures);
 
 	categories = &_categories;
@@ -85,35 +115,30 @@ void Trace::initSynthesisRateAcceptanceRateTrace(unsigned num_genes, unsigned nu
 
 void Trace::initSynthesisRateTrace(unsigned samples, unsigned num_genes, unsigned numSynthesisRateCategories,std::vector<double> init_phi, bool estimateSynthesisRate)
 {
-	synthesisRateTrace.resize(numSynthesisRateCategories);
-	for (unsigned category = 0; category < numSynthesisRateCategories; category++)
+	numTraceExpressionCategories = numSynthesisRateCategories;
+	numTraceGenes = num_genes;
+	synthesisRateTraceSamples = estimateSynthesisRate ? samples : 1u;
+	unsigned numStoredCategories = getNumStoredSynthesisRateCategories();
+	synthesisRateTrace.resize((std::size_t)numStoredCategories * num_genes * synthesisRateTraceSamples);
+	for (unsigned category = 0; category < numStoredCategories; category++)
 	{
-		synthesisRateTrace[category].resize(num_genes);
 		for (unsigned i = 0; i < num_genes; i++)
 		{
-			if (estimateSynthesisRate)
-			{
-				std::vector<float> tempExpr(samples, init_phi[i]);
-				synthesisRateTrace[category][i] = tempExpr;
-			}
-			else
-			{
-				synthesisRateTrace[category][i].resize(1);
-				synthesisRateTrace[category][i][0] = init_phi[i];
-			}
+			for (unsigned sample = 0u; sample < synthesisRateTraceSamples; sample++)
+				synthesisRateTrace[getSynthesisRateTraceIndex(category, i, sample)] = init_phi[i];
 		}
 	}
 }
 
 
-void Trace::initMixtureAssignmentTrace(unsigned samples, unsigned num_genes, std::vector<unsigned> init_mix_assign)
+void Trace::initMixtureAssignmentTrace(unsigned samples, unsigned num_genes, std::vector<unsigned> init_mix_assign,
+	unsigned numMixtures)
 {
-	mixtureAssignmentTrace.resize(num_genes);
 	assert(init_mix_assign.size() == num_genes);
+	std::vector<std::vector<unsigned>> initialTrace(num_genes);
 	for (unsigned i = 0u; i < num_genes; i++)
-	{
-		mixtureAssignmentTrace[i].resize(samples,init_mix_assign[i]);
-	}
+		initialTrace[i].assign(samples, init_mix_assign[i]);
+	storeMixtureAssignmentTrace(initialTrace, numMixtures);
 }
 
 
@@ -163,6 +188,179 @@ void Trace::initCodonSpecificParameterTrace(unsigned samples, unsigned numCatego
 
 
 
+/* initTraceFile (NOT EXPOSED)
+ * Arguments: number of samples, number of genes, number of expression categories, mixture definitions, initial
+ * synthesis rates and mixture assignments
+ * Creates the trace file (see setTraceFileMode) for the synthesis rate and mixture assignment traces. The initial
+ * values are the fill values of the columns, as they are the values of the in memory traces before any update.
+ * The header metadata holds the number of expression categories, genes and mixture elements, followed by the
+ * expression category of each mixture element, so a finished file can be read without the Trace object.
+ * Mixture assignments are stored as float, which is exact for fewer than 2^24 mixture elements.
+ * In the active category mode (see setActiveCategorySynthesisRateTrace) the file has one synthesis rate column per gene.
+ * Returns false if the file could not be created.
+*/
+bool Trace::initTraceFile(unsigned samples, unsigned num_genes, unsigned numExpressionCategories,
+	std::vector<mixtureDefinition> &_categories, std::vector<double> init_phi, std::vector<unsigned> init_mix_assign)
+{
+	unsigned numStoredCategories = activeCategorySynthesisRateTrace ? 1u : numExpressionCategories;
+	std::vector<float> fillValues((numStoredCategories + 1u) * num_genes);
+	for (unsigned category = 0u; category < numStoredCategories; category++)
+	{
+		for (unsigned i = 0u; i < num_genes; i++)
+			fillValues[category * num_genes + i] = init_phi[i];
+	}
+	for (unsigned i = 0u; i < num_genes; i++)
+		fillValues[numStoredCategories * num_genes + i] = (float)init_mix_assign[i];
+
+	std::vector<unsigned> metadata = {numExpressionCategories, num_genes, (unsigned)_categories.size()};
+	for (unsigned mixtureElement = 0u; mixtureElement < _categories.size(); mixtureElement++)
+		metadata.push_back(_categories[mixtureElement].delEta);
+
+	if (!traceFile.init(traceFileName, samples, traceFileWindowSamples, fillValues, metadata))
+		return false;
+
+	numTraceExpressionCategories = numExpressionCategories;
+	numTraceGenes = num_genes;
+	synthesisRateTraceSamples = samples;
+	mixtureAssignmentTraceSamples = samples;
+	synthesisRateTrace.clear();
+	mixtureAssignmentTrace.clear();
+	mixtureAssignmentRuns.clear();
+	return true;
+}
+
+
+/* closeTraceFile (NOT EXPOSED)
+ * Arguments: None
+ * Reads the synthesis rate and mixture assignment traces back into memory and stops using the trace file.
+*/
+void Trace::closeTraceFile()
+{
+	if (!traceFile.isOpen())
+		return;
+
+	std::vector<std::vector<std::vector<float>>> synthesisRates = getStoredSynthesisRateTrace();
+	std::vector<std::vector<unsigned>> mixtureAssignments = getMixtureAssignmentTrace();
+	traceFile.clear();
+	storeSynthesisRateTrace(synthesisRates);
+	storeMixtureAssignmentTrace(mixtureAssignments);
+}
+
+
+/* storeSynthesisRateTrace (NOT EXPOSED)
+ * Arguments: synthesis rate trace (order: stored category, gene, sample)
+ * Copies the trace into the flat synthesisRateTrace in the current layout and takes its shape. In the active category
+ * mode the trace has a single stored category and the number of expression categories is kept.
+*/
+void Trace::storeSynthesisRateTrace(std::vector<std::vector<std::vector<float>>> &_synthesisRateTrace)
+{
+	if (!activeCategorySynthesisRateTrace)
+		numTraceExpressionCategories = (unsigned)_synthesisRateTrace.size();
+	unsigned numStoredCategories = (unsigned)_synthesisRateTrace.size();
+	numTraceGenes = _synthesisRateTrace.empty() ? 0u : (unsigned)_synthesisRateTrace[0].size();
+	synthesisRateTraceSamples = numTraceGenes == 0u ? 0u : (unsigned)_synthesisRateTrace[0][0].size();
+	synthesisRateTrace.resize((std::size_t)numStoredCategories * numTraceGenes * synthesisRateTraceSamples);
+	for (unsigned category = 0u; category < numStoredCategories; category++)
+	{
+		for (unsigned geneIndex = 0u; geneIndex < numTraceGenes; geneIndex++)
+		{
+			for (unsigned sample = 0u; sample < synthesisRateTraceSamples; sample++)
+				synthesisRateTrace[getSynthesisRateTraceIndex(category, geneIndex, sample)]
+					= _synthesisRateTrace[category][geneIndex][sample];
+		}
+	}
+}
+
+
+/* storeMixtureAssignmentTrace (NOT EXPOSED)
+ * Arguments: mixture assignment trace (order: gene, sample), number of mixture elements
+ * Packs the trace into mixtureAssignmentTrace in the current layout and takes its shape. Every value gets enough bits
+ * for the number of mixture elements or the largest value in the trace, whichever is larger.
+*/
+void Trace::storeMixtureAssignmentTrace(std::vector<std::vector<unsigned>> &_mixtureAssignmentTrace,
+	unsigned numMixtures)
+{
+	numTraceGenes = (unsigned)_mixtureAssignmentTrace.size();
+	mixtureAssignmentTraceSamples = numTraceGenes == 0u ? 0u : (unsigned)_mixtureAssignmentTrace[0].size();
+	for (unsigned geneIndex = 0u; geneIndex < numTraceGenes; geneIndex++)
+	{
+		for (unsigned sample = 0u; sample < mixtureAssignmentTraceSamples; sample++)
+		{
+			if (_mixtureAssignmentTrace[geneIndex][sample] >= numMixtures)
+				numMixtures = _mixtureAssignmentTrace[geneIndex][sample] + 1u;
+		}
+	}
+
+	const unsigned wordBits = 8u * sizeof(unsigned);
+	mixtureAssignmentBits = getMixtureAssignmentBits(numMixtures);
+	mixtureAssignmentRuns.clear();
+	mixtureAssignmentTrace.assign(((std::size_t)numTraceGenes * mixtureAssignmentTraceSamples * mixtureAssignmentBits
+		+ wordBits - 1u) / wordBits, 0u);
+	for (unsigned geneIndex = 0u; geneIndex < numTraceGenes; geneIndex++)
+	{
+		for (unsigned sample = 0u; sample < mixtureAssignmentTraceSamples; sample++)
+			setPackedMixtureAssignment(getMixtureAssignmentTraceIndex(geneIndex, sample),
+				_mixtureAssignmentTrace[geneIndex][sample]);
+	}
+}
+
+
+/* getMixtureAssignmentBits (NOT EXPOSED)
+ * Arguments: number of mixture elements
+ * Returns the number of bits per value in the packed mixture assignment trace: the smallest power of two that can
+ * hold every mixture element. Powers of two divide the word size, so no value spans two words.
+*/
+unsigned Trace::getMixtureAssignmentBits(unsigned numMixtures)
+{
+	unsigned bits = 1u;
+	while (bits < 32u && numMixtures > (1u << bits))
+		bits *= 2u;
+	return bits;
+}
+
+
+/* getPackedMixtureAssignment (NOT EXPOSED)
+ * Arguments: position of the value (see getMixtureAssignmentTraceIndex)
+ * Returns the value from the packed mixture assignment trace.
+*/
+unsigned Trace::getPackedMixtureAssignment(std::size_t index)
+{
+	const unsigned wordBits = 8u * sizeof(unsigned);
+	std::size_t bitIndex = index * mixtureAssignmentBits;
+	unsigned mask = mixtureAssignmentBits >= wordBits ? ~0u : (1u << mixtureAssignmentBits) - 1u;
+	return (mixtureAssignmentTrace[bitIndex / wordBits] >> (bitIndex % wordBits)) & mask;
+}
+
+
+/* setPackedMixtureAssignment (NOT EXPOSED)
+ * Arguments: position of the value (see getMixtureAssignmentTraceIndex), value
+ * Stores the value in the packed mixture assignment trace. The value has to fit into mixtureAssignmentBits.
+*/
+void Trace::setPackedMixtureAssignment(std::size_t index, unsigned value)
+{
+	const unsigned wordBits = 8u * sizeof(unsigned);
+	std::size_t bitIndex = index * mixtureAssignmentBits;
+	unsigned mask = mixtureAssignmentBits >= wordBits ? ~0u : (1u << mixtureAssignmentBits) - 1u;
+	unsigned shift = bitIndex % wordBits;
+	unsigned &word = mixtureAssignmentTrace[bitIndex / wordBits];
+	word = (word & ~(mask << shift)) | ((value & mask) << shift);
+}
+
+
+/* decodeMixtureAssignmentRuns (NOT EXPOSED)
+ * Arguments: None
+ * Turns a run length encoded mixture assignment trace (see encodeMixtureAssignmentTrace) back into the packed trace,
+ * so it can be updated.
+*/
+void Trace::decodeMixtureAssignmentRuns()
+{
+	if (mixtureAssignmentRuns.empty())
+		return;
+	std::vector<std::vector<unsigned>> mixtureAssignments = getMixtureAssignmentTrace();
+	storeMixtureAssignmentTrace(mixtureAssignments, 1u << (mixtureAssignmentBits < 32u ? mixtureAssignmentBits : 0u));
+}
+
+
 //----------------------------------//
 //---------- ROC Specific ----------//
 //----------------------------------//
@@ -276,6 +474,396 @@ void Trace::initializePANSETrace(unsigned samples, unsigned num_genes, unsigned
 }
 
 
+//-----------------------------------------//
+//---------- Trace File Functions ----------//
+//-----------------------------------------//
+
+
+/* setTraceFileMode (NOT EXPOSED)
+ * Arguments: name of the trace file (empty string to keep all traces in memory), number of samples kept in memory
+ * With a file name, the synthesis rate and mixture assignment traces, which grow with the number of genes, are not
+ * kept in memory for all samples. Instead the samples are collected in a window of windowSamples samples and
+ * appended to the file whenever the window is full (see TraceFile). The getters read the traces back from the file,
+ * so they work as before, but are slower. All other traces stay in memory.
+ * Takes effect when the traces are initialized, i.e. with the next run of the MCMC. The file is overwritten then.
+*/
+void Trace::setTraceFileMode(std::string filename, unsigned windowSamples)
+{
+	traceFileName = filename;
+	traceFileWindowSamples = windowSamples;
+}
+
+
+/* getTraceFileName (RCPP EXPOSED)
+ * Arguments: None
+ * Returns the name of the trace file holding the synthesis rate and mixture assignment traces, or an empty string if
+ * they are kept in memory.
+*/
+std::string Trace::getTraceFileName()
+{
+	return traceFile.getFilename();
+}
+
+
+/* flushTraceFile (NOT EXPOSED)
+ * Arguments: None
+ * Writes all samples collected so far to the trace file. Called at the end of a run, so the file is complete.
+ * Returns false if the trace file could not be written (see hasTraceFileWriteFailed), true without a trace file.
+*/
+bool Trace::flushTraceFile()
+{
+	return traceFile.flush();
+}
+
+
+/* hasTraceFileWriteFailed (NOT EXPOSED)
+ * Arguments: None
+ * Returns true if a sample could not be written to the trace file, so the file misses samples of the run.
+*/
+bool Trace::hasTraceFileWriteFailed()
+{
+	return traceFile.hasWriteFailed();
+}
+
+
+/* loadTraceFile (NOT EXPOSED)
+ * Arguments: name of a trace file written by a previous run (see setTraceFileMode), number of genes, mixture definitions
+ * Opens the trace file read only (memory mapped where available) and reads the synthesis rate and mixture assignment
+ * traces from it from now on, so posterior summaries of a finished run do not need the traces in memory. Several
+ * Trace objects can read the same file at the same time.
+ * The number of genes and the expression category of every mixture element stored in the header have to match the
+ * genes and the mixture definitions. A file written in the active category mode (one synthesis rate column per gene)
+ * switches the trace to this mode.
+ * Returns false and keeps the current traces if the file can not be read or does not match.
+*/
+bool Trace::loadTraceFile(std::string filename, unsigned numGenes, std::vector<mixtureDefinition> &_categories)
+{
+	TraceFile reader;
+	if (!reader.openForReading(filename))
+		return false;
+
+	//metadata: number of expression categories, genes and mixture elements, expression category of each mixture element
+	std::vector<unsigned> metadata = reader.getMetadata();
+	bool matches = metadata.size() >= 3u && metadata[1] == numGenes && metadata.size() == 3u + metadata[2]
+		&& (reader.getNumColumns() == (metadata[0] + 1u) * numGenes || reader.getNumColumns() == 2u * numGenes)
+		&& _categories.size() == metadata[2];
+	for (unsigned mixtureElement = 0u; matches && mixtureElement < _categories.size(); mixtureElement++)
+		matches = _categories[mixtureElement].delEta == metadata[3u + mixtureElement];
+	if (!matches)
+	{
+		my_printError("ERROR: Trace file % does not match the genes and mixture definitions\n", filename);
+		return false;
+	}
+
+	categories = &_categories;
+	traceFile = reader;
+	activeCategorySynthesisRateTrace = reader.getNumColumns() != (metadata[0] + 1u) * numGenes;
+	numTraceExpressionCategories = metadata[0];
+	numTraceGenes = numGenes;
+	synthesisRateTraceSamples = reader.getNumSamples();
+	mixtureAssignmentTraceSamples = reader.getNumSamples();
+	synthesisRateTrace.clear();
+	mixtureAssignmentTrace.clear();
+	mixtureAssignmentRuns.clear();
+	return true;
+}
+
+
+/* getTraceFileNumSamplesWritten (NOT EXPOSED)
+ * Arguments: None
+ * Returns the number of samples stored in the trace file so far (0 without a trace file).
+*/
+unsigned Trace::getTraceFileNumSamplesWritten()
+{
+	return traceFile.getNumSamplesWritten();
+}
+
+
+/* getSynthesisRateTraceByCategoryForGene (NOT EXPOSED)
+ * Arguments: expression category, gene index
+ * Returns the synthesis rate trace of the gene in the expression category, from memory or from the trace file. In the
+ * active category mode the samples in which the gene was assigned to another category were not recorded and are NaN.
+*/
+std::vector<float> Trace::getSynthesisRateTraceByCategoryForGene(unsigned category, unsigned geneIndex)
+{
+	if (!activeCategorySynthesisRateTrace)
+		return getStoredSynthesisRateTraceForGene(category, geneIndex);
+
+	std::vector<float> RV = getStoredSynthesisRateTraceForGene(0u, geneIndex);
+	std::vector<unsigned> mixtureAssignment = getMixtureAssignmentTraceForGene(geneIndex);
+	for (unsigned sample = 0u; sample < RV.size(); sample++)
+	{
+		if (getSynthesisRateCategory(mixtureAssignment[sample]) != category)
+			RV[sample] = std::numeric_limits<float>::quiet_NaN();
+	}
+	return RV;
+}
+
+
+/* getStoredSynthesisRateTraceForGene (NOT EXPOSED)
+ * Arguments: stored category (the expression category, or 0 in the active category mode), gene index
+ * Returns the synthesis rate trace of the gene as stored, from memory or from the trace file.
+*/
+std::vector<float> Trace::getStoredSynthesisRateTraceForGene(unsigned storedCategory, unsigned geneIndex)
+{
+	if (traceFile.isOpen())
+		return traceFile.getColumn(storedCategory * numTraceGenes + geneIndex);
+
+	std::vector<float>::iterator first = synthesisRateTrace.begin()
+		+ getSynthesisRateTraceIndex(storedCategory, geneIndex, 0u);
+	if (!sampleMajorTraceLayout)
+		return std::vector<float>(first, first + synthesisRateTraceSamples);
+
+	std::size_t stride = (std::size_t)getNumStoredSynthesisRateCategories() * numTraceGenes;
+	std::vector<float> RV(synthesisRateTraceSamples);
+	for (unsigned sample = 0u; sample < synthesisRateTraceSamples; sample++)
+		RV[sample] = first[sample * stride];
+	return RV;
+}
+
+
+/* getStoredSynthesisRateTrace (NOT EXPOSED)
+ * Arguments: None
+ * Returns the synthesis rate trace as stored (order: stored category, gene, sample), see storeSynthesisRateTrace.
+*/
+std::vector<std::vector<std::vector<float>>> Trace::getStoredSynthesisRateTrace()
+{
+	std::vector<std::vector<std::vector<float>>> RV(getNumStoredSynthesisRateCategories());
+	for (unsigned category = 0u; category < RV.size(); category++)
+	{
+		RV[category].resize(numTraceGenes);
+		for (unsigned geneIndex = 0u; geneIndex < RV[category].size(); geneIndex++)
+			RV[category][geneIndex] = getStoredSynthesisRateTraceForGene(category, geneIndex);
+	}
+	return RV;
+}
+
+
+/* getNumStoredSynthesisRateCategories (NOT EXPOSED)
+ * Arguments: None
+ * Returns the number of synthesis rate values stored per gene and sample: 1 in the active category mode, the number
+ * of expression categories otherwise.
+*/
+unsigned Trace::getNumStoredSynthesisRateCategories()
+{
+	return activeCategorySynthesisRateTrace ? 1u : numTraceExpressionCategories;
+}
+
+
+/* getMixtureAssignment (NOT EXPOSED)
+ * Arguments: gene index, sample
+ * Returns the mixture element the gene was assigned to in the sample, from memory or from the trace file. A run length
+ * encoded trace is searched for the run holding the sample and stays encoded.
+*/
+unsigned Trace::getMixtureAssignment(unsigned geneIndex, unsigned sample)
+{
+	if (traceFile.isOpen())
+		return (unsigned)traceFile.getValue(getNumStoredSynthesisRateCategories() * numTraceGenes + geneIndex, sample);
+	if (!mixtureAssignmentRuns.empty())
+	{
+		// first run ending after the sample, the run ends are increasing
+		std::vector<unsigned> &runs = mixtureAssignmentRuns[geneIndex];
+		unsigned low = 0u;
+		unsigned high = (unsigned)runs.size() / 2u;
+		while (low < high)
+		{
+			unsigned middle = (low + high) / 2u;
+			if (runs[2u * middle + 1u] <= sample)
+				low = middle + 1u;
+			else
+				high = middle;
+		}
+		return 2u * low < runs.size() ? runs[2u * low] : 0u;
+	}
+	return getPackedMixtureAssignment(getMixtureAssignmentTraceIndex(geneIndex, sample));
+}
+
+
+/* getSynthesisRateTraceLength (NOT EXPOSED)
+ * Arguments: None
+ * Returns the number of samples in the synthesis rate trace (1 if synthesis rates were not estimated).
+*/
+unsigned Trace::getSynthesisRateTraceLength()
+{
+	return synthesisRateTraceSamples;
+}
+
+
+/* getSynthesisRateTraceIndex (NOT EXPOSED)
+ * Arguments: expression category, gene index, sample
+ * Returns the position of the value in the flat synthesisRateTrace for the current layout.
+*/
+std::size_t Trace::getSynthesisRateTraceIndex(unsigned category, unsigned geneIndex, unsigned sample)
+{
+	if (sampleMajorTraceLayout)
+		return ((std::size_t)sample * getNumStoredSynthesisRateCategories() + category) * numTraceGenes + geneIndex;
+	return ((std::size_t)category * numTraceGenes + geneIndex) * synthesisRateTraceSamples + sample;
+}
+
+
+/* getMixtureAssignmentTraceIndex (NOT EXPOSED)
+ * Arguments: gene index, sample
+ * Returns the position of the value in the packed mixtureAssignmentTrace for the current layout (counted in values,
+ * not words).
+*/
+std::size_t Trace::getMixtureAssignmentTraceIndex(unsigned geneIndex, unsigned sample)
+{
+	if (sampleMajorTraceLayout)
+		return (std::size_t)sample * numTraceGenes + geneIndex;
+	return (std::size_t)geneIndex * mixtureAssignmentTraceSamples + sample;
+}
+
+
+
+
+//-------------------------------------------//
+//---------- Trace Layout Functions ----------//
+//-------------------------------------------//
+
+
+/* setTraceLayout (NOT EXPOSED)
+ * Arguments: "gene" or "sample"
+ * Sets the order of the in memory synthesis rate and mixture assignment traces. With "gene" (the default) the samples
+ * of a gene are contiguous, which makes the per gene getters used by the posterior summaries a plain copy. With
+ * "sample" all genes of a sample are contiguous, which makes storing a sample (updateSynthesisRateTrace and
+ * updateMixtureAssignmentTrace for all genes) a sequential write, at the cost of strided per gene reads.
+ * Existing traces are reordered. The trace file (see setTraceFileMode) has its own layout and is not affected.
+*/
+void Trace::setTraceLayout(std::string layout)
+{
+	if (layout != "gene" && layout != "sample")
+	{
+		my_printError("ERROR: Unknown trace layout %. Use \"gene\" or \"sample\".\n", layout);
+		return;
+	}
+	bool sampleMajor = (layout == "sample");
+	if (sampleMajor == sampleMajorTraceLayout)
+		return;
+
+	if (traceFile.isOpen())
+	{
+		sampleMajorTraceLayout = sampleMajor;
+		return;
+	}
+	std::vector<std::vector<std::vector<float>>> synthesisRates = getStoredSynthesisRateTrace();
+	std::vector<std::vector<unsigned>> mixtureAssignments = getMixtureAssignmentTrace();
+	bool runLengthEncoded = !mixtureAssignmentRuns.empty();
+	sampleMajorTraceLayout = sampleMajor;
+	storeSynthesisRateTrace(synthesisRates);
+	storeMixtureAssignmentTrace(mixtureAssignments, 1u << (mixtureAssignmentBits < 32u ? mixtureAssignmentBits : 0u));
+	if (runLengthEncoded)
+		encodeMixtureAssignmentTrace();
+}
+
+
+/* getTraceLayout (NOT EXPOSED)
+ * Arguments: None
+ * Returns the order of the in memory synthesis rate and mixture assignment traces, "gene" or "sample".
+*/
+std::string Trace::getTraceLayout()
+{
+	return sampleMajorTraceLayout ? "sample" : "gene";
+}
+
+
+/* setMixtureAssignmentRunLengthEncoding (NOT EXPOSED)
+ * Arguments: true to run length encode the mixture assignment trace at the end of a run
+ * The mixture assignment trace is always bit packed (1 to 4 bits per value for up to 16 mixture elements instead of
+ * 32). As genes rarely change their mixture element, it can in addition be stored as runs of equal values per gene
+ * once the run is finished (see encodeMixtureAssignmentTrace). The getters read the runs, and storing a new sample
+ * returns to the packed trace.
+*/
+void Trace::setMixtureAssignmentRunLengthEncoding(bool runLength)
+{
+	runLengthMixtureAssignmentTrace = runLength;
+	if (!runLength)
+		decodeMixtureAssignmentRuns();
+}
+
+
+/* encodeMixtureAssignmentTrace (NOT EXPOSED)
+ * Arguments: None
+ * Replaces the packed mixture assignment trace by runs of equal values per gene if run length encoding is enabled
+ * and the runs need less memory than the packed trace. Called at the end of a run.
+*/
+void Trace::encodeMixtureAssignmentTrace()
+{
+	if (!runLengthMixtureAssignmentTrace || traceFile.isOpen() || !mixtureAssignmentRuns.empty()
+		|| mixtureAssignmentTrace.empty())
+		return;
+
+	std::vector<std::vector<unsigned>> runs(numTraceGenes);
+	std::size_t runWords = 0u;
+	for (unsigned geneIndex = 0u; geneIndex < numTraceGenes; geneIndex++)
+	{
+		std::vector<unsigned> mixtureAssignment = getMixtureAssignmentTraceForGene(geneIndex);
+		for (unsigned sample = 0u; sample < mixtureAssignmentTraceSamples; sample++)
+		{
+			if (sample + 1u == mixtureAssignmentTraceSamples || mixtureAssignment[sample + 1u] != mixtureAssignment[sample])
+			{
+				runs[geneIndex].push_back(mixtureAssignment[sample]);
+				runs[geneIndex].push_back(sample + 1u);
+			}
+		}
+		runWords += runs[geneIndex].size();
+		if (runWords >= mixtureAssignmentTrace.size())
+			return; // the packed trace is smaller
+	}
+
+	mixtureAssignmentRuns.swap(runs);
+	std::vector<unsigned>().swap(mixtureAssignmentTrace);
+}
+
+
+/* getMixtureAssignmentTraceBytes (NOT EXPOSED)
+ * Arguments: None
+ * Returns the memory used by the values of the in memory mixture assignment trace.
+*/
+std::size_t Trace::getMixtureAssignmentTraceBytes()
+{
+	std::size_t words = mixtureAssignmentTrace.size();
+	for (unsigned geneIndex = 0u; geneIndex < mixtureAssignmentRuns.size(); geneIndex++)
+		words += mixtureAssignmentRuns[geneIndex].size();
+	return words * sizeof(unsigned);
+}
+
+
+/* setActiveCategorySynthesisRateTrace (NOT EXPOSED)
+ * Arguments: true to store only the synthesis rate of the expression category each gene is assigned to
+ * With several expression categories the synthesis rate trace holds the rate of every gene in every category, but the
+ * per gene trace (getSynthesisRateTraceForGene) and the posterior summaries only use the category the gene is assigned
+ * to in each sample. Storing only that rate divides the trace by the number of categories. The traces of a gene in the
+ * other categories are then not available (see getSynthesisRateTraceByCategoryForGene).
+ * Takes effect when the traces are initialized at the start of the next run, existing traces keep their shape.
+*/
+void Trace::setActiveCategorySynthesisRateTrace(bool activeCategoryOnly)
+{
+	activeCategorySynthesisRateTraceMode = activeCategoryOnly;
+}
+
+
+/* getActiveCategorySynthesisRateTrace (NOT EXPOSED)
+ * Arguments: None
+ * Returns true if the next run stores only the synthesis rate of the assigned expression category.
+*/
+bool Trace::getActiveCategorySynthesisRateTrace()
+{
+	return activeCategorySynthesisRateTraceMode;
+}
+
+
+/* getSynthesisRateTraceBytes (NOT EXPOSED)
+ * Arguments: None
+ * Returns the memory used by the values of the in memory synthesis rate trace.
+*/
+std::size_t Trace::getSynthesisRateTraceBytes()
+{
+	return synthesisRateTrace.size() * sizeof(float);
+}
+
+
+
+
 //--------------------------------------//
 //---------- Getter Functions ----------//
 //--------------------------------------//
@@ -289,19 +877,17 @@ std::vector<double> Trace::getStdDevSynthesisRateTrace(unsigned selectionCategor
 
 std::vector<double> Trace::getExpectedSynthesisRateTrace()
 {
-	unsigned numGenes = (unsigned)synthesisRateTrace[0].size(); //number of genes
-	unsigned samples = (unsigned)synthesisRateTrace[0][0].size(); //number of samples
+	unsigned numGenes = numTraceGenes; //number of genes
+	unsigned samples = getSynthesisRateTraceLength(); //number of samples
 	std::vector<double> RV(samples, 0.0);
-	for (unsigned sample = 0; sample < samples; sample++)
+	for (unsigned geneIndex = 0; geneIndex < numGenes; geneIndex++)
 	{
-		for (unsigned geneIndex = 0; geneIndex < numGenes; geneIndex++)
-		{
-			unsigned mixtureElement = mixtureAssignmentTrace[geneIndex][sample];
-			unsigned category = getSynthesisRateCategory(mixtureElement);
-			RV[sample] += synthesisRateTrace[category][geneIndex][sample];
-		}
-		RV[sample] /= numGenes;
+		std::vector<float> geneTrace = getSynthesisRateTraceForGene(geneIndex);
+		for (unsigned sample = 0; sample < samples; sample++)
+			RV[sample] += geneTrace[sample];
 	}
+	for (unsigned sample = 0; sample < samples; sample++)
+		RV[sample] /= numGenes;
 	return RV;
 }
 
@@ -314,7 +900,14 @@ std::vector<double> Trace::getStdDevSynthesisRateAcceptanceRateTrace()
 
 std::vector<std::vector<std::vector<float>>> Trace::getSynthesisRateTrace()
 {
-	return synthesisRateTrace;
+	std::vector<std::vector<std::vector<float>>> RV(numTraceExpressionCategories);
+	for (unsigned category = 0u; category < RV.size(); category++)
+	{
+		RV[category].resize(numTraceGenes);
+		for (unsigned geneIndex = 0u; geneIndex < RV[category].size(); geneIndex++)
+			RV[category][geneIndex] = getSynthesisRateTraceByCategoryForGene(category, geneIndex);
+	}
+	return RV;
 }
 
 
@@ -342,14 +935,54 @@ std::vector<double> Trace::getCodonSpecificAcceptanceRateTraceForAA(std::string
 
 std::vector<float> Trace::getSynthesisRateTraceForGene(unsigned geneIndex)
 {
-	unsigned traceLength = (unsigned)synthesisRateTrace[0][0].size();
+	// a single stored category is the trace of the gene, in the gene major layout a plain copy
+	if (activeCategorySynthesisRateTrace || numTraceExpressionCategories == 1u)
+		return getStoredSynthesisRateTraceForGene(0u, geneIndex);
 
+	unsigned traceLength = getSynthesisRateTraceLength();
 	std::vector<float> returnVector(traceLength, 0.0);
+	if (!traceFile.isOpen() && mixtureAssignmentRuns.empty())
+	{
+		// one base pointer per mixture element, the samples of a gene are stride apart. The mixture assignments are
+		// unpacked on the fly with a running bit position.
+		std::size_t stride = sampleMajorTraceLayout ? (std::size_t)numTraceExpressionCategories * numTraceGenes : 1u;
+		std::vector<const float*> mixtureBase(categories->size());
+		for (unsigned mixtureElement = 0u; mixtureElement < mixtureBase.size(); mixtureElement++)
+			mixtureBase[mixtureElement] = &synthesisRateTrace[getSynthesisRateTraceIndex(
+				getSynthesisRateCategory(mixtureElement), geneIndex, 0u)];
+
+		const unsigned wordBits = 8u * sizeof(unsigned);
+		unsigned mask = mixtureAssignmentBits >= wordBits ? ~0u : (1u << mixtureAssignmentBits) - 1u;
+		std::size_t bitIndex = getMixtureAssignmentTraceIndex(geneIndex, 0u) * mixtureAssignmentBits;
+		std::size_t bitStride = (sampleMajorTraceLayout ? (std::size_t)numTraceGenes : 1u) * mixtureAssignmentBits;
+		for (unsigned i = 0u; i < traceLength; i++, bitIndex += bitStride)
+		{
+			unsigned mixtureElement = (mixtureAssignmentTrace[bitIndex / wordBits] >> (bitIndex % wordBits)) & mask;
+			returnVector[i] = mixtureBase[mixtureElement][i * stride];
+		}
+		return returnVector;
+	}
+
+	std::vector<unsigned> mixtureAssignment = getMixtureAssignmentTraceForGene(geneIndex);
+	if (!traceFile.isOpen())
+	{
+		for (unsigned i = 0u; i < traceLength; i++)
+		{
+			unsigned category = getSynthesisRateCategory(mixtureAssignment[i]);
+			returnVector[i] = synthesisRateTrace[getSynthesisRateTraceIndex(category, geneIndex, i)];
+		}
+		return returnVector;
+	}
+
+	// the traces of the categories are only read from the file when the gene was assigned to them
+	std::vector<std::vector<float>> categoryTrace(numTraceExpressionCategories);
 	for (unsigned i = 0u; i < traceLength; i++)
 	{
-		unsigned mixtureElement = mixtureAssignmentTrace[geneIndex][i];
+		unsigned mixtureElement = mixtureAssignment[i];
 		unsigned category = getSynthesisRateCategory(mixtureElement);
-		returnVector[i] = synthesisRateTrace[category][geneIndex][i];
+		if (categoryTrace[category].empty())
+			categoryTrace[category] = getSynthesisRateTraceByCategoryForGene(category, geneIndex);
+		returnVector[i] = categoryTrace[category][i];
 	}
 	return returnVector;
 }
@@ -360,13 +993,86 @@ std::vector<float> Trace::getSynthesisRateTraceByMixtureElementForGene(unsigned
 
 
 	unsigned category = getSynthesisRateCategory(mixtureElement);
-	return synthesisRateTrace[category][geneIndex];
+	return getSynthesisRateTraceByCategoryForGene(category, geneIndex);
 }
 
 
 std::vector<unsigned> Trace::getMixtureAssignmentTraceForGene(unsigned geneIndex)
 {
-	return mixtureAssignmentTrace[geneIndex];
+	if (traceFile.isOpen())
+	{
+		std::vector<float> column = traceFile.getColumn(getNumStoredSynthesisRateCategories() * numTraceGenes + geneIndex);
+		std::vector<unsigned> RV(column.size());
+		for (unsigned i = 0u; i < column.size(); i++)
+			RV[i] = (unsigned)column[i];
+		return RV;
+	}
+
+	std::vector<unsigned> RV(mixtureAssignmentTraceSamples);
+	if (!mixtureAssignmentRuns.empty())
+	{
+		std::vector<unsigned> &runs = mixtureAssignmentRuns[geneIndex];
+		unsigned sample = 0u;
+		for (unsigned run = 0u; run < runs.size(); run += 2u)
+		{
+			std::fill(RV.begin() + sample, RV.begin() + runs[run + 1u], runs[run]);
+			sample = runs[run + 1u];
+		}
+		return RV;
+	}
+	// unpack with one running bit position instead of recomputing the index of every sample
+	const unsigned wordBits = 8u * sizeof(unsigned);
+	unsigned mask = mixtureAssignmentBits >= wordBits ? ~0u : (1u << mixtureAssignmentBits) - 1u;
+	std::size_t bitIndex = getMixtureAssignmentTraceIndex(geneIndex, 0u) * mixtureAssignmentBits;
+	std::size_t bitStride = (sampleMajorTraceLayout ? (std::size_t)numTraceGenes : 1u) * mixtureAssignmentBits;
+	for (unsigned sample = 0u; sample < mixtureAssignmentTraceSamples; sample++, bitIndex += bitStride)
+		RV[sample] = (mixtureAssignmentTrace[bitIndex / wordBits] >> (bitIndex % wordBits)) & mask;
+	return RV;
+}
+
+
+/* countMixtureAssignmentsForGene (NOT EXPOSED)
+ * Arguments: gene index, first sample, sample after the last sample, number of mixture elements
+ * Returns how often the gene was assigned to each mixture element in the samples, counted on the compressed trace
+ * without decoding it.
+*/
+std::vector<unsigned> Trace::countMixtureAssignmentsForGene(unsigned geneIndex, unsigned first, unsigned last,
+	unsigned numMixtures)
+{
+	std::vector<unsigned> counts(numMixtures, 0u);
+	if (!mixtureAssignmentRuns.empty())
+	{
+		std::vector<unsigned> &runs = mixtureAssignmentRuns[geneIndex];
+		unsigned runStart = 0u;
+		for (unsigned run = 0u; run < runs.size() && runStart < last; run += 2u)
+		{
+			unsigned start = runStart > first ? runStart : first;
+			unsigned end = runs[run + 1u] < last ? runs[run + 1u] : last;
+			if (end > start && runs[run] < numMixtures)
+				counts[runs[run]] += end - start;
+			runStart = runs[run + 1u];
+		}
+		return counts;
+	}
+
+	if (traceFile.isOpen())
+	{
+		std::vector<unsigned> mixtureAssignment = getMixtureAssignmentTraceForGene(geneIndex);
+		for (unsigned sample = first; sample < last; sample++)
+		{
+			if (mixtureAssignment[sample] < numMixtures)
+				counts[mixtureAssignment[sample]]++;
+		}
+		return counts;
+	}
+
+	for (unsigned sample = first; sample < last; sample++)
+	{
+		unsigned value = getPackedMixtureAssignment(getMixtureAssignmentTraceIndex(geneIndex, sample));
+		if (value < numMixtures)
+			counts[value]++;
+	}
+	return counts;
 }
 
 
@@ -378,7 +1084,10 @@ std::vector<double> Trace::getMixtureProbabilitiesTraceForMixture(unsigned mixtu
 
 std::vector<std::vector<unsigned>> Trace::getMixtureAssignmentTrace()
 {
-	return mixtureAssignmentTrace;
+	std::vector<std::vector<unsigned>> RV(numTraceGenes);
+	for (unsigned geneIndex = 0u; geneIndex < RV.size(); geneIndex++)
+		RV[geneIndex] = getMixtureAssignmentTraceForGene(geneIndex);
+	return RV;
 }
 
 
@@ -416,10 +1125,11 @@ std::vector<float> Trace::getCodonSpecificParameterTraceByGeneElementForCodon(un
 	std::vector <float> rv;
 	unsigned codonIndex = SequenceSummary::codonToIndex(codon, withoutReference);
 	unsigned tracelength = (unsigned)codonSpecificParameterTrace[0][0][0].size();
+	std::vector<unsigned> mixtureAssignment = getMixtureAssignmentTraceForGene(geneIndex);
 	rv.resize(tracelength);
 	for(unsigned i = 0; i < tracelength; i++)
 	{
-		unsigned mixtureElement = mixtureAssignmentTrace[geneIndex][i];
+		unsigned mixtureElement = mixtureAssignment[i];
 		unsigned category = getCodonSpecificCategory(mixtureElement, paramType);
 		rv[i] = codonSpecificParameterTrace[paramType][category][codonIndex][i];
 	}
@@ -527,19 +1237,86 @@ void Trace::updateCodonSpecificAcceptanceRateTrace(unsigned codonIndex, double a
 }
 
 
+/* updateSynthesisRateTrace (NOT EXPOSED)
+ * Arguments: sample, gene index, current synthesis rates (order: expression category, gene)
+ * Stores the sample of the gene. In the active category mode only the rate of the category the gene is assigned to is
+ * stored, so the mixture assignment of the sample has to be stored first.
+*/
 void Trace::updateSynthesisRateTrace(unsigned sample, unsigned geneIndex,
 	std::vector<std::vector <double>> &currentSynthesisRateLevel)
 {
-	for (unsigned category = 0; category < synthesisRateTrace.size(); category++)
+	if (activeCategorySynthesisRateTrace)
 	{
-		synthesisRateTrace[category][geneIndex][sample] = currentSynthesisRateLevel[category][geneIndex];
+		unsigned category = getSynthesisRateCategory(getMixtureAssignment(geneIndex, sample));
+		if (traceFile.isOpen())
+			traceFile.setValue(geneIndex, sample, currentSynthesisRateLevel[category][geneIndex]);
+		else
+			synthesisRateTrace[getSynthesisRateTraceIndex(0u, geneIndex, sample)] = currentSynthesisRateLevel[category][geneIndex];
+		return;
+	}
+	if (traceFile.isOpen())
+	{
+		for (unsigned category = 0; category < numTraceExpressionCategories; category++)
+			traceFile.setValue(category * numTraceGenes + geneIndex, sample, currentSynthesisRateLevel[category][geneIndex]);
+		return;
+	}
+	for (unsigned category = 0; category < numTraceExpressionCategories; category++)
+	{
+		synthesisRateTrace[getSynthesisRateTraceIndex(category, geneIndex, sample)] = currentSynthesisRateLevel[category][geneIndex];
+	}
+}
+
+
+/* updateSynthesisRateTrace (NOT EXPOSED)
+ * Arguments: sample, current synthesis rates (order: expression category, gene)
+ * Stores the sample for all genes at once. In the sample major layout this is one sequential write per category.
+*/
+void Trace::updateSynthesisRateTrace(unsigned sample, std::vector<std::vector <double>> &currentSynthesisRateLevel)
+{
+	if (traceFile.isOpen() || activeCategorySynthesisRateTrace)
+	{
+		for (unsigned geneIndex = 0u; geneIndex < numTraceGenes; geneIndex++)
+			updateSynthesisRateTrace(sample, geneIndex, currentSynthesisRateLevel);
+		return;
+	}
+	// distance between the values of consecutive genes
+	std::size_t stride = sampleMajorTraceLayout ? 1u : synthesisRateTraceSamples;
+	for (unsigned category = 0u; category < numTraceExpressionCategories; category++)
+	{
+		float *destination = &synthesisRateTrace[getSynthesisRateTraceIndex(category, 0u, sample)];
+		std::vector<double> &source = currentSynthesisRateLevel[category];
+		for (unsigned geneIndex = 0u; geneIndex < numTraceGenes; geneIndex++)
+			destination[geneIndex * stride] = (float)source[geneIndex];
 	}
 }
 
 
 void Trace::updateMixtureAssignmentTrace(unsigned sample, unsigned geneIndex, unsigned value)
 {
-	mixtureAssignmentTrace[geneIndex][sample] = value;
+	if (traceFile.isOpen())
+	{
+		traceFile.setValue(getNumStoredSynthesisRateCategories() * numTraceGenes + geneIndex, sample, (float)value);
+		return;
+	}
+	decodeMixtureAssignmentRuns();
+	if (mixtureAssignmentBits < 32u && value >= (1u << mixtureAssignmentBits))
+	{
+		// more mixture elements than the trace was packed for
+		std::vector<std::vector<unsigned>> mixtureAssignments = getMixtureAssignmentTrace();
+		storeMixtureAssignmentTrace(mixtureAssignments, value + 1u);
+	}
+	setPackedMixtureAssignment(getMixtureAssignmentTraceIndex(geneIndex, sample), value);
+}
+
+
+/* updateMixtureAssignmentTrace (NOT EXPOSED)
+ * Arguments: sample, current mixture assignment of every gene
+ * Stores the sample for all genes at once. In the sample major layout this is one sequential write.
+*/
+void Trace::updateMixtureAssignmentTrace(unsigned sample, std::vector<unsigned> &mixtureAssignment)
+{
+	for (unsigned geneIndex = 0u; geneIndex < numTraceGenes; geneIndex++)
+		updateMixtureAssignmentTrace(sample, geneIndex, mixtureAssignment[geneIndex]);
 }
 
 
@@ -669,7 +1446,7 @@ std::vector<double> Trace::getSynthesisRateAcceptanceRateTraceByMixtureElementFo
 std::vector<float> Trace::getSynthesisRateTraceForGeneR(unsigned geneIndex)
 {
 	std::vector<float> RV;
-	bool checkGene = checkIndex(geneIndex, 1, synthesisRateTrace[0].size());
+	bool checkGene = checkIndex(geneIndex, 1, numTraceGenes);
 	if (checkGene)
 	{
 		RV = getSynthesisRateTraceForGene(geneIndex - 1);
@@ -682,7 +1459,7 @@ std::vector<float> Trace::getSynthesisRateTraceByMixtureElementForGeneR(unsigned
 {
 	std::vector<float> RV;
 	bool checkMixtureElement = checkIndex(mixtureElement, 1, mixtureProbabilitiesTrace.size());
-	bool checkGene = checkIndex(geneIndex, 1, synthesisRateTrace[0].size());
+	bool checkGene = checkIndex(geneIndex, 1, numTraceGenes);
 	if (checkMixtureElement && checkGene)
 	{
 		RV = getSynthesisRateTraceByMixtureElementForGene(mixtureElement - 1, geneIndex - 1);
@@ -694,7 +1471,7 @@ std::vector<float> Trace::getSynthesisRateTraceByMixtureElementForGeneR(unsigned
 std::vector<unsigned> Trace::getMixtureAssignmentTraceForGeneR(unsigned geneIndex)
 {
 	std::vector <unsigned> RV;
-	bool checkGene = checkIndex(geneIndex, 1, mixtureAssignmentTrace.size());
+	bool checkGene = checkIndex(geneIndex, 1, numTraceGenes);
 	if (checkGene)
 	{
 		RV = getMixtureAssignmentTraceForGene(geneIndex - 1);
@@ -753,7 +1530,10 @@ void Trace::setStdDevSynthesisRateAcceptanceRateTrace(std::vector<double> _stdDe
 
 void Trace::setSynthesisRateTrace(std::vector<std::vector<std::vector<float>>> _synthesisRateTrace)
 {
-	synthesisRateTrace = _synthesisRateTrace;
+	// the trace holds every expression category
+	closeTraceFile();
+	activeCategorySynthesisRateTrace = false;
+	storeSynthesisRateTrace(_synthesisRateTrace);
 }
 
 
@@ -765,7 +1545,8 @@ void Trace::setSynthesisRateAcceptanceRateTrace(std::vector<std::vector<std::vec
 
 void Trace::setMixtureAssignmentTrace(std::vector<std::vector<unsigned>> _mixtureAssignmentTrace)
 {
-	mixtureAssignmentTrace = _mixtureAssignmentTrace;
+	closeTraceFile();
+	storeMixtureAssignmentTrace(_mixtureAssignmentTrace);
 }
 
 
@@ -0,0 +1,523 @@
+#include "include/base/TraceFile.h"
+#include <algorithm>
+#include <cstring>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+
+//--------------------------------------------------//
+//----------- Constructors & Destructors -----------//
+//--------------------------------------------------//
+
+
+TraceFile::TraceFile()
+{
+	numColumns = 0u;
+	numSamples = 0u;
+	windowSamples = 0u;
+	numSamplesWritten = 0u;
+	numChunksInFile = 0u;
+	windowChunk = 0u;
+	readOnly = false;
+	writeFailed = false;
+	mappedData = 0;
+	mappedSize = 0u;
+}
+
+
+TraceFile::TraceFile(const TraceFile &other)
+{
+	mappedData = 0;
+	mappedSize = 0u;
+	*this = other;
+}
+
+
+/* operator= (NOT EXPOSED)
+ * Copies all members. A read only copy maps the file again instead of sharing the mapping, so each copy can be
+ * destroyed on its own.
+*/
+TraceFile& TraceFile::operator=(const TraceFile &rhs)
+{
+	if (this == &rhs)
+		return *this;
+
+	unmapFile();
+	filename = rhs.filename;
+	numColumns = rhs.numColumns;
+	numSamples = rhs.numSamples;
+	windowSamples = rhs.windowSamples;
+	numSamplesWritten = rhs.numSamplesWritten;
+	numChunksInFile = rhs.numChunksInFile;
+	windowChunk = rhs.windowChunk;
+	fillValues = rhs.fillValues;
+	window = rhs.window;
+	metadata = rhs.metadata;
+	readOnly = rhs.readOnly;
+	writeFailed = rhs.writeFailed;
+	if (rhs.mappedData)
+		mapFile();
+	return *this;
+}
+
+
+TraceFile::~TraceFile()
+{
+	unmapFile();
+}
+
+
+
+
+
+//------------------------------------------------//
+//---------- Initialization Functions ------------//
+//------------------------------------------------//
+
+
+/* init (NOT EXPOSED)
+ * Arguments: name of the file to create (an existing file is overwritten), number of samples per column, number of
+ * samples held in memory, fill value of each column (defines the number of columns), metadata stored in the header
+ * Creates the file and writes the header. Returns false and leaves the TraceFile closed if the file can not be written.
+*/
+bool TraceFile::init(std::string _filename, unsigned _numSamples, unsigned _windowSamples,
+	std::vector <float> _fillValues, std::vector <unsigned> _metadata)
+{
+	clear();
+	if (_numSamples == 0u || _fillValues.empty())
+		return false;
+
+	std::ofstream out(_filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!out)
+	{
+		my_printError("ERROR: Could not create trace file %\n", _filename);
+		return false;
+	}
+
+	filename = _filename;
+	numColumns = (unsigned)_fillValues.size();
+	numSamples = _numSamples;
+	windowSamples = _windowSamples == 0u ? 1u : _windowSamples;
+	if (windowSamples > numSamples)
+		windowSamples = numSamples;
+	fillValues = _fillValues;
+	metadata = _metadata;
+
+	unsigned header[6] = {fileVersion, numColumns, numSamples, windowSamples, numSamplesWritten,
+		(unsigned)metadata.size()};
+	out.write("ACTF", 4);
+	out.write(reinterpret_cast<const char*>(header), sizeof(header));
+	if (!metadata.empty())
+		out.write(reinterpret_cast<const char*>(metadata.data()), metadata.size() * sizeof(unsigned));
+	out.write(reinterpret_cast<const char*>(fillValues.data()), fillValues.size() * sizeof(float));
+	if (!out)
+	{
+		my_printError("ERROR: Could not write the header of trace file %\n", _filename);
+		clear();
+		return false;
+	}
+
+	resetWindow(0u);
+	return true;
+}
+
+
+/* openForReading (NOT EXPOSED)
+ * Arguments: name of a trace file written by a TraceFile
+ * Opens the file read only and maps it into memory. Values can not be set afterwards. Samples beyond the last chunk
+ * in the file (a run that was stopped early) hold the fill values.
+ * Returns false and leaves the TraceFile closed if the file can not be read or is not a trace file of this version.
+*/
+bool TraceFile::openForReading(std::string _filename)
+{
+	clear();
+	std::ifstream in(_filename.c_str(), std::ios::in | std::ios::binary | std::ios::ate);
+	if (!in)
+	{
+		my_printError("ERROR: Could not open trace file %\n", _filename);
+		return false;
+	}
+	std::streamoff fileSize = in.tellg();
+	in.seekg(0);
+
+	char magic[4] = {0, 0, 0, 0};
+	unsigned header[6] = {0u, 0u, 0u, 0u, 0u, 0u};
+	in.read(magic, 4);
+	in.read(reinterpret_cast<char*>(header), sizeof(header));
+	if (!in || std::strncmp(magic, "ACTF", 4) != 0 || header[0] != fileVersion || header[1] == 0u || header[3] == 0u)
+	{
+		my_printError("ERROR: % is not a trace file of version %\n", _filename, fileVersion);
+		return false;
+	}
+
+	filename = _filename;
+	numColumns = header[1];
+	numSamples = header[2];
+	windowSamples = header[3];
+	numSamplesWritten = header[4];
+	metadata.resize(header[5]);
+	fillValues.resize(numColumns);
+	if (!metadata.empty())
+		in.read(reinterpret_cast<char*>(metadata.data()), metadata.size() * sizeof(unsigned));
+	in.read(reinterpret_cast<char*>(fillValues.data()), fillValues.size() * sizeof(float));
+	std::streamoff chunkBytes = (std::streamoff)numColumns * windowSamples * sizeof(float);
+	if (!in || fileSize < getDataOffset())
+	{
+		my_printError("ERROR: The header of trace file % is incomplete\n", _filename);
+		clear();
+		return false;
+	}
+
+	// there is no window, all chunks come from the file
+	numChunksInFile = (unsigned)((fileSize - getDataOffset()) / chunkBytes);
+	windowChunk = (numSamples + windowSamples - 1u) / windowSamples;
+	readOnly = true;
+#ifndef _WIN32
+	mapFile();
+#endif
+	return true;
+}
+
+
+/* clear (NOT EXPOSED)
+ * Arguments: None
+ * Closes the TraceFile and releases the window and the mapping. The file itself is kept.
+*/
+void TraceFile::clear()
+{
+	unmapFile();
+	filename = "";
+	numColumns = 0u;
+	numSamples = 0u;
+	windowSamples = 0u;
+	numSamplesWritten = 0u;
+	numChunksInFile = 0u;
+	windowChunk = 0u;
+	readOnly = false;
+	writeFailed = false;
+	fillValues.clear();
+	window.clear();
+	metadata.clear();
+}
+
+
+bool TraceFile::isOpen()
+{
+	return numColumns > 0u;
+}
+
+
+bool TraceFile::isReadOnly()
+{
+	return readOnly;
+}
+
+
+std::string TraceFile::getFilename()
+{
+	return filename;
+}
+
+
+unsigned TraceFile::getNumColumns()
+{
+	return numColumns;
+}
+
+
+unsigned TraceFile::getNumSamples()
+{
+	return numSamples;
+}
+
+
+unsigned TraceFile::getNumSamplesWritten()
+{
+	return numSamplesWritten;
+}
+
+
+unsigned TraceFile::getWindowSamples()
+{
+	return windowSamples;
+}
+
+
+std::vector <unsigned> TraceFile::getMetadata()
+{
+	return metadata;
+}
+
+
+/* getDataOffset (NOT EXPOSED)
+ * Arguments: None
+ * Returns the position of the first chunk in the file.
+*/
+std::streamoff TraceFile::getDataOffset()
+{
+	return 4 + (6 + (std::streamoff)metadata.size()) * (std::streamoff)sizeof(unsigned)
+		+ (std::streamoff)numColumns * (std::streamoff)sizeof(float);
+}
+
+
+/* resetWindow (NOT EXPOSED)
+ * Arguments: index of the chunk the window holds from now on
+ * Sets all values of the window to the fill values of their columns.
+*/
+void TraceFile::resetWindow(unsigned chunk)
+{
+	windowChunk = chunk;
+	window.resize(numColumns * windowSamples);
+	for (unsigned column = 0u; column < numColumns; column++)
+		std::fill(window.begin() + column * windowSamples, window.begin() + (column + 1) * windowSamples,
+			fillValues[column]);
+}
+
+
+/* writeChunks (NOT EXPOSED)
+ * Arguments: None
+ * Writes the window to its chunk in the file. Chunks between the end of the file and the window, which never received
+ * a value, are written with the fill values first. Returns false if the file could not be written.
+*/
+bool TraceFile::writeChunks()
+{
+	std::fstream out(filename.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+	if (!out)
+	{
+		my_printError("ERROR: Could not open trace file % for writing\n", filename);
+		return false;
+	}
+
+	std::streamoff chunkBytes = (std::streamoff)numColumns * windowSamples * sizeof(float);
+	if (numChunksInFile < windowChunk)
+	{
+		std::vector <float> fillChunk(numColumns * windowSamples);
+		for (unsigned column = 0u; column < numColumns; column++)
+			std::fill(fillChunk.begin() + column * windowSamples, fillChunk.begin() + (column + 1) * windowSamples,
+				fillValues[column]);
+		out.seekp(getDataOffset() + numChunksInFile * chunkBytes);
+		for (unsigned chunk = numChunksInFile; chunk < windowChunk; chunk++)
+			out.write(reinterpret_cast<const char*>(fillChunk.data()), chunkBytes);
+	}
+	out.seekp(getDataOffset() + windowChunk * chunkBytes);
+	out.write(reinterpret_cast<const char*>(window.data()), chunkBytes);
+	if (!out)
+	{
+		my_printError("ERROR: Could not write to trace file %\n", filename);
+		return false;
+	}
+	if (numChunksInFile < windowChunk + 1u)
+		numChunksInFile = windowChunk + 1u;
+
+	out.seekp(4 + 4 * (std::streamoff)sizeof(unsigned));
+	out.write(reinterpret_cast<const char*>(&numSamplesWritten), sizeof(unsigned));
+	if (!out)
+	{
+		my_printError("ERROR: Could not write to trace file %\n", filename);
+		return false;
+	}
+	return true;
+}
+
+
+/* mapFile (NOT EXPOSED)
+ * Arguments: None
+ * Maps the whole file read only into memory. Without mmap (Windows) or if mapping fails, getColumn reads the file
+ * with a stream instead. Returns true if the file is mapped.
+*/
+bool TraceFile::mapFile()
+{
+#ifndef _WIN32
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat fileStatus;
+	if (fstat(fd, &fileStatus) != 0 || fileStatus.st_size <= 0)
+	{
+		close(fd);
+		return false;
+	}
+	void *data = mmap(0, (std::size_t)fileStatus.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd); // the mapping stays valid
+	if (data == MAP_FAILED)
+		return false;
+	mappedData = static_cast<char*>(data);
+	mappedSize = (std::size_t)fileStatus.st_size;
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+void TraceFile::unmapFile()
+{
+#ifndef _WIN32
+	if (mappedData)
+		munmap(mappedData, mappedSize);
+#endif
+	mappedData = 0;
+	mappedSize = 0u;
+}
+
+
+
+
+
+//------------------------------------------------//
+//---------------- Value Functions ---------------//
+//------------------------------------------------//
+
+
+/* setValue (NOT EXPOSED)
+ * Arguments: column, sample, value
+ * Stores the value. A sample after the window moves the window forward and writes the old window to the file, a
+ * sample before the window is written to the file directly, opening the file for each value. MCMCAlgorithm::run stores
+ * the samples in increasing order and never takes that path, it only serves values set out of order by hand.
+ * Values outside of the file are ignored. Returns false if the file is read only or a write to the file failed, now or
+ * for an earlier value (see hasWriteFailed).
+*/
+bool TraceFile::setValue(unsigned column, unsigned sample, float value)
+{
+	if (column >= numColumns || sample >= numSamples)
+		return !writeFailed;
+	if (readOnly)
+	{
+		my_printError("ERROR: Trace file % is read only\n", filename);
+		return false;
+	}
+	if (sample >= numSamplesWritten)
+		numSamplesWritten = sample + 1u;
+
+	unsigned chunk = sample / windowSamples;
+	unsigned offset = sample - chunk * windowSamples;
+	if (chunk == windowChunk)
+	{
+		window[column * windowSamples + offset] = value;
+	}
+	else if (chunk > windowChunk)
+	{
+		if (!writeChunks())
+			writeFailed = true;
+		resetWindow(chunk);
+		window[column * windowSamples + offset] = value;
+	}
+	else
+	{
+		// the chunk has to exist in the file before it can be patched
+		if (chunk >= numChunksInFile && !writeChunks())
+			writeFailed = true;
+		std::fstream out(filename.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+		std::streamoff position = getDataOffset()
+			+ ((std::streamoff)chunk * numColumns * windowSamples + column * windowSamples + offset) * sizeof(float);
+		out.seekp(position);
+		out.write(reinterpret_cast<const char*>(&value), sizeof(float));
+		if (!out)
+		{
+			my_printError("ERROR: Could not write to trace file %\n", filename);
+			writeFailed = true;
+		}
+	}
+	return !writeFailed;
+}
+
+
+/* getValue (NOT EXPOSED)
+ * Arguments: column, sample
+ * Returns a single value. Samples in the window are returned directly, any other sample reads the whole column.
+*/
+float TraceFile::getValue(unsigned column, unsigned sample)
+{
+	if (column >= numColumns || sample >= numSamples)
+		return 0.0f;
+	if (!readOnly && sample / windowSamples == windowChunk)
+		return window[column * windowSamples + sample % windowSamples];
+	return getColumn(column)[sample];
+}
+
+
+/* getColumn (NOT EXPOSED)
+ * Arguments: column
+ * Returns all samples of the column, read from the file (or its mapping) and the window.
+*/
+std::vector <float> TraceFile::getColumn(unsigned column)
+{
+	std::vector <float> values;
+	if (column >= numColumns)
+		return values;
+
+	values.resize(numSamples, fillValues[column]);
+	if (mappedData)
+	{
+		unsigned numChunks = (numSamples + windowSamples - 1u) / windowSamples;
+		if (numChunks > numChunksInFile)
+			numChunks = numChunksInFile;
+		for (unsigned chunk = 0u; chunk < numChunks; chunk++)
+		{
+			unsigned first = chunk * windowSamples;
+			unsigned length = numSamples - first < windowSamples ? numSamples - first : windowSamples;
+			std::streamoff position = getDataOffset()
+				+ ((std::streamoff)chunk * numColumns * windowSamples + column * windowSamples) * sizeof(float);
+			std::memcpy(&values[first], mappedData + position, length * sizeof(float));
+		}
+		return values;
+	}
+
+	std::ifstream in;
+	if (numChunksInFile > 0u)
+	{
+		in.open(filename.c_str(), std::ios::in | std::ios::binary);
+		if (!in)
+			my_printError("ERROR: Could not open trace file % for reading\n", filename);
+	}
+
+	unsigned numChunks = (numSamples + windowSamples - 1u) / windowSamples;
+	for (unsigned chunk = 0u; chunk < numChunks; chunk++)
+	{
+		unsigned first = chunk * windowSamples;
+		unsigned length = numSamples - first < windowSamples ? numSamples - first : windowSamples;
+		if (chunk == windowChunk)
+		{
+			std::copy(window.begin() + column * windowSamples, window.begin() + column * windowSamples + length,
+				values.begin() + first);
+		}
+		else if (chunk < numChunksInFile && in)
+		{
+			in.seekg(getDataOffset()
+				+ ((std::streamoff)chunk * numColumns * windowSamples + column * windowSamples) * sizeof(float));
+			in.read(reinterpret_cast<char*>(&values[first]), length * sizeof(float));
+		}
+	}
+	if (numChunksInFile > 0u && !in)
+		my_printError("ERROR: Could not read column % from trace file %\n", column, filename);
+	return values;
+}
+
+
+/* flush (NOT EXPOSED)
+ * Arguments: None
+ * Writes the window to the file, so the file holds every value set so far. The window is kept and can be written
+ * again later. Returns false if this or an earlier write to the file failed, the file is then incomplete.
+*/
+bool TraceFile::flush()
+{
+	if (isOpen() && !readOnly && !writeChunks())
+		writeFailed = true;
+	return !writeFailed;
+}
+
+
+/* hasWriteFailed (NOT EXPOSED)
+ * Arguments: None
+ * Returns true if a write to the file failed since it was created, so values set since then may be missing.
+*/
+bool TraceFile::hasWriteFailed()
+{
+	return writeFailed;
+}
@@ -0,0 +1,46 @@
+#ifndef Benchmark_H
+#define Benchmark_H
+
+
+#include "Genome.h"
+#include "MCMCAlgorithm.h"
+
+
+#include <string>
+#include <vector>
+
+
+/* Benchmark driver (STANDALONE only)
+ * Measures the per iteration throughput of MCMCAlgorithm::run for ROC, FONSE, PA and PANSE on synthetic genomes.
+ * The benchmark executable is built from the same sources as the package, with main.cpp providing the entry point:
+ *   cd src && g++ -std=c++11 -O2 -fopenmp -DSTANDALONE -DBENCHMARK -I. *.cpp -o anacoda_benchmark
+ *   ./anacoda_benchmark [-m ROC,FONSE,PA,PANSE] [-g 1000,10000,50000] [-l 300,3000] [-t maxThreads] [-i iterations]
+ *                       [-o results.csv]
+ * -l sets the gene lengths in codons, long genes show the cost of the positional likelihoods (FONSE, PANSE).
+*/
+
+#ifdef STANDALONE
+
+struct BenchmarkResult
+{
+	std::string modelName;
+	unsigned numGenes;
+	unsigned codonsPerGene; // set by runBenchmarks
+	unsigned numThreads;
+	unsigned iterations;
+	double secondsPerIteration;
+	double genesPerSecond;
+	std::vector<double> phaseSecondsPerIteration; //order: MCMCAlgorithm profile phase
+};
+
+
+void simulateBenchmarkGenome(Genome& genome, unsigned numGenes, unsigned codonsPerGene, bool withRFPCounts,
+	bool positional, unsigned seed);
+BenchmarkResult benchmarkModel(std::string modelName, Genome& genome, unsigned numThreads, unsigned iterations,
+	unsigned seed);
+int runBenchmarks(std::vector<std::string> modelNames, std::vector<unsigned> genomeSizes,
+	std::vector<unsigned> geneLengths, unsigned maxThreads, unsigned iterations, std::string outputFile);
+
+#endif // STANDALONE
+
+#endif // Benchmark_H
@@ -4,14 +4,37 @@
 #include "../base/Model.h"
 #include "FONSEParameter.h"
 
+#include <array>
+
 class FONSEModel : public Model
 {
 	private:
 		FONSEParameter *parameter;
-		double calculateLogLikelihoodRatioPerAA(Gene& gene, std::string grouping, double *mutation, double *selection, double phiValue);
+
+		// position buckets for the likelihood, see setPositionBucketMode. A bucket pools the positions of a codon in a
+		// gene that fall into the same window of positionBucketWidth codons.
+		static const unsigned numCodonsTotal = 64u; // all codons including stop codons, see SequenceSummary::codonArray
+		unsigned positionBucketWidth; // 0 = exact likelihood
+		std::vector <unsigned> positionBucketStart; //order: gene, codon. First bucket of each pair, one past the end at the back
+		std::vector <double> positionBucketCount; //order: gene, codon, bucket. Number of positions in the bucket
+		std::vector <double> positionBucketMeanPosition; //order: gene, codon, bucket
+		std::vector <double> positionBucketSquaredDeviation; //order: gene, codon. Sum of squared distances to the bucket means
+
+		bool hasPositionBuckets(unsigned geneIndex);
+		void calculateLogCodonProbabilityCoefficients(unsigned numCodons, double *mutation, double *selection,
+					double offset[], double slope[], bool inDenominator[], double &initialDenominator);
+		double calculateLogLikelihoodPerAAPerGene(Gene& gene, unsigned aaStart, unsigned numCodons, const double offset[],
+					const double slope[], const bool inDenominator[], double initialDenominator, double phiValue);
+		double calculateLogLikelihoodPerAAPerGeneFromBuckets(unsigned geneIndex, unsigned aaStart, unsigned numCodons,
+					const double offset[], const double slope[], const bool inDenominator[], double initialDenominator,
+					double phiValue);
+		double calculatePositionBucketErrorBoundPerAAPerGene(unsigned geneIndex, unsigned aaStart, unsigned numCodons,
+					const double slope[], double phiValue);
 		double calculateMutationPrior(std::string grouping, bool proposed = false);
 
 	public:
+		static const unsigned positionBatchSize = 64u; // maximum number of positions evaluated together by calculateLogLikelihoodPerAAPerGene
+
 		//Constructors & Destructors:
 		explicit FONSEModel();
 		virtual ~FONSEModel();
@@ -21,6 +44,7 @@ class FONSEModel : public Model
 		//Likelihood Ratio Functions:
 		virtual void calculateLogLikelihoodRatioPerGene(Gene& gene, unsigned geneIndex, unsigned k, double* logProbabilityRatio);
 		virtual void calculateLogLikelihoodRatioPerGroupingPerCategory(std::string grouping, Genome& genome, std::vector<double> &logAcceptanceRatioForAllMixtures);
+		virtual bool supportsSinglePassCodonSpecificUpdate();
 		virtual void calculateLogLikelihoodRatioForHyperParameters(Genome &genome, unsigned iteration, std::vector <double> &logProbabilityRatio);
 
 
@@ -69,10 +93,13 @@ class FONSEModel : public Model
 		virtual void updateStdDevSynthesisRateTrace(unsigned sample);
 		virtual void updateSynthesisRateTrace(unsigned sample, unsigned i);
 		virtual void updateMixtureAssignmentTrace(unsigned sample, unsigned i);
+		virtual void updateSynthesisRateTraces(unsigned sample);
 		virtual void updateMixtureProbabilitiesTrace(unsigned sample);
 		virtual void updateCodonSpecificParameterTrace(unsigned sample, std::string grouping);
 		virtual void updateHyperParameterTraces(unsigned sample);
 		virtual void updateTracesWithInitialValues(Genome &genome);
+		virtual bool flushTraces();
+		virtual bool hasTraceFileWriteFailed();
 
 
 
@@ -114,6 +141,8 @@ class FONSEModel : public Model
 					double phi, double codonProb[]);
 		virtual void getParameterForCategory(unsigned category, unsigned param, std::string aa, bool proposal,
 					double* returnValue);
+		void setPositionBucketMode(Genome &genome, unsigned _positionBucketWidth);
+		double calculatePositionBucketErrorBound(Genome &genome, bool proposed = false);
 
 
 
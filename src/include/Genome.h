@@ -28,7 +28,11 @@ class Genome
 												//with a phi value for that set. Values should currently be equal.
         std::vector<std::string> RFPCountColumnNames;
         unsigned prev_genome_size;
-        unsigned totalRFPCount;
+        std::vector <unsigned> totalRFPCount; // per RFP count column, see getSumRFP
+
+		std::vector <unsigned> codonCountMatrix; // codon counts of all (non simulated) genes, one block per codon:
+		// codonCountMatrix[codonIndex * numGenes + geneIndex]. Codon index as in SequenceSummary::codonArray.
+		bool codonCountMatrixIsCurrent; // false after genes have been added or removed, see invalidateCodonCountMatrix.
 
 
   	public:
@@ -65,9 +69,12 @@ class Genome
 		void clear();
 		Genome getGenomeForGeneIndices(std::vector <unsigned> indices, bool simulated = false);
 		std::vector <unsigned> getCodonCountsPerGene(std::string codon);
+		void initCodonCountMatrix();
+		const unsigned* getCodonCountsForCodonIndex(unsigned codonIndex);
+		void invalidateCodonCountMatrix();
         std::vector <std::string> getRFPCountColumnNames();
 		void addRFPCountColumnName(std::string categoryName);
-		unsigned getSumRFP();
+		unsigned getSumRFP(unsigned RFPCountColumn = 0u);
 
 		//Testing Functions:
 		std::vector <unsigned> getNumGenesWithPhi();
@@ -35,11 +35,20 @@ class MCMCAlgorithm
 		bool estimateHyperParameter;
 		bool estimateMixtureAssignment;
 		bool writeRestartFile;
+		bool singlePassCodonSpecificParameterUpdate;
+		bool fusedGenomeTraversal;
+		bool profiling;
 
 
 		std::vector<double> posteriorTrace;
 		std::vector<double> likelihoodTrace;
 		std::vector<double> tmp;
+		std::vector<unsigned> genomeTraversalTrace; // passes over the genome per stored iteration
+		std::vector<double> genomeTraversalBytesTrace; // estimated bytes of gene data read per stored iteration
+		std::vector<double> profileTimes; // wall time in seconds, order: phase
+		std::vector<double> profileCalls; // counters are doubles so long runs do not overflow on the way to R
+		std::vector<double> profileProposals;
+		std::vector<double> profileAcceptances;
 
 
 		std::string file;
@@ -51,9 +60,31 @@ class MCMCAlgorithm
 		double acceptRejectSynthesisRateLevelForAllGenes(Genome& genome, Model& model, int iteration);
 		void acceptRejectCodonSpecificParameter(Genome& genome, Model& model, int iteration);
 		void acceptRejectHyperParameter(Genome &genome, Model& model, unsigned iteration);
+		void acceptRejectCodonSpecificAndHyperParameter(Genome& genome, Model& model, int iteration);
+		bool acceptRejectGrouping(Model& model, std::string grouping, double threshold,
+					std::vector<double> &acceptanceRatioForAllMixtures, int iteration);
+		void acceptRejectHyperParameterRatios(Model& model, std::vector <double> &logProbabilityRatios, unsigned iteration);
+
+		//Trace Functions:
+		void updateCodonSpecificParameterTraces(Model& model, unsigned sample);
+		void updateSynthesisRateTraces(Genome& genome, Model& model, unsigned sample);
+
+		//Profiling Functions:
+		std::chrono::steady_clock::time_point startProfilePhase();
+		void recordProfilePhase(unsigned phase, std::chrono::steady_clock::time_point start);
+		void recordProfileAcceptances(unsigned phase, unsigned proposals, unsigned accepted);
 
 	public:
 
+		//Profiled phases of an iteration:
+		static const unsigned codonSpecificProposalPhase;
+		static const unsigned codonSpecificAcceptRejectPhase;
+		static const unsigned hyperParameterUpdatePhase;
+		static const unsigned synthesisRateUpdatePhase;
+		static const unsigned traceWritePhase;
+		static const unsigned restartFileWritePhase;
+		static const unsigned numProfilePhases;
+
 		//Constructors & Destructors:
 		explicit MCMCAlgorithm();
 		MCMCAlgorithm(unsigned samples, unsigned thinning, unsigned _adaptiveWidth = 100,
@@ -80,9 +111,25 @@ class MCMCAlgorithm
 		void setRestartFileSettings(std::string filename, unsigned interval, bool multiple); //TODO: UNTESTED
 		void setStepsToAdapt(unsigned steps);
 		int getStepsToAdapt();
+		bool isSinglePassCodonSpecificParameterUpdate();
+		void setSinglePassCodonSpecificParameterUpdate(bool in);
+		bool isFusedGenomeTraversal();
+		void setFusedGenomeTraversal(bool in);
 
 		std::vector<double> getLogPosteriorTrace();
 		std::vector<double> getLogLikelihoodTrace();
+		std::vector<unsigned> getGenomeTraversalTrace();
+		std::vector<double> getGenomeTraversalBytesTrace();
+
+		bool isProfiling();
+		void setProfiling(bool in);
+		void resetProfile();
+		std::vector<std::string> getProfilePhaseNames();
+		std::vector<double> getProfileTimes();
+		std::vector<double> getProfileCalls();
+		std::vector<double> getProfileProposals();
+		std::vector<double> getProfileAcceptances();
+		void writeProfile(std::string filename, bool json);
 		double getLogPosteriorMean(unsigned samples); //TODO: UNTESTED
 
 		static std::vector<double> acf(std::vector<double>& x, int nrows, int ncols, int lagmax, bool correlation, bool demean); //Currently unused. TODO: UNTESTED
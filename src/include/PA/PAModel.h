@@ -3,6 +3,7 @@
 
 
 #include "../base/Model.h"
+#include "../base/LogRisingFactorialTable.h"
 #include "PAParameter.h"
 
 #include <sstream>
@@ -15,6 +16,8 @@ class PAModel: public Model
 
 		double calculateLogLikelihoodPerCodonPerGene(double currAlpha, double currLambdaPrime,
 				unsigned currRFPValue, unsigned currNumCodonsInMRNA, double phiValue);
+		double calculateLogLikelihoodPerCodonPerGene(double logRisingFactorial, double alphaTimesCodonCount,
+				double currLambdaPrime, double logLambdaPrime, unsigned currRFPValue, double phiValue, double logPhi);
 
 
 	public:
@@ -28,6 +31,7 @@ class PAModel: public Model
 				double* logProbabilityRatio); // Depends on RFPCountColumn
 		virtual void calculateLogLikelihoodRatioPerGroupingPerCategory(std::string grouping, Genome& genome,
 				std::vector<double> &logAcceptanceRatioForAllMixtures); // Depends on RFPCountColumn
+		virtual bool supportsSinglePassCodonSpecificUpdate();
 		virtual void calculateLogLikelihoodRatioForHyperParameters(Genome &genome, unsigned iteration,
 				std::vector <double> &logProbabilityRatio);
 
@@ -70,10 +74,13 @@ class PAModel: public Model
 		virtual void updateStdDevSynthesisRateTrace(unsigned sample);
 		virtual void updateSynthesisRateTrace(unsigned sample, unsigned i);
 		virtual void updateMixtureAssignmentTrace(unsigned sample, unsigned i);
+		virtual void updateSynthesisRateTraces(unsigned sample);
 		virtual void updateMixtureProbabilitiesTrace(unsigned sample);
 		virtual void updateCodonSpecificParameterTrace(unsigned sample, std::string codon);
 		virtual void updateHyperParameterTraces(unsigned sample);
 		virtual void updateTracesWithInitialValues(Genome &genome);
+		virtual bool flushTraces();
+		virtual bool hasTraceFileWriteFailed();
 
 
 		//Adaptive Width Functions:
@@ -110,6 +117,7 @@ class PAModel: public Model
 		void setParameter(PAParameter &_parameter);
 		virtual double calculateAllPriors();
 		virtual double getParameterForCategory(unsigned category, unsigned param, std::string codon, bool proposal);
+		double getParameterForCategory(unsigned category, unsigned param, unsigned codonIndex, bool proposal);
 
 };
 
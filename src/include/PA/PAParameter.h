@@ -66,6 +66,7 @@ class PAParameter: public Parameter {
 
 		//Other functions:
 		double getParameterForCategory(unsigned category, unsigned paramType, std::string codon, bool proposal);
+		double getParameterForCategory(unsigned category, unsigned paramType, unsigned codonIndex, bool proposal);
 
 
 
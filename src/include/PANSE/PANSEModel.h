@@ -3,25 +3,52 @@
 
 
 #include "../base/Model.h"
+#include "../base/LogRisingFactorialTable.h"
 #include "PANSEParameter.h"
 #include "../SequenceSummary.h"
 
 #include <sstream>
+#include <cstdint>
+#include <array>
+#include <algorithm>
+#include <limits>
 
 class PANSEModel: public Model
 {
 	private:
 		PANSEParameter *parameter;
 		unsigned RFPCountColumn;
-		double currSigmaCalculationSummationFor1, currSigmaCalculationSummationFor2;
-		double propSigmaCalculationSummationFor1, propSigmaCalculationSummationFor2;
+		//Codon occurrence index, see updateCodonOccurrenceIndex:
+		Genome *indexedGenome;
+		std::vector <unsigned> genePositionOffset; // start of each gene in the per position vectors, size genes + 1
+		std::vector <uint64_t> geneCodonMask; // bit c is set if codon c occurs in the gene
+		std::vector <std::vector <unsigned>> codonOccurrenceGenes; // per codon: genes containing the codon, ascending
+		std::vector <std::vector <unsigned>> codonOccurrenceGeneOffset; // per codon: start of each gene's occurrences
+		std::vector <std::vector <unsigned>> codonOccurrencePosition; // per codon: index into the per position vectors
+		std::vector <std::vector <int>> codonOccurrenceRFPCount; // per codon: RFP count of the occurrence
+		std::vector <unsigned> sigmaMixtureAssignment; // mixture assignment the prefix sums were calculated with
+		std::vector <double> currSigmaSummand, propSigmaSummand; // per mixture element and codon
+		std::vector <double> currSigmaPrefixSum, propSigmaPrefixSum; // per position, summed within each gene
+		std::vector <unsigned char> positionCodon; // per position: codon index
+		std::vector <int> positionRFPCount; // per position: RFP count in RFPCountColumn, -1 if missing
+		LogRisingFactorialTable alphaLogRisingFactorial; // order: alpha category, codon
+
+
 		double calculateLogLikelihoodPerCodonPerGene(double currAlpha, double currLambdaPrime,
 				unsigned currRFPObserved, double phiValue, double prevSigma);
+		double calculateLogLikelihoodPerCodonPerGene(double logRisingFactorial, double currAlpha, double currLambdaPrime,
+				double logLambdaPrime, unsigned currRFPObserved, double phiValue, double logPhi, double prevSigma);
+		void updateCodonOccurrenceIndex(Genome &genome);
+		void updateSigmaPrefixSums(Genome &genome, bool proposed);
+		double calculateLogLikelihoodRatioForPartitionFunction(Genome &genome); // Depends on RFPCountColumn
 
 
 	public:
+		static const unsigned maxTabulatedRFPCount; // largest RFP count alphaLogRisingFactorial holds
+		static const unsigned maxIncompleteGammaIterations; // iteration budget of each branch of UpperIncompleteGammaLog
+
 		//Constructors & Destructors:
-		explicit PANSEModel(unsigned RFPCountColumn = 0u);
+		explicit PANSEModel(unsigned RFPCountColumn = 1u);
 		virtual ~PANSEModel();
 
 
@@ -31,7 +58,8 @@ class PANSEModel: public Model
 		virtual void calculateLogLikelihoodRatioPerGroupingPerCategory(std::string grouping, Genome& genome,
 				std::vector<double> &logAcceptanceRatioForAllMixtures); // Depends on RFPCountColumn
 		virtual void calculateLogLikelihoodRatioForHyperParameters(Genome &genome, unsigned iteration,
-				std::vector <double> &logProbabilityRatio);
+				std::vector <double> &logProbabilityRatio); // Depends on RFPCountColumn
+		virtual void prepareForCodonSpecificParameterUpdate(Genome &genome); // Depends on RFPCountColumn
 
 
 		//Initialization and Restart Functions:
@@ -79,10 +107,13 @@ class PANSEModel: public Model
         virtual void updatePartitionFunctionTrace(unsigned sample);
 		virtual void updateSynthesisRateTrace(unsigned sample, unsigned i);
 		virtual void updateMixtureAssignmentTrace(unsigned sample, unsigned i);
+		virtual void updateSynthesisRateTraces(unsigned sample);
 		virtual void updateMixtureProbabilitiesTrace(unsigned sample);
 		virtual void updateCodonSpecificParameterTrace(unsigned sample, std::string codon);
 		virtual void updateHyperParameterTraces(unsigned sample);
 		virtual void updateTracesWithInitialValues(Genome &genome);
+		virtual bool flushTraces();
+		virtual bool hasTraceFileWriteFailed();
 
 
 		//Adaptive Width Functions:
@@ -115,10 +146,12 @@ class PANSEModel: public Model
 		virtual void simulateGenome(Genome &genome); // Depends on RFPCountColumn
 		virtual void printHyperParameters();
 		PANSEParameter* getParameter();
+		unsigned getRFPCountColumn();
 
 		void setParameter(PANSEParameter &_parameter);
 		virtual double calculateAllPriors();
 		virtual double getParameterForCategory(unsigned category, unsigned param, std::string codon, bool proposal);
+		double getParameterForCategory(unsigned category, unsigned param, unsigned codonIndex, bool proposal);
 
 		double UpperIncompleteGammaHelper(double s, double x);
 		double UpperIncompleteGamma(double s, double x);
@@ -134,10 +167,11 @@ class PANSEModel: public Model
         double prob_Y_g(double curralpha, int sample_size, double lambda_prime, double psi, double prevdelta);
         double prob_Y_g_log(double curralpha, int sample_size, double lambda_prime, double psi, double prevdelta);
 
-        double elongationUntilIndexApproximation1Probability(double alpha, double lambda, double v, bool proposed);
-        double elongationUntilIndexApproximation2Probability(double alpha, double lambda, double v, bool proposed);
-        double elongationUntilIndexApproximation1ProbabilityLog(double alpha, double lambda, double v, bool proposed);
-        double elongationUntilIndexApproximation2ProbabilityLog(double alpha, double lambda, double v, bool proposed);
+        double elongationUntilIndexApproximation1Probability(double alpha, double lambda, double v, double &sigmaSum1);
+        double elongationUntilIndexApproximation2Probability(double alpha, double lambda, double v, double &sigmaSum1,
+                double &sigmaSum2);
+        double elongationUntilIndexApproximation1ProbabilityLog(double alpha, double lambda, double v, double &sigmaSum1);
+        double elongationUntilIndexApproximation2ProbabilityLog(double alpha, double lambda, double v, double &sigmaSum2);
 
         //Psi-Phi Conversion Functions
         double psi2phi(double psi, double sigma);
@@ -84,6 +84,7 @@ class PANSEParameter: public Parameter {
 
 		//Other functions:
 		double getParameterForCategory(unsigned category, unsigned paramType, std::string codon, bool proposal);
+		double getParameterForCategory(unsigned category, unsigned paramType, unsigned codonIndex, bool proposal);
 
 
 
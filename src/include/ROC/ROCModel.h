@@ -7,15 +7,56 @@
 class ROCModel : public Model
 {
     private:
+		// current and proposed hyper parameters, see initHyperParameterValues
+		struct HyperParameterValues
+		{
+			std::vector <double> currentStdDevSynthesisRate;
+			std::vector <double> currentMphi;
+			std::vector <double> proposedStdDevSynthesisRate;
+			std::vector <double> proposedMphi;
+			std::vector <double> noiseOffset;
+			std::vector <double> noiseOffset_proposed;
+			std::vector <double> observedSynthesisNoise;
+		};
+
 		ROCParameter *parameter;
 		bool withPhi;
 		bool fix_sEpsilon;
-
-		double calculateLogLikelihoodPerAAPerGene(unsigned numCodons, int codonCount[], double mutation[], double selection[], double phiValue);
+		std::vector <unsigned> groupingAAIndex; // amino acid index (SequenceSummary::aaToIndex) of each grouping
+
+		// sufficient statistics for the codon specific parameter updates, see setSufficientStatisticsMode.
+		// Outer index is the amino acid index, then mixture element (* 6 + codon for the per codon sums).
+		bool useSufficientStatistics;
+		unsigned numPhiBins;
+		std::vector <std::vector <double>> sufficientStatisticCodonCount;
+		std::vector <std::vector <double>> sufficientStatisticCodonCountPhi;
+		std::vector <std::vector <std::vector <double>>> sufficientStatisticPhi; // phi of each gene (or bin) with the AA
+		std::vector <std::vector <std::vector <double>>> sufficientStatisticAACount; // AA count of each gene (or bin)
+
+		void calculateLogCodonProbabilityCoefficients(unsigned numCodons, double mutation[], double selection[],
+					double offset[], double slope[], bool inDenominator[], double &initialDenominator);
+		double calculateLogLikelihoodPerAAFromSufficientStatistics(unsigned numCodons, double mutation[],
+					double selection[], unsigned aaIndex, unsigned mixture);
+		void updateSufficientStatistics(Genome &genome);
+		void calculateLogLikelihoodPerAAForGeneBatch(unsigned numCodons, double mutation[], double selection[],
+					unsigned batchSize, const double phiValues[], const int codonCounts[], double logLikelihoods[]);
+		void calculateLogLikelihoodPerAAForGeneBlock(unsigned numCodons, const unsigned *codonCountsPerGene[],
+					unsigned blockStart, unsigned blockEnd, double mutation[], double selection[], double mutation_proposed[],
+					double selection_proposed[], double &likelihood, double &likelihood_proposed);
+		void calculateLogAcceptanceRatioForGrouping(std::string grouping, double likelihood, double likelihood_proposed,
+					std::vector<double> &logAcceptanceRatioForAllMixtures);
+		void calculateLogLikelihoodRatioInOnePass(Genome& genome, std::vector<std::vector<double>> &logAcceptanceRatioForAllGroupings,
+					bool withHyperParameters, std::vector <double> &logProbabilityRatio);
+		double initHyperParameterValues(HyperParameterValues &values);
+		void calculateHyperParameterTermsForGene(Genome &genome, unsigned gene, HyperParameterValues &values, double terms[]);
+		void sumHyperParameterTerms(Genome &genome, double jacobian, unsigned numTerms, const double hyperParameterTerms[],
+					std::vector <double> &logProbabilityRatio);
 		double calculateMutationPrior(std::string grouping, bool proposed = false); // TODO add to FONSE as well? // cedric
-		void obtainCodonCount(SequenceSummary *sequenceSummary, std::string curAA, int codonCount[]);
+		void obtainCodonCount(SequenceSummary *sequenceSummary, unsigned aaIndex, int codonCount[]);
 
     public:
+		static const unsigned geneBatchSize = 64u; // maximum number of genes evaluated together by calculateLogLikelihoodPerAAForGeneBatch
+
 		//Constructors & Destructors:
 		ROCModel(bool _withPhi = false, bool _fix_sEpsilon = false);
 		virtual ~ROCModel();
@@ -27,8 +68,15 @@ class ROCModel : public Model
 					double* logProbabilityRatio);
 		virtual void calculateLogLikelihoodRatioPerGroupingPerCategory(std::string grouping, Genome& genome,
 					std::vector<double> &logAcceptanceRatioForAllMixtures);
+		virtual void calculateLogLikelihoodRatioForAllGroupings(Genome& genome,
+					std::vector<std::vector<double>> &logAcceptanceRatioForAllGroupings);
+		virtual bool supportsSinglePassCodonSpecificUpdate();
 		virtual void calculateLogLikelihoodRatioForHyperParameters(Genome &genome, unsigned iteration,
 					std::vector <double> &logProbabilityRatio);
+		virtual bool supportsFusedGenomeTraversal();
+		virtual void calculateLogLikelihoodRatioForAllGroupingsAndHyperParameters(Genome &genome, unsigned iteration,
+					std::vector<std::vector<double>> &logAcceptanceRatioForAllGroupings,
+					std::vector <double> &logProbabilityRatio);
 
 
 		//Initialization and Restart Functions:
@@ -75,10 +123,13 @@ class ROCModel : public Model
 		virtual void updateStdDevSynthesisRateTrace(unsigned sample);
 		virtual void updateSynthesisRateTrace(unsigned sample, unsigned i) ;
 		virtual void updateMixtureAssignmentTrace(unsigned sample, unsigned i) ;
+		virtual void updateSynthesisRateTraces(unsigned sample);
 		virtual void updateMixtureProbabilitiesTrace(unsigned sample);
 		virtual void updateCodonSpecificParameterTrace(unsigned sample, std::string grouping);
 		virtual void updateHyperParameterTraces(unsigned sample);
 		virtual void updateTracesWithInitialValues(Genome &genome);
+		virtual bool flushTraces();
+		virtual bool hasTraceFileWriteFailed();
 
 
 
@@ -105,6 +156,8 @@ class ROCModel : public Model
 		virtual void setCategoryProbability(unsigned mixture, double value);
 
 		virtual void updateCodonSpecificParameter(std::string grouping);
+		virtual void prepareForCodonSpecificParameterUpdate(Genome &genome);
+		virtual void countSynthesisRateTraversal(unsigned numGenes);
 		virtual void updateGibbsSampledHyperParameters(Genome &genome);
 		virtual void updateAllHyperParameter();
 		virtual void updateHyperParameter(unsigned hp);
@@ -113,6 +166,7 @@ class ROCModel : public Model
 		virtual void printHyperParameters();
 		ROCParameter getParameter();
 		void setParameter(ROCParameter &_parameter);
+		void setSufficientStatisticsMode(bool _useSufficientStatistics, unsigned _numPhiBins = 0u);
 		virtual double calculateAllPriors();
 		void calculateCodonProbabilityVector(unsigned numCodons, double mutation[], double selection[], double phi, double codonProb[]);
 		void calculateLogCodonProbabilityVector(unsigned numCodons, double mutation[], double selection[], double phi, double codonProb[]);
@@ -124,6 +124,7 @@ class ROCParameter : public Parameter
 		//Other Functions:
 		void setNumObservedPhiSets(unsigned _phiGroupings);
 		void getParameterForCategory(unsigned category, unsigned parameter, std::string aa, bool proposal, double *returnValue);
+		void getParameterForCategory(unsigned category, unsigned parameter, unsigned aaIndex, bool proposal, double *returnValue);
 
 		void fixDM();
 		void fixDEta();
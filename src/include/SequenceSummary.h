@@ -26,9 +26,11 @@ class SequenceSummary
         // outer index is the codonID, size of 64 for number of codons
         // inner index is the position of each occurrence of the codonID specified.
 
-        std::vector <std::vector <int>> RFPCount;
-		// outer index is the RFPCount for the category specified via index
-		// inner index is number of position
+        std::vector <int> RFPCount;
+		// RFP counts of all categories in one contiguous block, order: category, position.
+		// Every category shares positionCodonID, so only the counts are stored per category.
+		std::vector <unsigned> RFPCountColumnOffset;
+		// start of each category in RFPCount, size number of categories + 1
 
 		std::vector <std::array <unsigned, 64>> sumRFPCount;
 		// outer index is the RFPCount for the category specified via index
@@ -71,7 +73,10 @@ class SequenceSummary
 		//RFP Functions (for PA and PANSE models) (All tested):
         //RFP Count has an inner vector indexed by position Sum RFP Count has an inner index of Codon Type
 		void initRFPCount(unsigned numCategories);
+		unsigned getNumRFPCountColumns() const;
 		std::vector <int> getRFPCount(unsigned RFPCountColumn = 0u);
+		const int *getRFPCountData(unsigned RFPCountColumn = 0u) const;
+		unsigned getRFPCountSize(unsigned RFPCountColumn = 0u) const;
 		int getSingleRFPCount(unsigned position, unsigned RFPCountColumn = 0u);
 		void setRFPCount(std::vector <int> arg, unsigned RFPCountColumn = 0u);
 		int getSumTotalRFPCount(unsigned RFPCountColumn = 0u);
@@ -87,6 +92,7 @@ class SequenceSummary
 
         //Poisitonal information about Codons
         std::vector <unsigned> getPositionCodonID(); //Used in PANSE for getting codon positions over gene
+        const std::vector <unsigned> &getPositionCodonIDReference() const; //Same without copying, for likelihood loops
         void setPositionCodonID(std::vector <unsigned> arg);
 
 		//Other Functions (All tested):
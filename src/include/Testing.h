@@ -9,6 +9,10 @@
 #include "base/Parameter.h"
 #include "CovarianceMatrix.h"
 #include "MCMCAlgorithm.h"
+#include "ROC/ROCModel.h"
+#include "base/LogRisingFactorialTable.h"
+#include "PANSE/PANSEModel.h"
+#include "FONSE/FONSEModel.h"
 
 
 int testUtility();
@@ -22,6 +26,12 @@ int testParameter(std::string testFileDir);
 int testCovarianceMatrix();
 //int testPAParameter(); //TODO: Rework or remove
 int testMCMCAlgorithm();
+int testROCModel(std::string testFileDir);
+int testLogRisingFactorialTable();
+int testPANSEModel();
+int testFONSEModel(std::string testFileDir);
+int testTraceFile(std::string outputDir);
+int testTrace();
 
 //Blank header
 #endif // Testing_H
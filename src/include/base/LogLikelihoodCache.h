@@ -0,0 +1,54 @@
+#ifndef LOGLIKELIHOODCACHE_H
+#define LOGLIKELIHOODCACHE_H
+
+
+#include <vector>
+
+
+/* LogLikelihoodCache
+ * Stores the per gene, per grouping log likelihood terms used in the synthesis rate update.
+ * Every (gene, mixture) pair owns two slots, one for the current and one for the proposed
+ * synthesis rate. A term stays valid as long as the phi value of its slot and the
+ * codon specific parameters of its grouping are unchanged. Accepting a synthesis rate
+ * proposal swaps the slots, accepting a codon specific parameter proposal bumps the
+ * version of the grouping and with it invalidates all terms of that grouping.
+ * The cache must be initialized outside of parallel regions. setCurrentPhi and setProposedPhi
+ * must not run concurrently for the same gene, the per grouping functions are safe to call
+ * concurrently as long as no two threads work on the same gene and grouping.
+*/
+class LogLikelihoodCache
+{
+	private:
+
+		unsigned numMixtures;
+		unsigned numGroupings;
+		std::vector <unsigned> groupingVersion; //order: grouping. Starts at 1, 0 marks an empty entry
+		std::vector <unsigned char> currentSlot; //order: gene, mixture
+		std::vector <double> slotPhi; //order: gene, mixture, slot
+		std::vector <double> logLikelihood; //order: gene, mixture, slot, grouping
+		std::vector <unsigned> version; //order: gene, mixture, slot, grouping
+
+
+	public:
+
+		//Constructors & Destructors:
+		explicit LogLikelihoodCache();
+		virtual ~LogLikelihoodCache();
+
+
+		//Initialization Functions:
+		void init(unsigned numGenes, unsigned _numMixtures, unsigned _numGroupings);
+		void clear();
+		bool hasEntry(unsigned gene, unsigned mixture);
+
+
+		//Update Functions:
+		void invalidateGrouping(unsigned grouping);
+		void setCurrentPhi(unsigned gene, unsigned mixture, double phi);
+		bool getCurrent(unsigned gene, unsigned mixture, unsigned grouping, double &value);
+		void setCurrent(unsigned gene, unsigned mixture, unsigned grouping, double value);
+		void setProposedPhi(unsigned gene, unsigned mixture, double phi);
+		void setProposed(unsigned gene, unsigned mixture, unsigned grouping, double value);
+};
+
+#endif // LOGLIKELIHOODCACHE_H
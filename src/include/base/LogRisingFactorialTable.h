@@ -0,0 +1,49 @@
+#ifndef LOGRISINGFACTORIALTABLE_H
+#define LOGRISINGFACTORIALTABLE_H
+
+
+#include <vector>
+#include <cmath>
+
+
+/* LogRisingFactorialTable
+ * Stores lgamma(alpha + n) - lgamma(alpha), the log of the rising factorial alpha (alpha + 1) ... (alpha + n - 1),
+ * for n = 0 ... maxCount, for the alpha values of each (category, codon) pair. This is the count dependent term of the
+ * negative binomial likelihood of the PA and PANSE models. Every pair owns two rows, so the current and the proposed
+ * alpha of a codon can be held at the same time. A row is filled with the same expression std::lgamma gives
+ * without the table, so looking up a value is exact.
+ * get never fails: counts beyond maxCount and alpha values without a row are calculated directly. update must be
+ * called outside of parallel regions, get is safe to call concurrently.
+*/
+class LogRisingFactorialTable
+{
+	private:
+
+		unsigned numCategories;
+		unsigned numCodons;
+		unsigned rowLength; // maxCount + 1
+		std::vector <double> rowAlpha; //order: category, codon, row. Negative marks an empty row
+		std::vector <unsigned char> lastUsedRow; //order: category, codon
+		std::vector <double> logRisingFactorial; //order: category, codon, row, count
+
+
+	public:
+
+		//Constructors & Destructors:
+		explicit LogRisingFactorialTable();
+		virtual ~LogRisingFactorialTable();
+
+
+		//Initialization Functions:
+		void init(unsigned _numCategories, unsigned _numCodons, unsigned maxCount);
+		void clear();
+		unsigned getMaxCount();
+
+
+		//Table Functions:
+		void update(unsigned category, unsigned codon, double alpha);
+		double get(unsigned category, unsigned codon, double alpha, unsigned count) const;
+		static double calculate(double alpha, unsigned count);
+};
+
+#endif // LOGRISINGFACTORIALTABLE_H
@@ -4,6 +4,7 @@
 
 #include "../Genome.h"
 #include "Parameter.h"
+#include "LogLikelihoodCache.h"
 
 class Model
 {
@@ -24,8 +25,15 @@ class Model
 					double* logProbabilityRatio) = 0;
         virtual void calculateLogLikelihoodRatioPerGroupingPerCategory(std::string grouping, Genome& genome,
         			std::vector<double> &logAcceptanceRatioForAllMixtures) = 0;
+		virtual void calculateLogLikelihoodRatioForAllGroupings(Genome& genome,
+					std::vector<std::vector<double>> &logAcceptanceRatioForAllGroupings);
+		virtual bool supportsSinglePassCodonSpecificUpdate();
 		virtual void calculateLogLikelihoodRatioForHyperParameters(Genome &genome, unsigned iteration,
 					std::vector <double> &logProbabilityRatio) = 0;
+		virtual bool supportsFusedGenomeTraversal();
+		virtual void calculateLogLikelihoodRatioForAllGroupingsAndHyperParameters(Genome &genome, unsigned iteration,
+					std::vector<std::vector<double>> &logAcceptanceRatioForAllGroupings,
+					std::vector <double> &logProbabilityRatio);
 
 		virtual double calculateAllPriors() = 0;
 
@@ -76,10 +84,13 @@ class Model
 		virtual void updateStdDevSynthesisRateTrace(unsigned sample) = 0;
 		virtual void updateSynthesisRateTrace(unsigned sample, unsigned i) = 0;
 		virtual void updateMixtureAssignmentTrace(unsigned sample, unsigned i) = 0;
+		virtual void updateSynthesisRateTraces(unsigned sample) = 0;
 		virtual void updateMixtureProbabilitiesTrace(unsigned sample) = 0;
 		virtual void updateCodonSpecificParameterTrace(unsigned sample, std::string grouping) = 0;
 		virtual void updateHyperParameterTraces(unsigned sample) = 0;
 		virtual void updateTracesWithInitialValues(Genome &genome) = 0;
+		virtual bool flushTraces() = 0; // false if the trace file could not be written
+		virtual bool hasTraceFileWriteFailed() = 0;
 
 		//Adaptive Width Functions:
 		virtual void adaptStdDevSynthesisRateProposalWidth(unsigned adaptiveWidth, bool adapt) = 0;
@@ -105,6 +116,7 @@ class Model
 		virtual void setCategoryProbability(unsigned mixture, double value) = 0;
 
 		virtual void updateCodonSpecificParameter(std::string grouping) = 0;
+		virtual void prepareForCodonSpecificParameterUpdate(Genome &genome);
 		virtual void updateGibbsSampledHyperParameters(Genome &genome) = 0;
 		virtual void updateAllHyperParameter() = 0;
 		virtual void updateHyperParameter(unsigned hp) = 0;
@@ -112,7 +124,27 @@ class Model
 		virtual void simulateGenome(Genome &genome) =0;
 		virtual void printHyperParameters() = 0;
 
+		void setLogLikelihoodCacheMode(bool _useLogLikelihoodCache);
+
+		//Genome Traversal Counters:
+		virtual void countSynthesisRateTraversal(unsigned numGenes);
+		void resetGenomeTraversalCounters();
+		unsigned getNumGenomeTraversals();
+		double getGenomeTraversalBytes();
+
 	protected:
+		// per gene and grouping log likelihood terms of calculateLogLikelihoodRatioPerGene, see setLogLikelihoodCacheMode.
+		bool useLogLikelihoodCache;
+		LogLikelihoodCache logLikelihoodCache;
+
+		void initLogLikelihoodCache(unsigned numGenes);
+		void invalidateLogLikelihoodCache(std::string grouping);
+
+		// number of passes over the genome and estimated bytes of gene data read since the last reset
+		unsigned numGenomeTraversals;
+		double genomeTraversalBytes;
+
+		void countGenomeTraversal(unsigned numGenes, unsigned bytesPerGene);
 };
 
 #endif // MODEL_H
@@ -138,7 +138,15 @@ class Parameter {
 		void updateStdDevSynthesisRateTrace(unsigned sample);
 		void updateSynthesisRateTrace(unsigned sample, unsigned geneIndex);
 		void updateMixtureAssignmentTrace(unsigned sample, unsigned geneIndex);
+		void updateSynthesisRateTraces(unsigned sample);
 		void updateMixtureProbabilitiesTrace(unsigned samples);
+		void setTraceFileMode(std::string filename, unsigned windowSamples);
+		bool flushTraces();
+		bool hasTraceFileWriteFailed();
+		bool loadTraceFile(std::string filename);
+		void setTraceLayout(std::string layout);
+		void setMixtureAssignmentRunLengthEncoding(bool runLength);
+		void setActiveCategorySynthesisRateTrace(bool activeCategoryOnly);
 
 
 		//Adaptive Width Functions: TODO: test
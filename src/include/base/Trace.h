@@ -3,6 +3,7 @@
 
 
 #include "../mixtureDefinition.h"
+#include "TraceFile.h"
 
 
 #include <iostream>
@@ -23,13 +24,31 @@ class Trace {
         //however, it will need to be changed at some point when there are some adjustments to hyper parameter acceptance/rejection
 		std::vector<std::vector<std::vector<double>>>synthesisRateAcceptanceRateTrace; //order: expressionCategory, gene, sample
 		std::vector<std::vector<double>> codonSpecificAcceptanceRateTrace;//order: codon, sample
-		std::vector<std::vector<std::vector<float>>> synthesisRateTrace;//order: expression category, gene, samples
-		std::vector<std::vector<unsigned>> mixtureAssignmentTrace;//order: numGenes, samples
+		std::vector<float> synthesisRateTrace; //order: stored category, gene, sample (gene major) or sample, stored category, gene (sample major)
+		std::vector<unsigned> mixtureAssignmentTrace; //packed, mixtureAssignmentBits per value. order: gene, sample (gene major) or sample, gene (sample major)
+		std::vector<std::vector<unsigned>> mixtureAssignmentRuns; //order: gene, (mixture element, end of run) pairs. Replaces mixtureAssignmentTrace when not empty
 		std::vector<std::vector<double>> mixtureProbabilitiesTrace;//order: numMixtures, samples
 		std::vector<std::vector<std::vector<std::vector<float>>>> codonSpecificParameterTrace; //order: paramType, category, numParam, samples
 		//std::vector<std::vector<std::vector<double>>> codonSpecificParameterTraceTwo; //order: category, numParam, samples
 		std::vector<mixtureDefinition> *categories;
 
+		// shape and layout of synthesisRateTrace and mixtureAssignmentTrace, see setTraceLayout
+		unsigned numTraceExpressionCategories;
+		unsigned numTraceGenes;
+		unsigned synthesisRateTraceSamples; //1 if synthesis rates are not estimated
+		unsigned mixtureAssignmentTraceSamples;
+		bool sampleMajorTraceLayout;
+		unsigned mixtureAssignmentBits; //1, 2, 4, 8, 16 or 32, enough for all mixture elements
+		bool runLengthMixtureAssignmentTrace; //see setMixtureAssignmentRunLengthEncoding
+		bool activeCategorySynthesisRateTrace; //the stored trace has one category holding the assigned category
+		bool activeCategorySynthesisRateTraceMode; //requested for the next run, see setActiveCategorySynthesisRateTrace
+
+		// streaming of the synthesis rate and mixture assignment traces to a file, see setTraceFileMode. While the file
+		// is open, synthesisRateTrace and mixtureAssignmentTrace are empty.
+		std::string traceFileName;
+		unsigned traceFileWindowSamples;
+		TraceFile traceFile; //columns: synthesis rate of each stored category and gene, then mixture assignment of each gene
+
 
 		//ROC Trace:
 		std::vector<std::vector <double>> synthesisOffsetTrace;
@@ -53,9 +72,25 @@ class Trace {
 		void initStdDevSynthesisRateTrace(unsigned numSelectionCategories, unsigned samples);
 		void initSynthesisRateAcceptanceRateTrace(unsigned num_genes, unsigned numExpressionCategories);
 		void initSynthesisRateTrace(unsigned samples, unsigned num_genes, unsigned numExpressionCategories,std::vector<double> init_phi,bool estimateSynthesisRate = true);
-		void initMixtureAssignmentTrace(unsigned samples, unsigned num_genes,std::vector<unsigned> init_mix_assign);
+		void initMixtureAssignmentTrace(unsigned samples, unsigned num_genes,std::vector<unsigned> init_mix_assign, unsigned numMixtures);
 		void initMixtureProbabilitiesTrace(unsigned samples, unsigned numMixtures);
 		void initCodonSpecificParameterTrace(unsigned samples, unsigned numMutationCategories, unsigned numParam, unsigned paramType);
+		bool initTraceFile(unsigned samples, unsigned num_genes, unsigned numExpressionCategories,
+			std::vector<mixtureDefinition> &_categories, std::vector<double> init_phi, std::vector<unsigned> init_mix_assign);
+		void closeTraceFile();
+		std::vector<float> getSynthesisRateTraceByCategoryForGene(unsigned category, unsigned geneIndex);
+		std::vector<float> getStoredSynthesisRateTraceForGene(unsigned storedCategory, unsigned geneIndex);
+		std::vector<std::vector<std::vector<float>>> getStoredSynthesisRateTrace();
+		unsigned getNumStoredSynthesisRateCategories();
+		unsigned getSynthesisRateTraceLength();
+		std::size_t getSynthesisRateTraceIndex(unsigned category, unsigned geneIndex, unsigned sample);
+		std::size_t getMixtureAssignmentTraceIndex(unsigned geneIndex, unsigned sample);
+		void storeSynthesisRateTrace(std::vector<std::vector<std::vector<float>>> &_synthesisRateTrace);
+		void storeMixtureAssignmentTrace(std::vector<std::vector<unsigned>> &_mixtureAssignmentTrace, unsigned numMixtures = 1u);
+		unsigned getMixtureAssignmentBits(unsigned numMixtures);
+		unsigned getPackedMixtureAssignment(std::size_t index);
+		void setPackedMixtureAssignment(std::size_t index, unsigned value);
+		void decodeMixtureAssignmentRuns();
 
 
 		//ROC Specific:
@@ -101,6 +136,26 @@ class Trace {
                         std::vector<unsigned> init_mix_assign, bool estimateSynthesisRate = true);
 
 
+		//Trace File Functions:
+		void setTraceFileMode(std::string filename, unsigned windowSamples = 100u);
+		std::string getTraceFileName();
+		bool flushTraceFile();
+		bool hasTraceFileWriteFailed();
+		bool loadTraceFile(std::string filename, unsigned numGenes, std::vector<mixtureDefinition> &_categories);
+		unsigned getTraceFileNumSamplesWritten();
+
+
+		//Trace Layout Functions:
+		void setTraceLayout(std::string layout);
+		std::string getTraceLayout();
+		void setMixtureAssignmentRunLengthEncoding(bool runLength);
+		void setActiveCategorySynthesisRateTrace(bool activeCategoryOnly);
+		bool getActiveCategorySynthesisRateTrace();
+		std::size_t getSynthesisRateTraceBytes();
+		void encodeMixtureAssignmentTrace();
+		std::size_t getMixtureAssignmentTraceBytes();
+
+
 		//------------------------------//
 		//------ Getter Functions ------//
 		//------------------------------//
@@ -114,8 +169,10 @@ class Trace {
         std::vector<float> getSynthesisRateTraceForGene(unsigned geneIndex); //will build the trace appropriately based on what cat you are in
         std::vector<float> getSynthesisRateTraceByMixtureElementForGene(unsigned mixtureElement, unsigned geneIndex);
         std::vector<unsigned> getMixtureAssignmentTraceForGene(unsigned geneIndex);
+        unsigned getMixtureAssignment(unsigned geneIndex, unsigned sample);
         std::vector<double> getMixtureProbabilitiesTraceForMixture(unsigned mixtureIndex);
         std::vector<std::vector<unsigned>> getMixtureAssignmentTrace();
+        std::vector<unsigned> countMixtureAssignmentsForGene(unsigned geneIndex, unsigned first, unsigned last, unsigned numMixtures);
         std::vector<std::vector<double>> getMixtureProbabilitiesTrace();
         std::vector<std::vector<double>> getCodonSpecificAcceptanceRateTrace();
         unsigned getSynthesisRateCategory(unsigned mixtureElement);
@@ -149,7 +206,9 @@ class Trace {
         void updateSynthesisRateAcceptanceRateTrace(unsigned category, unsigned geneIndex, double acceptanceLevel);
         void updateCodonSpecificAcceptanceRateTrace(unsigned codonIndex, double acceptanceLevel);
         void updateSynthesisRateTrace(unsigned sample, unsigned geneIndex, std::vector<std::vector <double>> &currentExpressionLevel);
+        void updateSynthesisRateTrace(unsigned sample, std::vector<std::vector <double>> &currentExpressionLevel);
         void updateMixtureAssignmentTrace(unsigned sample, unsigned geneIndex, unsigned value);
+        void updateMixtureAssignmentTrace(unsigned sample, std::vector<unsigned> &mixtureAssignment);
         void updateMixtureProbabilitiesTrace(unsigned samples, std::vector<double> &categoryProbabilities);
 
 
@@ -0,0 +1,89 @@
+#ifndef TRACEFILE_H
+#define TRACEFILE_H
+
+
+#include "../Utility.h"
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstddef>
+
+
+/* TraceFile
+ * Append-only binary file holding traces as columns of float values, one value per column and sample. The samples
+ * are collected in an in-memory window of windowSamples samples for all columns, and the window is written to the end
+ * of the file as one chunk when a sample beyond the window arrives or flush is called. Within a chunk the values are
+ * stored column by column, so a column is read back with one contiguous read per chunk. Samples that were never
+ * written hold the fill value of their column.
+ * File layout (native byte order): the characters "ACTF", then the unsigned values version, number of columns, number
+ * of samples, window size, number of samples written (one past the last sample set) and number of metadata values,
+ * then the metadata values, then the fill value of each column, then the chunks. The last chunk is always stored in
+ * full, so the file size only depends on the number of chunks written.
+ * The file is opened for every write or read, so copies of a TraceFile can read the same file. Only one copy should
+ * write to it.
+ * A finished file can be opened read only with openForReading. It is then memory mapped (where available), so columns
+ * are copied straight from the page cache and any number of readers can share the file.
+*/
+class TraceFile
+{
+	private:
+
+		std::string filename;
+		unsigned numColumns;
+		unsigned numSamples;
+		unsigned windowSamples;
+		unsigned numSamplesWritten;
+		unsigned numChunksInFile;
+		unsigned windowChunk; // index of the chunk held in the window
+		std::vector <float> fillValues; //order: column
+		std::vector <float> window; //order: column, sample within the window
+		std::vector <unsigned> metadata;
+
+		bool readOnly;
+		bool writeFailed; // sticky, see hasWriteFailed
+		char *mappedData; // whole file, only set for read only files on systems with mmap
+		std::size_t mappedSize;
+
+		std::streamoff getDataOffset();
+		void resetWindow(unsigned chunk);
+		bool writeChunks();
+		bool mapFile();
+		void unmapFile();
+
+
+	public:
+
+		static const unsigned fileVersion = 2u;
+
+		//Constructors & Destructors:
+		explicit TraceFile();
+		TraceFile(const TraceFile &other);
+		TraceFile& operator=(const TraceFile &rhs);
+		virtual ~TraceFile();
+
+
+		//Initialization Functions:
+		bool init(std::string _filename, unsigned _numSamples, unsigned _windowSamples, std::vector <float> _fillValues,
+					std::vector <unsigned> _metadata);
+		bool openForReading(std::string _filename);
+		void clear();
+		bool isOpen();
+		bool isReadOnly();
+		std::string getFilename();
+		unsigned getNumColumns();
+		unsigned getNumSamples();
+		unsigned getNumSamplesWritten();
+		unsigned getWindowSamples();
+		std::vector <unsigned> getMetadata();
+
+
+		//Value Functions:
+		bool setValue(unsigned column, unsigned sample, float value);
+		float getValue(unsigned column, unsigned sample);
+		std::vector <float> getColumn(unsigned column);
+		bool flush();
+		bool hasWriteFailed();
+};
+
+#endif // TRACEFILE_H
@@ -1324,3 +1324,67 @@ int main()
 }
 
 #endif // Denizhan
+
+#ifdef BENCHMARK
+#include "include/Benchmark.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* Parses a comma separated list of numbers, e.g. "1000,10000,50000". */
+std::vector<unsigned> parseBenchmarkSizes(std::string list)
+{
+	std::vector<unsigned> values;
+	std::istringstream iss(list);
+	std::string item;
+	while (std::getline(iss, item, ','))
+		values.push_back((unsigned)std::atoi(item.c_str()));
+	return values;
+}
+
+int main(int argc, char *argv[])
+{
+	std::vector<std::string> modelNames = {"ROC", "FONSE", "PA", "PANSE"};
+	std::vector<unsigned> genomeSizes = {1000u, 10000u, 50000u};
+	std::vector<unsigned> geneLengths = {300u};
+	unsigned maxThreads = 1u;
+	unsigned iterations = 10u;
+	std::string outputFile = "benchmark.csv";
+
+#ifdef _OPENMP
+	maxThreads = (unsigned)omp_get_num_procs();
+#endif
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		std::string option = argv[i];
+		std::string value = argv[i + 1];
+		if (option == "-m")
+		{
+			modelNames.clear();
+			std::istringstream iss(value);
+			std::string item;
+			while (std::getline(iss, item, ','))
+				modelNames.push_back(item);
+		}
+		else if (option == "-g")
+			genomeSizes = parseBenchmarkSizes(value);
+		else if (option == "-l")
+			geneLengths = parseBenchmarkSizes(value);
+		else if (option == "-t")
+			maxThreads = (unsigned)std::atoi(value.c_str());
+		else if (option == "-i")
+			iterations = (unsigned)std::atoi(value.c_str());
+		else if (option == "-o")
+			outputFile = value;
+		else
+		{
+			my_printError("Unknown option %. Usage: % [-m ROC,FONSE,PA,PANSE] [-g 1000,10000,50000] [-l 300,3000]", option, argv[0]);
+			my_printError(" [-t maxThreads] [-i iterations] [-o results.csv]\n");
+			return 1;
+		}
+	}
+
+	return runBenchmarks(modelNames, genomeSizes, geneLengths, maxThreads, iterations, outputFile);
+}
+#endif // BENCHMARK